@@ -0,0 +1,104 @@
+#include "cml/bvh.h"
+#include "cml/parallel.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Traces random rays into a random triangle soup and reports build time and Mrays/s
+
+namespace
+{
+struct lcg
+{
+	std::uint32_t state = 12345;
+	float next ()
+	{
+		state = state * 1664525u + 1013904223u;
+		return static_cast<float> (state >> 8) * (1.f / 16777216.f);
+	}
+};
+
+double seconds_since (std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+}
+
+template <int W>
+void run (char const* name, cml::triangle_soa const& tris, std::vector<cml::rayf> const& rays, unsigned threads)
+{
+	typename cml::bvh<W>::build_settings settings;
+	settings.threads = threads;
+	cml::bvh<W> tree;
+	auto start = std::chrono::steady_clock::now ();
+	tree.build (tris, settings);
+	double build_time = seconds_since (start);
+
+	std::vector<cml::ray_hit> hits (rays.size ());
+	start = std::chrono::steady_clock::now ();
+	cml::parallel_for (
+	    rays.size (),
+	    1024,
+	    [&] (std::size_t begin, std::size_t end) {
+		    for (std::size_t i = begin; i < end; i++)
+			    hits[i] = tree.intersect (rays[i], tris, 1e30f);
+	    },
+	    threads);
+	double nearest_time = seconds_since (start);
+
+	std::vector<std::uint8_t> blocked (rays.size ());
+	start = std::chrono::steady_clock::now ();
+	cml::parallel_for (
+	    rays.size (),
+	    1024,
+	    [&] (std::size_t begin, std::size_t end) {
+		    for (std::size_t i = begin; i < end; i++)
+			    blocked[i] = tree.occluded (rays[i], tris, 1e30f);
+	    },
+	    threads);
+	double any_time = seconds_since (start);
+
+	std::size_t hit_count = 0;
+	for (auto const& h : hits)
+		hit_count += h.prim >= 0;
+	double mrays = static_cast<double> (rays.size ()) * 1e-6;
+	std::printf ("%s threads %u: build %.1f ms, %zu nodes, nearest %.2f Mrays/s, any hit %.2f Mrays/s, %zu hits\n",
+	    name,
+	    threads,
+	    build_time * 1e3,
+	    tree.nodes.size (),
+	    mrays / nearest_time,
+	    mrays / any_time,
+	    hit_count);
+}
+} // namespace
+
+int main ()
+{
+	lcg rng;
+	cml::triangle_soa tris;
+	std::size_t const tri_count = 200000;
+	tris.reserve (tri_count);
+	for (std::size_t i = 0; i < tri_count; i++)
+	{
+		cml::vec3<float> p (rng.next () * 100.f, rng.next () * 100.f, rng.next () * 100.f);
+		cml::vec3<float> a (rng.next () - 0.5f, rng.next () - 0.5f, rng.next () - 0.5f);
+		cml::vec3<float> b (rng.next () - 0.5f, rng.next () - 0.5f, rng.next () - 0.5f);
+		tris.add (p, p + a, p + b);
+	}
+
+	std::vector<cml::rayf> rays (1000000);
+	for (auto& r : rays)
+	{
+		cml::vec3<float> o (rng.next () * 100.f, rng.next () * 100.f, rng.next () * 100.f);
+		cml::vec3<float> d (rng.next () - 0.5f, rng.next () - 0.5f, rng.next () - 0.5f);
+		r = cml::rayf (o, cml::normalize (d));
+	}
+
+	std::printf ("%zu triangles, %zu rays\n", tris.size (), rays.size ());
+	run<4> ("bvh4", tris, rays, 1);
+	run<8> ("bvh8", tris, rays, 1);
+	run<4> ("bvh4", tris, rays, cml::hardware_threads ());
+	run<8> ("bvh8", tris, rays, cml::hardware_threads ());
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <limits>
+
+#include "vec3.h"
+
+namespace cml
+{
+
+// Axis aligned bounding box. Default constructed boxes are empty (inverted)
+// so expanding one by any point or box gives a box around exactly that.
+template <typename T = float> class aabb
+{
+	public:
+	vec3<T> min = vec3<T> (std::numeric_limits<T>::max ());
+	vec3<T> max = vec3<T> (std::numeric_limits<T>::lowest ());
+
+	constexpr aabb () noexcept {}
+
+	constexpr aabb (vec3<T> const& min, vec3<T> const& max) noexcept : min (min), max (max) {}
+
+	bool empty () const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+	void expand (vec3<T> const& point)
+	{
+		min = cml::min (min, point);
+		max = cml::max (max, point);
+	}
+
+	void expand (aabb<T> const& box)
+	{
+		min = cml::min (min, box.min);
+		max = cml::max (max, box.max);
+	}
+
+	vec3<T> center () const { return (min + max) * static_cast<T> (0.5); }
+
+	vec3<T> extent () const { return max - min; }
+
+	// Index of the longest axis
+	int major_axis () const
+	{
+		vec3<T> e = extent ();
+		return e.x > e.y ? (e.x > e.z ? 0 : 2) : (e.y > e.z ? 1 : 2);
+	}
+
+	T surface_area () const
+	{
+		if (empty ()) return 0;
+		vec3<T> e = extent ();
+		return static_cast<T> (2) * (e.x * e.y + e.y * e.z + e.z * e.x);
+	}
+
+	bool contains (vec3<T> const& point) const
+	{
+		return point.x >= min.x && point.y >= min.y && point.z >= min.z && point.x <= max.x &&
+		       point.y <= max.y && point.z <= max.z;
+	}
+
+	bool overlaps (aabb<T> const& box) const
+	{
+		return min.x <= box.max.x && max.x >= box.min.x && min.y <= box.max.y && max.y >= box.min.y &&
+		       min.z <= box.max.z && max.z >= box.min.z;
+	}
+
+	// Squared distance from point to the box, zero inside
+	T distance_sqrt (vec3<T> const& point) const
+	{
+		vec3<T> d = cml::max (cml::max (min - point, point - max), vec3<T> (0));
+		return d.mag_sqrt ();
+	}
+};
+
+template <typename T> aabb<T> merge (aabb<T> a, aabb<T> const& b)
+{
+	a.expand (b);
+	return a;
+}
+
+using aabbf = aabb<float>;
+using aabbd = aabb<double>;
+
+} // namespace cml
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/*
+Allocators for large arrays of math types.
+
+mat4 and the vector types are over aligned, so they need an allocator that honours
+that alignment. aligned_vector<T> always starts on a cache line (or the type's
+alignment, whichever is larger).
+
+frame_arena is a bump allocator meant for per frame temporaries: allocate freely,
+then reset () once at the end of the frame. Nothing is freed individually.
+
+pool<T> hands out fixed size slots for objects which are created and destroyed
+independently, without going to the heap.
+
+Both can optionally be backed by huge pages, which cuts TLB misses on big batches.
+*/
+
+namespace cml
+{
+
+constexpr std::size_t cache_line_size = 64;
+
+namespace detail
+{
+constexpr std::size_t page_size = 4096;
+constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+constexpr std::size_t align_up (std::size_t value, std::size_t align)
+{
+	return (value + align - 1) & ~(align - 1);
+}
+
+constexpr bool is_pow2 (std::size_t value) { return value != 0 && (value & (value - 1)) == 0; }
+
+// Owning block of page aligned memory
+class page_block
+{
+	public:
+	page_block () noexcept {}
+
+	page_block (std::size_t size, bool huge_pages)
+	{
+		if (size == 0) return;
+#if defined(__linux__)
+		size = align_up (size, huge_pages ? huge_page_size : page_size);
+		void* mem = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mem == MAP_FAILED) throw std::bad_alloc ();
+#if defined(MADV_HUGEPAGE)
+		// only a hint, transparent huge pages may be disabled on the system
+		if (huge_pages) madvise (mem, size, MADV_HUGEPAGE);
+#endif
+		mapped = true;
+#else
+		(void)huge_pages;
+		size = align_up (size, page_size);
+		void* mem = ::operator new (size, std::align_val_t{ page_size });
+#endif
+		memory = static_cast<std::byte*> (mem);
+		length = size;
+	}
+
+	~page_block () { release (); }
+
+	page_block (page_block const&) = delete;
+	page_block& operator= (page_block const&) = delete;
+
+	page_block (page_block&& other) noexcept
+	: memory (std::exchange (other.memory, nullptr)),
+	  length (std::exchange (other.length, 0)),
+	  mapped (other.mapped)
+	{
+	}
+
+	page_block& operator= (page_block&& other) noexcept
+	{
+		if (this != &other)
+		{
+			release ();
+			memory = std::exchange (other.memory, nullptr);
+			length = std::exchange (other.length, 0);
+			mapped = other.mapped;
+		}
+		return *this;
+	}
+
+	std::byte* data () const { return memory; }
+	std::size_t size () const { return length; }
+
+	private:
+	void release () noexcept
+	{
+		if (memory == nullptr) return;
+#if defined(__linux__)
+		if (mapped) munmap (memory, length);
+#else
+		::operator delete (memory, std::align_val_t{ page_size });
+#endif
+		memory = nullptr;
+		length = 0;
+	}
+
+	std::byte* memory = nullptr;
+	std::size_t length = 0;
+	bool mapped = false;
+};
+} // namespace detail
+
+// ALIGNED ALLOCATOR
+
+template <typename T, std::size_t Align = (alignof (T) > cache_line_size ? alignof (T) : cache_line_size)>
+class aligned_allocator
+{
+	static_assert (detail::is_pow2 (Align) && Align >= alignof (T), "invalid alignment");
+
+	public:
+	using value_type = T;
+	static constexpr std::size_t alignment = Align;
+
+	template <typename U> struct rebind
+	{
+		using other = aligned_allocator<U, (alignof (U) > Align ? alignof (U) : Align)>;
+	};
+
+	constexpr aligned_allocator () noexcept {}
+
+	template <typename U, std::size_t A> constexpr aligned_allocator (aligned_allocator<U, A> const&) noexcept
+	{
+	}
+
+	T* allocate (std::size_t count)
+	{
+		if (count > std::numeric_limits<std::size_t>::max () / sizeof (T)) throw std::bad_array_new_length ();
+		return static_cast<T*> (::operator new (count * sizeof (T), std::align_val_t{ Align }));
+	}
+
+	void deallocate (T* ptr, std::size_t) noexcept { ::operator delete (ptr, std::align_val_t{ Align }); }
+};
+
+template <typename T, std::size_t A, typename U, std::size_t B>
+constexpr bool operator== (aligned_allocator<T, A> const&, aligned_allocator<U, B> const&)
+{
+	return A == B;
+}
+template <typename T, std::size_t A, typename U, std::size_t B>
+constexpr bool operator!= (aligned_allocator<T, A> const& a, aligned_allocator<U, B> const& b)
+{
+	return !(a == b);
+}
+
+template <typename T> using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+// FRAME ARENA
+
+class frame_arena
+{
+	public:
+	// Position in the arena, used to rewind to an earlier point
+	using marker = std::size_t;
+
+	frame_arena () noexcept {}
+
+	explicit frame_arena (std::size_t capacity, bool huge_pages = false)
+	: block (capacity, huge_pages)
+	{
+	}
+
+	frame_arena (frame_arena&& other) noexcept
+	: block (std::move (other.block)), offset (std::exchange (other.offset, 0))
+	{
+	}
+
+	frame_arena& operator= (frame_arena&& other) noexcept
+	{
+		block = std::move (other.block);
+		offset = std::exchange (other.offset, 0);
+		return *this;
+	}
+
+	// Returns uninitialized memory, throws std::bad_alloc when the arena is full
+	void* allocate (std::size_t size, std::size_t align = cache_line_size)
+	{
+		assert (detail::is_pow2 (align));
+		std::size_t start = detail::align_up (offset, align);
+		if (start > block.size () || size > block.size () - start) throw std::bad_alloc ();
+		offset = start + size;
+		return block.data () + start;
+	}
+
+	// Returns uninitialized storage for count elements of T
+	template <typename T> T* allocate (std::size_t count)
+	{
+		if (count > std::numeric_limits<std::size_t>::max () / sizeof (T)) throw std::bad_alloc ();
+		std::size_t align = alignof (T) > cache_line_size ? alignof (T) : cache_line_size;
+		return static_cast<T*> (allocate (count * sizeof (T), align));
+	}
+
+	marker mark () const { return offset; }
+
+	// Frees everything allocated after the marker was taken
+	void rewind (marker m)
+	{
+		assert (m <= offset);
+		offset = m;
+	}
+
+	// Frees everything, call once per frame
+	void reset () { offset = 0; }
+
+	std::size_t used () const { return offset; }
+	std::size_t capacity () const { return block.size (); }
+
+	private:
+	detail::page_block block;
+	std::size_t offset = 0;
+};
+
+// Standard allocator adapter so containers can live in a frame_arena.
+// Deallocation is a no-op, memory comes back when the arena is reset.
+template <typename T> class arena_allocator
+{
+	public:
+	using value_type = T;
+
+	arena_allocator (frame_arena& arena) noexcept : arena (&arena) {}
+
+	template <typename U> arena_allocator (arena_allocator<U> const& other) noexcept
+	: arena (other.arena)
+	{
+	}
+
+	T* allocate (std::size_t count) { return arena->allocate<T> (count); }
+
+	void deallocate (T*, std::size_t) noexcept {}
+
+	frame_arena* arena;
+};
+
+template <typename T, typename U>
+bool operator== (arena_allocator<T> const& a, arena_allocator<U> const& b)
+{
+	return a.arena == b.arena;
+}
+template <typename T, typename U>
+bool operator!= (arena_allocator<T> const& a, arena_allocator<U> const& b)
+{
+	return !(a == b);
+}
+
+template <typename T> using arena_vector = std::vector<T, arena_allocator<T>>;
+
+// POOL
+
+// Fixed capacity pool of equally sized slots for T
+template <typename T> class pool
+{
+	union slot
+	{
+		slot* next;
+		alignas (T) std::byte storage[sizeof (T)];
+	};
+
+	public:
+	explicit pool (std::size_t capacity, bool huge_pages = false)
+	: block (bytes_for (capacity), huge_pages), slot_count (capacity)
+	{
+	}
+
+	pool (pool&& other) noexcept
+	: block (std::move (other.block)),
+	  free_list (std::exchange (other.free_list, nullptr)),
+	  slot_count (std::exchange (other.slot_count, 0)),
+	  high_water (std::exchange (other.high_water, 0)),
+	  live (std::exchange (other.live, 0))
+	{
+	}
+
+	pool& operator= (pool&& other) noexcept
+	{
+		block = std::move (other.block);
+		free_list = std::exchange (other.free_list, nullptr);
+		slot_count = std::exchange (other.slot_count, 0);
+		high_water = std::exchange (other.high_water, 0);
+		live = std::exchange (other.live, 0);
+		return *this;
+	}
+
+	// Returns uninitialized storage for one T, throws std::bad_alloc when the pool is full
+	T* allocate ()
+	{
+		if (free_list != nullptr)
+		{
+			slot* s = free_list;
+			free_list = s->next;
+			live++;
+			return reinterpret_cast<T*> (s->storage);
+		}
+		if (high_water == slot_count) throw std::bad_alloc ();
+		slot* s = slots () + high_water++;
+		live++;
+		return reinterpret_cast<T*> (s->storage);
+	}
+
+	void deallocate (T* ptr) noexcept
+	{
+		assert (owns (ptr));
+		slot* s = reinterpret_cast<slot*> (ptr);
+		s->next = free_list;
+		free_list = s;
+		live--;
+	}
+
+	template <typename... Args> T* create (Args&&... args)
+	{
+		return new (allocate ()) T (std::forward<Args> (args)...);
+	}
+
+	void destroy (T* ptr)
+	{
+		ptr->~T ();
+		deallocate (ptr);
+	}
+
+	// Releases every slot at once, destructors are not run
+	void reset ()
+	{
+		free_list = nullptr;
+		high_water = 0;
+		live = 0;
+	}
+
+	bool owns (T const* ptr) const
+	{
+		auto p = reinterpret_cast<std::byte const*> (ptr);
+		return p >= block.data () && p < block.data () + slot_count * sizeof (slot);
+	}
+
+	std::size_t size () const { return live; }
+	std::size_t capacity () const { return slot_count; }
+
+	private:
+	static std::size_t bytes_for (std::size_t capacity)
+	{
+		if (capacity > std::numeric_limits<std::size_t>::max () / sizeof (slot))
+			throw std::bad_alloc ();
+		return capacity * sizeof (slot);
+	}
+
+	slot* slots () const { return reinterpret_cast<slot*> (block.data ()); }
+
+	detail::page_block block;
+	slot* free_list = nullptr;
+	std::size_t slot_count = 0;
+	std::size_t high_water = 0;
+	std::size_t live = 0;
+};
+
+} // namespace cml
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "allocator.h"
+#include "quat.h"
+#include "vec3.h"
+
+/*
+Keyframe tracks and clip sampling.
+
+A track keeps its key times and each value component in separate arrays. Every
+sampled instance keeps a cursor per track, the index of the last key used, so
+playing forwards only ever checks the next key instead of binary searching.
+
+Sampling a whole clip first locates the keys of every track, then blends all
+tracks at once in component loops over the clip, which the compiler turns into
+SIMD code. Rotation keys are stored in the same hemisphere as the previous key
+when added, so they can be blended with a normalized lerp without sign checks.
+*/
+
+namespace cml
+{
+
+template <int N> class track
+{
+	static_assert (N == 3 || N == 4, "tracks hold vec3 or quat keys");
+
+	public:
+	std::vector<float> times;
+	std::array<aligned_vector<float>, N> values;
+
+	std::size_t size () const { return times.size (); }
+	bool empty () const { return times.empty (); }
+	float duration () const { return times.empty () ? 0.f : times.back (); }
+
+	void reserve (std::size_t count)
+	{
+		times.reserve (count);
+		for (auto& v : values)
+			v.reserve (count);
+	}
+
+	// Keys must be added in increasing time order
+	void add_key (float time, vec3<float> const& v)
+	{
+		static_assert (N == 3, "vec3 keys go into vec3 tracks");
+		assert (times.empty () || time > times.back ());
+		times.push_back (time);
+		values[0].push_back (v.x), values[1].push_back (v.y), values[2].push_back (v.z);
+	}
+
+	void add_key (float time, quat<float> q)
+	{
+		static_assert (N == 4, "quat keys go into quat tracks");
+		assert (times.empty () || time > times.back ());
+		if (!times.empty () && dot (q, key_quat (size () - 1)) < 0.f) q = -q;
+		vec3<float> im = q.getImag ();
+		times.push_back (time);
+		values[0].push_back (im.x), values[1].push_back (im.y), values[2].push_back (im.z);
+		values[3].push_back (q.getReal ());
+	}
+
+	vec3<float> key_vec3 (std::size_t i) const { return vec3<float> (values[0][i], values[1][i], values[2][i]); }
+
+	quat<float> key_quat (std::size_t i) const
+	{
+		return quat<float> (values[0][i], values[1][i], values[2][i], values[3][i]);
+	}
+
+	// Index of the last key at or before time, starting from the cursor of the previous
+	// call. Constant time while time moves forward by less than one key per call.
+	std::uint32_t find (float time, std::uint32_t& cursor) const
+	{
+		std::uint32_t const last = static_cast<std::uint32_t> (times.size ()) - 1;
+		std::uint32_t c = cursor < last ? cursor : last;
+		if (times[c] <= time)
+		{
+			if (c == last || time < times[c + 1]) return cursor = c;
+			if (c + 1 == last || time < times[c + 2]) return cursor = c + 1;
+		}
+		auto it = std::upper_bound (times.begin (), times.end (), time);
+		c = it == times.begin () ? 0 : static_cast<std::uint32_t> (it - times.begin ()) - 1;
+		return cursor = c;
+	}
+
+	// Blend factor between key i and i + 1, clamped to the track
+	float fraction (std::uint32_t i, float time) const
+	{
+		if (i + 1 >= times.size ()) return 0.f;
+		float f = (time - times[i]) / (times[i + 1] - times[i]);
+		return f < 0.f ? 0.f : (f > 1.f ? 1.f : f);
+	}
+};
+
+using vec3_track = track<3>;
+using quat_track = track<4>;
+
+// SINGLE TRACK SAMPLING
+
+inline vec3<float> sample (vec3_track const& t, float time, std::uint32_t& cursor)
+{
+	assert (!t.empty ());
+	std::uint32_t i = t.find (time, cursor);
+	std::uint32_t j = i + 1 < t.size () ? i + 1 : i;
+	return lerp (t.key_vec3 (i), t.key_vec3 (j), t.fraction (i, time));
+}
+
+inline quat<float> sample (quat_track const& t, float time, std::uint32_t& cursor)
+{
+	assert (!t.empty ());
+	std::uint32_t i = t.find (time, cursor);
+	std::uint32_t j = i + 1 < t.size () ? i + 1 : i;
+	return nlerp (t.key_quat (i), t.key_quat (j), t.fraction (i, time));
+}
+
+// CLIPS
+
+// Local transforms of every joint
+struct pose
+{
+	std::vector<vec3<float>> translation;
+	std::vector<quat<float>> rotation;
+	std::vector<vec3<float>> scale;
+
+	void resize (std::size_t joints)
+	{
+		translation.resize (joints);
+		rotation.resize (joints);
+		scale.resize (joints, vec3<float> (1.f));
+	}
+
+	std::size_t size () const { return translation.size (); }
+};
+
+// One translation, rotation and scale track per joint
+class clip
+{
+	public:
+	explicit clip (std::size_t joints = 0) : translation (joints), rotation (joints), scale (joints) {}
+
+	std::size_t joint_count () const { return translation.size (); }
+
+	float duration () const
+	{
+		float d = 0.f;
+		for (std::size_t j = 0; j < joint_count (); j++)
+		{
+			d = std::max (d, translation[j].duration ());
+			d = std::max (d, std::max (rotation[j].duration (), scale[j].duration ()));
+		}
+		return d;
+	}
+
+	std::vector<vec3_track> translation;
+	std::vector<quat_track> rotation;
+	std::vector<vec3_track> scale;
+};
+
+// Per instance playback state of a clip, the cached key of every track plus blend scratch
+struct clip_cursor
+{
+	void reset (std::size_t joints)
+	{
+		keys.assign (3 * joints, 0);
+		for (auto& a : from)
+			a.resize (joints);
+		for (auto& b : to)
+			b.resize (joints);
+		fact.resize (joints);
+	}
+
+	std::vector<std::uint32_t> keys; // translation, rotation then scale track of each joint
+	std::array<aligned_vector<float>, 4> from, to;
+	aligned_vector<float> fact;
+};
+
+namespace detail
+{
+// Finds the keys of every track and gathers the two values to blend into component arrays.
+// Empty tracks hold the rest value.
+template <int N>
+void gather (std::vector<track<N>> const& tracks,
+    float time,
+    std::uint32_t* keys,
+    float const (&rest)[N],
+    clip_cursor& cursor)
+{
+	for (std::size_t j = 0; j < tracks.size (); j++)
+	{
+		track<N> const& t = tracks[j];
+		if (t.empty ())
+		{
+			for (int c = 0; c < N; c++)
+				cursor.from[c][j] = cursor.to[c][j] = rest[c];
+			cursor.fact[j] = 0.f;
+			continue;
+		}
+		std::uint32_t i = t.find (time, keys[j]);
+		std::uint32_t k = i + 1 < t.size () ? i + 1 : i;
+		for (int c = 0; c < N; c++)
+		{
+			cursor.from[c][j] = t.values[c][i];
+			cursor.to[c][j] = t.values[c][k];
+		}
+		cursor.fact[j] = t.fraction (i, time);
+	}
+}
+} // namespace detail
+
+// Samples every track of the clip at time into out, blending all joints per component at once
+inline void sample (clip const& anim, float time, clip_cursor& cursor, pose& out)
+{
+	std::size_t const joints = anim.joint_count ();
+	if (cursor.keys.size () != 3 * joints) cursor.reset (joints);
+	out.resize (joints);
+
+	float const* f = cursor.fact.data ();
+	float* a[4] = { cursor.from[0].data (), cursor.from[1].data (), cursor.from[2].data (), cursor.from[3].data () };
+	float const* b[4] = { cursor.to[0].data (), cursor.to[1].data (), cursor.to[2].data (), cursor.to[3].data () };
+
+	// vec3 tracks, a = a + (b - a) * f
+	auto blend3 = [&] (std::vector<vec3_track> const& tracks,
+	                  std::uint32_t* keys,
+	                  float const (&rest)[3],
+	                  std::vector<vec3<float>>& dst) {
+		detail::gather (tracks, time, keys, rest, cursor);
+		for (int c = 0; c < 3; c++)
+			for (std::size_t j = 0; j < joints; j++)
+				a[c][j] += (b[c][j] - a[c][j]) * f[j];
+		for (std::size_t j = 0; j < joints; j++)
+			dst[j] = vec3<float> (a[0][j], a[1][j], a[2][j]);
+	};
+	float const zero[3] = { 0.f, 0.f, 0.f }, one[3] = { 1.f, 1.f, 1.f };
+	blend3 (anim.translation, cursor.keys.data (), zero, out.translation);
+	blend3 (anim.scale, cursor.keys.data () + 2 * joints, one, out.scale);
+
+	// quat tracks, normalized lerp. Keys share a hemisphere so no sign flip is needed.
+	float const identity[4] = { 0.f, 0.f, 0.f, 1.f };
+	detail::gather (anim.rotation, time, cursor.keys.data () + joints, identity, cursor);
+	for (int c = 0; c < 4; c++)
+		for (std::size_t j = 0; j < joints; j++)
+			a[c][j] += (b[c][j] - a[c][j]) * f[j];
+	for (std::size_t j = 0; j < joints; j++)
+	{
+		float inv = 1.f / std::sqrt (a[0][j] * a[0][j] + a[1][j] * a[1][j] + a[2][j] * a[2][j] + a[3][j] * a[3][j]);
+		out.rotation[j] = quat<float> (a[0][j] * inv, a[1][j] * inv, a[2][j] * inv, a[3][j] * inv);
+	}
+}
+
+} // namespace cml
@@ -0,0 +1,496 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "aabb.h"
+#include "allocator.h"
+#include "parallel.h"
+#include "ray.h"
+
+/*
+Bounding volume hierarchy over boxes or triangles.
+
+Built top down with a binned surface area heuristic into a binary tree, the upper
+levels in parallel, then collapsed into W wide nodes (4 for SSE, 8 for AVX).
+Each node keeps its W child boxes as structure of arrays so a ray is tested
+against all of them in one pass. Nodes are stored flat in depth first order,
+parents before children, which keeps the first children of a node next to it in
+memory and lets refit run as a single reverse sweep.
+
+Traversal is iterative with a small explicit stack, children are visited nearest
+first so nearest hit queries can cull with the current closest distance. The
+stack is sized for the deepest tree the builder makes: below sah_depth binary
+levels it stops using the surface area heuristic, which can peel off a few
+primitives per level on skewed input, and splits at the centroid median instead.
+Median splits halve the primitive count, so no path gets deeper than max_depth.
+*/
+
+namespace cml
+{
+
+template <int W = 4> class bvh
+{
+	static_assert (W == 2 || W == 4 || W == 8, "bvh nodes are 2, 4 or 8 wide");
+
+	public:
+	static constexpr int width = W;
+	static constexpr int bin_count = 16;
+	static constexpr int max_depth = 64;
+	static constexpr int sah_depth = max_depth - 32; // leaves 32 median splits for 2^32 primitives
+
+	// Child slot encoding: count == 0 -> inner node at index child, count > 0 ->
+	// leaf of count primitives starting at prim_indices[child], child < 0 -> empty slot
+	struct alignas (64) node
+	{
+		float min_x[W], min_y[W], min_z[W];
+		float max_x[W], max_y[W], max_z[W];
+		std::int32_t child[W];
+		std::uint32_t count[W];
+
+		aabb<float> bounds (int slot) const
+		{
+			return aabb<float> (vec3<float> (min_x[slot], min_y[slot], min_z[slot]),
+			    vec3<float> (max_x[slot], max_y[slot], max_z[slot]));
+		}
+
+		void set_bounds (int slot, aabb<float> const& box)
+		{
+			min_x[slot] = box.min.x, min_y[slot] = box.min.y, min_z[slot] = box.min.z;
+			max_x[slot] = box.max.x, max_y[slot] = box.max.y, max_z[slot] = box.max.z;
+		}
+
+		bool is_leaf (int slot) const { return count[slot] > 0; }
+		bool is_empty (int slot) const { return child[slot] < 0; }
+	};
+
+	struct build_settings
+	{
+		std::uint32_t max_leaf_size = 4;
+		float traversal_cost = 1.f;     // relative to one primitive test
+		std::size_t parallel_grain = 4096; // subtrees smaller than this are built serially
+		unsigned threads = hardware_threads ();
+	};
+
+	bvh () {}
+
+	// BUILD
+
+	void build (aabb<float> const* boxes, std::size_t count, build_settings const& settings = build_settings ())
+	{
+		nodes.clear ();
+		prim_indices.resize (count);
+		if (count == 0) return;
+
+		std::vector<vec3<float>> centers (count);
+		for (std::size_t i = 0; i < count; i++)
+		{
+			prim_indices[i] = static_cast<std::uint32_t> (i);
+			centers[i] = boxes[i].center ();
+		}
+
+		binary_builder builder{
+			boxes, centers.data (), prim_indices.data (), settings, std::vector<binary_node> (2 * count)
+		};
+		builder.next_node = 1;
+		int spawn_depth = 0;
+		while ((1u << spawn_depth) < settings.threads)
+			spawn_depth++;
+		builder.build (0, 0, static_cast<std::uint32_t> (count), 0, spawn_depth);
+
+		nodes.reserve (builder.next_node / 2 + 1);
+		collapse (builder.nodes, 0);
+	}
+
+	void build (triangle_soa const& tris, build_settings const& settings = build_settings ())
+	{
+		std::vector<aabb<float>> boxes (tris.size ());
+		triangle_bounds (tris, boxes.data ());
+		build (boxes.data (), boxes.size (), settings);
+	}
+
+	// REFIT
+
+	// Updates every node box from new primitive boxes, keeping the topology.
+	// Quality degrades when primitives move far, rebuild then.
+	void refit (aabb<float> const* boxes)
+	{
+		for (std::size_t n = nodes.size (); n-- > 0;)
+		{
+			node& nd = nodes[n];
+			for (int s = 0; s < W; s++)
+			{
+				if (nd.is_empty (s)) continue;
+				aabb<float> box;
+				if (nd.is_leaf (s))
+				{
+					for (std::uint32_t i = 0; i < nd.count[s]; i++)
+						box.expand (boxes[prim_indices[nd.child[s] + i]]);
+				}
+				else
+				{
+					box = node_bounds (nodes[nd.child[s]]);
+				}
+				nd.set_bounds (s, box);
+			}
+		}
+	}
+
+	void refit (triangle_soa const& tris)
+	{
+		std::vector<aabb<float>> boxes (tris.size ());
+		triangle_bounds (tris, boxes.data ());
+		refit (boxes.data ());
+	}
+
+	// QUERIES
+
+	// Visits leaves hit by the ray, nearest node first. leaf (prim, t_max) tests one
+	// primitive, may shrink t_max, and returns true to stop the traversal.
+	template <typename F> void traverse (ray<float> const& r, float t_max, F&& leaf) const
+	{
+		if (nodes.empty ()) return;
+		vec3<float> const inv = r.inv_direction ();
+
+		// a wide level is at least one binary level deep and leaves at most W - 1 siblings
+		// pushed, the last level pushes W
+		std::int32_t stack[(W - 1) * max_depth + W];
+		int stack_size = 0;
+		stack[stack_size++] = 0;
+
+		while (stack_size > 0)
+		{
+			node const& nd = nodes[stack[--stack_size]];
+			float t_near[W];
+			std::uint32_t mask = intersect_node (nd, r.origin, inv, t_max, t_near);
+
+			// inner children to visit, kept sorted far to near
+			std::int32_t next[W];
+			float next_t[W];
+			int next_count = 0;
+			for (int s = 0; s < W; s++)
+			{
+				if (!(mask & (1u << s))) continue;
+				if (nd.is_leaf (s))
+				{
+					for (std::uint32_t i = 0; i < nd.count[s]; i++)
+						if (leaf (prim_indices[nd.child[s] + i], t_max)) return;
+					continue;
+				}
+				int j = next_count++;
+				while (j > 0 && next_t[j - 1] < t_near[s])
+				{
+					next[j] = next[j - 1];
+					next_t[j] = next_t[j - 1];
+					j--;
+				}
+				next[j] = nd.child[s];
+				next_t[j] = t_near[s];
+			}
+			// nearest is pushed last so it is popped first
+			assert (stack_size + next_count <= static_cast<int> (sizeof (stack) / sizeof (stack[0])));
+			for (int i = 0; i < next_count; i++)
+				stack[stack_size++] = next[i];
+		}
+	}
+
+	// Nearest triangle hit, prim is -1 on a miss
+	ray_hit intersect (ray<float> const& r, triangle_soa const& tris, float t_max) const
+	{
+		ray_hit hit;
+		traverse (r, t_max, [&] (std::uint32_t prim, float& t_limit) {
+			float t, u, v;
+			if (cml::intersect (r, tris.vertex (prim, 0), tris.vertex (prim, 1), tris.vertex (prim, 2), t_limit, t, u, v))
+			{
+				t_limit = t;
+				hit = ray_hit{ t, u, v, static_cast<int> (prim) };
+			}
+			return false;
+		});
+		return hit;
+	}
+
+	// Any hit, for shadow and line of sight rays
+	bool occluded (ray<float> const& r, triangle_soa const& tris, float t_max) const
+	{
+		bool blocked = false;
+		traverse (r, t_max, [&] (std::uint32_t prim, float& t_limit) {
+			float t, u, v;
+			blocked = cml::intersect (r, tris.vertex (prim, 0), tris.vertex (prim, 1), tris.vertex (prim, 2), t_limit, t, u, v);
+			return blocked;
+		});
+		return blocked;
+	}
+
+	// Nearest box hit, returns the box index or -1. t_hit is where the ray enters it.
+	int intersect (ray<float> const& r, aabb<float> const* boxes, float t_max, float& t_hit) const
+	{
+		int best = -1;
+		t_hit = t_max;
+		traverse (r, t_max, [&] (std::uint32_t prim, float& t_limit) {
+			float t;
+			if (cml::intersect (r, boxes[prim], t_limit, t))
+			{
+				t_hit = t;
+				t_limit = t < 0.f ? 0.f : t; // inside the box, nothing can be nearer
+				best = static_cast<int> (prim);
+			}
+			return false;
+		});
+		return best;
+	}
+
+	aabb<float> bounds () const { return nodes.empty () ? aabb<float> () : node_bounds (nodes[0]); }
+
+	std::vector<node, aligned_allocator<node>> nodes;
+	std::vector<std::uint32_t> prim_indices;
+
+	private:
+	static void triangle_bounds (triangle_soa const& tris, aabb<float>* boxes)
+	{
+		for (std::size_t i = 0; i < tris.size (); i++)
+		{
+			aabb<float> box;
+			box.expand (tris.vertex (i, 0));
+			box.expand (tris.vertex (i, 1));
+			box.expand (tris.vertex (i, 2));
+			boxes[i] = box;
+		}
+	}
+
+	static aabb<float> node_bounds (node const& nd)
+	{
+		aabb<float> box;
+		for (int s = 0; s < W; s++)
+			if (!nd.is_empty (s)) box.expand (nd.bounds (s));
+		return box;
+	}
+
+	// Slab test of one ray against all child boxes of a node. Empty slots have
+	// inverted boxes, which the slab test does not reject, so they are masked out.
+	static std::uint32_t intersect_node (
+	    node const& nd, vec3<float> const& o, vec3<float> const& inv, float t_max, float (&t_near)[W])
+	{
+		std::int32_t hit[W];
+		for (int s = 0; s < W; s++)
+		{
+			float tx1 = (nd.min_x[s] - o.x) * inv.x, tx2 = (nd.max_x[s] - o.x) * inv.x;
+			float ty1 = (nd.min_y[s] - o.y) * inv.y, ty2 = (nd.max_y[s] - o.y) * inv.y;
+			float tz1 = (nd.min_z[s] - o.z) * inv.z, tz2 = (nd.max_z[s] - o.z) * inv.z;
+			float lo = max (max (min (tx1, tx2), min (ty1, ty2)), min (tz1, tz2));
+			float hi = min (min (max (tx1, tx2), max (ty1, ty2)), max (tz1, tz2));
+			t_near[s] = lo;
+			hit[s] = (lo <= hi) & (hi >= 0.f) & (lo < t_max) & (nd.child[s] >= 0);
+		}
+		std::uint32_t mask = 0;
+		for (int s = 0; s < W; s++)
+			mask |= static_cast<std::uint32_t> (hit[s] != 0) << s;
+		return mask;
+	}
+
+	struct binary_node
+	{
+		aabb<float> box;
+		std::uint32_t left = 0, right = 0; // children, when count == 0
+		std::uint32_t first = 0, count = 0;
+	};
+
+	struct binary_builder
+	{
+		aabb<float> const* boxes;
+		vec3<float> const* centers;
+		std::uint32_t* indices;
+		build_settings settings;
+		std::vector<binary_node> nodes;
+		std::atomic<std::uint32_t> next_node{ 0 };
+
+		void build (std::uint32_t index, std::uint32_t first, std::uint32_t count, int depth, int spawn_depth)
+		{
+			aabb<float> box, center_box;
+			for (std::uint32_t i = first; i < first + count; i++)
+			{
+				box.expand (boxes[indices[i]]);
+				center_box.expand (centers[indices[i]]);
+			}
+			binary_node& nd = nodes[index];
+			nd.box = box;
+			nd.first = first;
+			nd.count = count;
+			if (count <= 1) return;
+
+			int axis = center_box.major_axis ();
+			float lo = center_box.min.get (axis);
+			float extent = center_box.max.get (axis) - lo;
+			float const scale = bin_count * (1.f - 1e-5f) / extent;
+			// coincident centroids, or an extent so small the bin scale overflows
+			if (!(extent > 0.f) || !(scale <= std::numeric_limits<float>::max ()))
+			{
+				if (count <= settings.max_leaf_size) return;
+				split (index, first, count, first + count / 2, depth, spawn_depth);
+				return;
+			}
+			if (depth >= sah_depth)
+			{
+				if (count <= settings.max_leaf_size) return;
+				std::uint32_t* const begin = indices + first;
+				std::nth_element (begin, begin + count / 2, begin + count, [&] (std::uint32_t a, std::uint32_t b) {
+					return centers[a].get (axis) < centers[b].get (axis);
+				});
+				split (index, first, count, first + count / 2, depth, spawn_depth);
+				return;
+			}
+
+			// bin centroids along the major axis
+			aabb<float> bin_box[bin_count];
+			std::uint32_t bin_n[bin_count] = {};
+			for (std::uint32_t i = first; i < first + count; i++)
+			{
+				int b = static_cast<int> ((centers[indices[i]].get (axis) - lo) * scale);
+				bin_n[b]++;
+				bin_box[b].expand (boxes[indices[i]]);
+			}
+
+			// sweep from the right, then from the left evaluating each split plane
+			float right_area[bin_count];
+			aabb<float> acc;
+			for (int b = bin_count - 1; b > 0; b--)
+			{
+				acc.expand (bin_box[b]);
+				right_area[b] = acc.surface_area ();
+			}
+			std::uint32_t right_n = count;
+			std::uint32_t left_n = 0;
+			acc = aabb<float> ();
+			float best_cost = std::numeric_limits<float>::max ();
+			int best_split = -1;
+			for (int b = 1; b < bin_count; b++)
+			{
+				acc.expand (bin_box[b - 1]);
+				left_n += bin_n[b - 1];
+				right_n -= bin_n[b - 1];
+				if (left_n == 0 || right_n == 0) continue;
+				float cost = acc.surface_area () * left_n + right_area[b] * right_n;
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_split = b;
+				}
+			}
+
+			float leaf_cost = box.surface_area () * count;
+			float split_cost = settings.traversal_cost * box.surface_area () + best_cost;
+			if (best_split < 0 || (count <= settings.max_leaf_size && leaf_cost <= split_cost))
+			{
+				if (count <= settings.max_leaf_size) return;
+				split (index, first, count, first + count / 2, depth, spawn_depth);
+				return;
+			}
+
+			std::uint32_t* mid = std::partition (indices + first, indices + first + count, [&] (std::uint32_t i) {
+				return static_cast<int> ((centers[i].get (axis) - lo) * scale) < best_split;
+			});
+			split (index, first, count, static_cast<std::uint32_t> (mid - indices), depth, spawn_depth);
+		}
+
+		void split (std::uint32_t index,
+		    std::uint32_t first,
+		    std::uint32_t count,
+		    std::uint32_t mid,
+		    int depth,
+		    int spawn_depth)
+		{
+			std::uint32_t left = next_node.fetch_add (2);
+			std::uint32_t right = left + 1;
+			binary_node& nd = nodes[index];
+			nd.left = left;
+			nd.right = right;
+			nd.count = 0;
+
+			std::uint32_t left_count = mid - first;
+			std::uint32_t right_count = count - left_count;
+			if (spawn_depth > 0 && count >= settings.parallel_grain)
+			{
+				std::thread worker ([=] { build (left, first, left_count, depth + 1, spawn_depth - 1); });
+				build (right, mid, right_count, depth + 1, spawn_depth - 1);
+				worker.join ();
+			}
+			else
+			{
+				build (left, first, left_count, depth + 1, 0);
+				build (right, mid, right_count, depth + 1, 0);
+			}
+		}
+	};
+
+	// Turns the binary subtree under b into wide nodes, returns the index of the wide node
+	std::int32_t collapse (std::vector<binary_node> const& bin, std::uint32_t b)
+	{
+		std::int32_t index = static_cast<std::int32_t> (nodes.size ());
+		nodes.emplace_back ();
+
+		// open the largest inner child until W children are gathered
+		std::uint32_t slots[W];
+		int used = 0;
+		if (bin[b].count > 0)
+			slots[used++] = b;
+		else
+		{
+			slots[used++] = bin[b].left;
+			slots[used++] = bin[b].right;
+		}
+		while (used < W)
+		{
+			int pick = -1;
+			float pick_area = -1.f;
+			for (int s = 0; s < used; s++)
+			{
+				binary_node const& c = bin[slots[s]];
+				if (c.count == 0 && c.box.surface_area () > pick_area)
+				{
+					pick = s;
+					pick_area = c.box.surface_area ();
+				}
+			}
+			if (pick < 0) break;
+			std::uint32_t opened = slots[pick];
+			slots[pick] = bin[opened].left;
+			slots[used++] = bin[opened].right;
+		}
+
+		for (int s = 0; s < W; s++)
+		{
+			node& nd = nodes[index];
+			if (s >= used)
+			{
+				nd.set_bounds (s, aabb<float> ());
+				nd.child[s] = -1;
+				nd.count[s] = 0;
+				continue;
+			}
+			binary_node const& c = bin[slots[s]];
+			nd.set_bounds (s, c.box);
+			if (c.count > 0)
+			{
+				nd.child[s] = static_cast<std::int32_t> (c.first);
+				nd.count[s] = c.count;
+			}
+			else
+			{
+				std::int32_t child = collapse (bin, slots[s]); // may reallocate nodes
+				nodes[index].child[s] = child;
+				nodes[index].count[s] = 0;
+			}
+		}
+		return index;
+	}
+};
+
+using bvh4 = bvh<4>;
+using bvh8 = bvh<8>;
+
+} // namespace cml
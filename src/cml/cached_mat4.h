@@ -0,0 +1,357 @@
+#pragma once
+
+#include <cstdint>
+
+#include "mat3.h"
+#include "mat4.h"
+#include "transform.h"
+
+/*
+mat4 wrapper which remembers what kind of transform it holds and memoizes the
+inverse, determinant and normal matrix until the matrix is modified.
+
+Every mutation goes through the wrapper so the caches are dropped at the right
+time. Inverse and multiply use the cheapest path the classification allows:
+
+identity    - nothing to do
+translation - negate the translation
+rigid       - transpose the rotation
+affine      - 3x3 inverse plus translation
+projective  - full 4x4 cofactor inverse
+
+Identity, translation, affine and projective are read off the matrix with exact
+comparisons. Rigid is never guessed from the numbers, a matrix that is only close
+to orthonormal would get a transpose for an inverse that is off by as much as it
+is. It comes from the rotation constructor and stays through translations and
+products of rigid matrices, whose rounding error is that of the product itself.
+*/
+
+namespace cml
+{
+
+// Ordered from most to least specialized, a matrix of one kind is also every later kind
+enum class mat4_kind : std::uint8_t
+{
+	identity,
+	translation,
+	rigid,
+	affine,
+	projective
+};
+
+// Most specialized kind the elements show exactly, never rigid
+template <typename T> mat4_kind classify (mat4<T> const& m)
+{
+	T const* d = m.data;
+	if (d[3] != 0 || d[7] != 0 || d[11] != 0 || d[15] != 1) return mat4_kind::projective;
+
+	bool upper_identity = d[0] == 1 && d[1] == 0 && d[2] == 0 && d[4] == 0 && d[5] == 1 &&
+	                      d[6] == 0 && d[8] == 0 && d[9] == 0 && d[10] == 1;
+	if (upper_identity)
+	{
+		if (d[12] == 0 && d[13] == 0 && d[14] == 0) return mat4_kind::identity;
+		return mat4_kind::translation;
+	}
+	return mat4_kind::affine;
+}
+
+// INVERSE FAST PATHS
+
+// Inverse of a matrix with an orthonormal upper 3x3 and no projection
+template <typename T> mat4<T> rigid_inverse (mat4<T> const& m)
+{
+	T const* d = m.data;
+	mat4<T> out;
+	T* o = out.data;
+	o[0] = d[0], o[1] = d[4], o[2] = d[8];
+	o[4] = d[1], o[5] = d[5], o[6] = d[9];
+	o[8] = d[2], o[9] = d[6], o[10] = d[10];
+	o[12] = -(o[0] * d[12] + o[4] * d[13] + o[8] * d[14]);
+	o[13] = -(o[1] * d[12] + o[5] * d[13] + o[9] * d[14]);
+	o[14] = -(o[2] * d[12] + o[6] * d[13] + o[10] * d[14]);
+	return out;
+}
+
+// Inverse of a matrix with no projection
+template <typename T> mat4<T> affine_inverse (mat4<T> const& m)
+{
+	T const* d = m.data;
+	// cofactors of the upper 3x3, c_row_col
+	T c00 = d[5] * d[10] - d[9] * d[6];
+	T c01 = d[9] * d[2] - d[1] * d[10];
+	T c02 = d[1] * d[6] - d[5] * d[2];
+	T c10 = d[8] * d[6] - d[4] * d[10];
+	T c11 = d[0] * d[10] - d[8] * d[2];
+	T c12 = d[4] * d[2] - d[0] * d[6];
+	T c20 = d[4] * d[9] - d[8] * d[5];
+	T c21 = d[8] * d[1] - d[0] * d[9];
+	T c22 = d[0] * d[5] - d[4] * d[1];
+
+	T inv_det = static_cast<T> (1) / (d[0] * c00 + d[4] * c01 + d[8] * c02);
+
+	mat4<T> out;
+	T* o = out.data;
+	o[0] = c00 * inv_det, o[1] = c01 * inv_det, o[2] = c02 * inv_det;
+	o[4] = c10 * inv_det, o[5] = c11 * inv_det, o[6] = c12 * inv_det;
+	o[8] = c20 * inv_det, o[9] = c21 * inv_det, o[10] = c22 * inv_det;
+	o[12] = -(o[0] * d[12] + o[4] * d[13] + o[8] * d[14]);
+	o[13] = -(o[1] * d[12] + o[5] * d[13] + o[9] * d[14]);
+	o[14] = -(o[2] * d[12] + o[6] * d[13] + o[10] * d[14]);
+	return out;
+}
+
+// Product of two matrices with no projection, skips the constant bottom row
+template <typename T> mat4<T> affine_multiply (mat4<T> const& a, mat4<T> const& b)
+{
+	T const* l = a.data;
+	T const* r = b.data;
+	mat4<T> out;
+	T* o = out.data;
+	for (int c = 0; c < 4; c++)
+	{
+		T x = r[c * 4 + 0], y = r[c * 4 + 1], z = r[c * 4 + 2];
+		o[c * 4 + 0] = l[0] * x + l[4] * y + l[8] * z;
+		o[c * 4 + 1] = l[1] * x + l[5] * y + l[9] * z;
+		o[c * 4 + 2] = l[2] * x + l[6] * y + l[10] * z;
+	}
+	o[12] += l[12];
+	o[13] += l[13];
+	o[14] += l[14];
+	return out;
+}
+
+// CACHED MAT4
+
+template <typename T = float> class cached_mat4
+{
+	public:
+	// Identity matrix constructor
+	cached_mat4 () noexcept {}
+
+	cached_mat4 (mat4<T> const& mat) : m (mat), valid (0) {}
+
+	cached_mat4 (mat4<T> const& mat, mat4_kind kind) : m (mat), type (kind), valid (has_kind) {}
+
+	// Rotation followed by a translation, rot must be orthonormal
+	cached_mat4 (mat3<T> const& rot, vec3<T> const& trans)
+	: type (mat4_kind::rigid), valid (has_kind)
+	{
+		m.set_mat3 (rot);
+		m.set_col (3, trans);
+	}
+
+	explicit cached_mat4 (vec3<T> const& trans) : type (mat4_kind::translation), valid (has_kind)
+	{
+		m.set_col (3, trans);
+		after_translation ();
+	}
+
+	cached_mat4<T>& operator= (mat4<T> const& mat)
+	{
+		m = mat;
+		valid = 0;
+		return *this;
+	}
+
+	mat4<T> const& get () const { return m; }
+
+	operator mat4<T> const& () const { return m; }
+
+	T get (int index) const { return m.get (index); }
+
+	void set (int index, T value)
+	{
+		m.set (index, value);
+		valid = 0;
+	}
+
+	void set (int const row, int const col, T const value)
+	{
+		m.set (row, col, value);
+		valid = 0;
+	}
+
+	T const& at (int const row, int const col) const { return m.at (row, col); }
+
+	// Writable access, the matrix is assumed modified
+	T& at (int const row, int const col)
+	{
+		valid = 0;
+		return m.at (row, col);
+	}
+
+	// Translation leaves the upper 3x3, and so the normal matrix and the determinant of
+	// affine matrices, untouched
+	cached_mat4<T>& translate (vec3<T> v)
+	{
+		m.translate (v);
+		after_translation ();
+		return *this;
+	}
+
+	cached_mat4<T>& set_translation (vec3<T> v)
+	{
+		m.set_translation (v);
+		after_translation ();
+		return *this;
+	}
+
+	cached_mat4<T>& scale (T s)
+	{
+		m.scale (s);
+		valid = 0;
+		return *this;
+	}
+
+	cached_mat4<T>& scale (vec3<T> s)
+	{
+		m.scale (s);
+		valid = 0;
+		return *this;
+	}
+
+	mat4_kind kind () const
+	{
+		if (!(valid & has_kind))
+		{
+			type = classify (m);
+			valid |= has_kind;
+		}
+		return type;
+	}
+
+	T det () const
+	{
+		if (!(valid & has_det))
+		{
+			switch (kind ())
+			{
+				case (mat4_kind::identity):
+				case (mat4_kind::translation): determinant = 1; break;
+				case (mat4_kind::projective): determinant = m.det (); break;
+				default: determinant = upper_det (); break;
+			}
+			valid |= has_det;
+		}
+		return determinant;
+	}
+
+	mat4<T> const& inverse () const
+	{
+		if (!(valid & has_inverse))
+		{
+			switch (kind ())
+			{
+				case (mat4_kind::identity): inv = mat4<T> (); break;
+				case (mat4_kind::translation):
+					inv = mat4<T> ();
+					inv.data[12] = -m.data[12];
+					inv.data[13] = -m.data[13];
+					inv.data[14] = -m.data[14];
+					break;
+				case (mat4_kind::rigid): inv = rigid_inverse (m); break;
+				case (mat4_kind::affine): inv = affine_inverse (m); break;
+				case (mat4_kind::projective): inv = m.inverse (); break;
+			}
+			valid |= has_inverse;
+		}
+		return inv;
+	}
+
+	// Inverse transpose of the upper 3x3, for transforming normals
+	mat3<T> const& normal_matrix () const
+	{
+		if (!(valid & has_normal))
+		{
+			T const* d = m.data;
+			switch (kind ())
+			{
+				case (mat4_kind::identity):
+				case (mat4_kind::translation): normal = mat3<T> (); break;
+				case (mat4_kind::rigid):
+					normal = mat3<T> (d[0], d[4], d[8], d[1], d[5], d[9], d[2], d[6], d[10]);
+					break;
+				default: normal = cml::normal_matrix (m);
+			}
+			valid |= has_normal;
+		}
+		return normal;
+	}
+
+	// MATRIX MULTIPLICATION
+	cached_mat4<T> operator* (cached_mat4<T> const& val) const
+	{
+		mat4_kind a = kind ();
+		mat4_kind b = val.kind ();
+		if (a == mat4_kind::identity) return val;
+		if (b == mat4_kind::identity) return *this;
+
+		mat4_kind out_kind = a > b ? a : b;
+		if (out_kind == mat4_kind::projective) return cached_mat4<T> (m * val.m, out_kind);
+		if (out_kind == mat4_kind::translation)
+		{
+			cached_mat4<T> out = *this;
+			out.translate (vec3<T> (val.m.data[12], val.m.data[13], val.m.data[14]));
+			return out;
+		}
+		return cached_mat4<T> (affine_multiply (m, val.m), out_kind);
+	}
+
+	// VECTOR MULTIPLICATION
+	vec4<T> operator* (vec4<T> const& val) const
+	{
+		T const* d = m.data;
+		switch (kind ())
+		{
+			case (mat4_kind::identity): return val;
+			case (mat4_kind::translation):
+				return vec4<T> (val.x + d[12] * val.w, val.y + d[13] * val.w, val.z + d[14] * val.w, val.w);
+			case (mat4_kind::projective): return m * val;
+			default:
+				return vec4<T> (d[0] * val.x + d[4] * val.y + d[8] * val.z + d[12] * val.w,
+				    d[1] * val.x + d[5] * val.y + d[9] * val.z + d[13] * val.w,
+				    d[2] * val.x + d[6] * val.y + d[10] * val.z + d[14] * val.w,
+				    val.w);
+		}
+	}
+
+	private:
+	enum : std::uint8_t
+	{
+		has_kind = 1,
+		has_det = 2,
+		has_inverse = 4,
+		has_normal = 8,
+		has_all = 15
+	};
+
+	void after_translation ()
+	{
+		// a projective bottom row mixes the translation into the 4x4 determinant
+		bool const affine = (valid & has_kind) && type != mat4_kind::projective;
+		valid &= has_kind | has_normal | (affine ? has_det : 0);
+		if ((valid & has_kind) && type == mat4_kind::identity) type = mat4_kind::translation;
+		if ((valid & has_kind) && type == mat4_kind::translation && m.data[12] == 0 &&
+		    m.data[13] == 0 && m.data[14] == 0)
+			type = mat4_kind::identity;
+	}
+
+	T upper_det () const
+	{
+		T const* d = m.data;
+		return d[0] * (d[5] * d[10] - d[9] * d[6]) - d[4] * (d[1] * d[10] - d[9] * d[2]) +
+		       d[8] * (d[1] * d[6] - d[5] * d[2]);
+	}
+
+	mat4<T> m;
+	mutable mat4<T> inv;
+	mutable mat3<T> normal;
+	mutable T determinant = 1;
+	mutable mat4_kind type = mat4_kind::identity;
+	mutable std::uint8_t valid = has_all;
+};
+
+using cached_mat4f = cached_mat4<float>;
+using cached_mat4d = cached_mat4<double>;
+
+} // namespace cml
@@ -2,12 +2,14 @@
 
 #include "common.h"
 
+#include "mat.h"
 #include "mat3.h"
 #include "mat4.h"
 #include "quat.h"
 
 #include "transform.h"
 
+#include "vec.h"
 #include "vec2.h"
 #include "vec3.h"
 #include "vec4.h"
@@ -65,14 +67,15 @@ template <typename T> mat4<T> to_mat4 (mat3<T> const& v, vec4<T> trans = vec4<T>
 
 // LINEAR INTERPOLATION
 
-template <typename T> constexpr T lerp (T const& a, T const& b, T const& fact)
+template <typename T, detail::if_scalar<T> = 0>
+constexpr T lerp (T const& a, T const& b, T const& fact)
 {
 	return (static_cast<T> (1.0) - fact) * a + fact * b;
 }
 
 // CLAMP
 
-template <typename T> T clamp (T const min, T const max, T const value)
+template <typename T, detail::if_scalar<T> = 0> T clamp (T const min, T const max, T const value)
 {
 	return value > min ? (value < max ? value : max) : min;
 }
@@ -80,25 +83,26 @@ template <typename T> T clamp (T const min, T const max, T const value)
 // POW
 
 // base raised to the exp power
-template <typename T> T pow (T const base, T const exp) { return std::pow (base, exp); }
+template <typename T, detail::if_scalar<T> = 0>
+T pow (T const base, T const exp) { return std::pow (base, exp); }
 
 // e to the exp power
-template <typename T> T exp (T const exp) { return std::exp (exp); }
+template <typename T, detail::if_scalar<T> = 0> T exp (T const exp) { return std::exp (exp); }
 
 // 2 to the exp power
-template <typename T> T exp2 (T const exp) { return std::exp2 (exp); }
+template <typename T, detail::if_scalar<T> = 0> T exp2 (T const exp) { return std::exp2 (exp); }
 
 
 // LOG
 
 // natural log of base
-template <typename T> T log (T const base) { return std::log (base); }
+template <typename T, detail::if_scalar<T> = 0> T log (T const base) { return std::log (base); }
 
 // log2 of base
-template <typename T> T log2 (T const base) { return std::log2 (base); }
+template <typename T, detail::if_scalar<T> = 0> T log2 (T const base) { return std::log2 (base); }
 
 // log10 of base
-template <typename T> T log10 (T const base) { return std::log10 (base); }
+template <typename T, detail::if_scalar<T> = 0> T log10 (T const base) { return std::log10 (base); }
 
 
 // MIX
@@ -108,16 +112,8 @@ template <typename T, typename U> T mix (T const x, T const y, U const amount)
 	return lerp (x, y, amount);
 }
 
-// TRIG
-
-template <typename T> T sin (T const val) { return std::sin (val); }
-template <typename T> T cos (T const val) { return std::cos (val); }
-template <typename T> T tan (T const val) { return std::tan (val); }
-template <typename T> T asin (T const val) { return std::sin (val); }
-template <typename T> T acos (T const val) { return std::cos (val); }
-template <typename T> T atan (T const val) { return std::tan (val); }
-
 // DISTANCE
-template <typename T> T distance (T const v1, T const v2) { return std::abs (v2 - v1); }
+template <typename T, detail::if_scalar<T> = 0>
+T distance (T const v1, T const v2) { return std::abs (v2 - v1); }
 
 } // namespace cml
@@ -0,0 +1,621 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "common.h"
+
+#if defined(CML_SSE2)
+#include <emmintrin.h>
+#endif
+
+#include "exp_log.h"
+#include "mat3.h"
+#include "vec3.h"
+#include "vec4.h"
+
+/*
+Color space conversions for single colors and arrays of pixels.
+
+Single colors use the exact formulas. Arrays of vec3<float> or vec4<float>
+pixels are converted four at a time with SSE2, transposed so each register
+holds one channel of four pixels. Alpha, and the padding lane of vec3<float>,
+are passed through unchanged. The sRGB transfer curves in arrays use the
+polynomial pow of exp_log.h, precision::fast is still well within half an 8 bit
+step.
+
+8 bit sRGB goes through tables instead. Decoding is a 256 entry table. Encoding
+looks up the float's exponent and top three mantissa bits in a 104 entry table
+of lines in fixed point, then evaluates the line at the next eight mantissa
+bits. The result is the correctly rounded code for all but about 0.05% of
+inputs, which are one code off. Both tables are built on first use.
+
+Packed formats store red in the lowest bits, RGBA8 as bytes and RGB10A2 as
+10 bits for each color and 2 for alpha, rounding to the nearest step after
+clamping to [0, 1].
+*/
+
+namespace cml
+{
+
+// TRANSFER FUNCTIONS
+
+inline float srgb_to_linear (float c)
+{
+	return c <= 0.04045f ? c * (1.f / 12.92f) : std::pow ((c + 0.055f) * (1.f / 1.055f), 2.4f);
+}
+
+inline float linear_to_srgb (float c)
+{
+	return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow (c, 1.f / 2.4f) - 0.055f;
+}
+
+inline vec3<float> srgb_to_linear (vec3<float> const& c)
+{
+	return vec3<float> (srgb_to_linear (c.x), srgb_to_linear (c.y), srgb_to_linear (c.z));
+}
+
+inline vec3<float> linear_to_srgb (vec3<float> const& c)
+{
+	return vec3<float> (linear_to_srgb (c.x), linear_to_srgb (c.y), linear_to_srgb (c.z));
+}
+
+// alpha is linear and kept as is
+inline vec4<float> srgb_to_linear (vec4<float> const& c)
+{
+	return vec4<float> (srgb_to_linear (c.x), srgb_to_linear (c.y), srgb_to_linear (c.z), c.w);
+}
+
+inline vec4<float> linear_to_srgb (vec4<float> const& c)
+{
+	return vec4<float> (linear_to_srgb (c.x), linear_to_srgb (c.y), linear_to_srgb (c.z), c.w);
+}
+
+// COLOR MATRICES
+
+// linear sRGB (Rec. 709 primaries, D65) to CIE XYZ and back
+constexpr mat3<float> srgb_to_xyz_matrix (0.4124564f, 0.3575761f, 0.1804375f, //
+    0.2126729f, 0.7151522f, 0.0721750f,                                          //
+    0.0193339f, 0.1191920f, 0.9503041f);
+constexpr mat3<float> xyz_to_srgb_matrix (3.2404542f, -1.5371385f, -0.4985314f, //
+    -0.9692660f, 1.8760108f, 0.0415560f,                                        //
+    0.0556434f, -0.2040259f, 1.0572252f);
+
+// linear Rec. 709 to linear Rec. 2020 primaries and back
+constexpr mat3<float> rec709_to_rec2020_matrix (0.6274040f, 0.3292820f, 0.0433136f, //
+    0.0690970f, 0.9195400f, 0.0113612f,                                                //
+    0.0163916f, 0.0880132f, 0.8955950f);
+constexpr mat3<float> rec2020_to_rec709_matrix (1.6604910f, -0.5876411f, -0.0728499f, //
+    -0.1245505f, 1.1328999f, -0.0083494f,                                             //
+    -0.0181508f, -0.1005789f, 1.1187297f);
+
+// HSV
+
+// Hue in [0, 1) turns, saturation and value in [0, 1] for colors in [0, 1]
+inline vec3<float> rgb_to_hsv (vec3<float> const& c)
+{
+	float const hi = max (c.x, max (c.y, c.z));
+	float const lo = min (c.x, min (c.y, c.z));
+	float const d = hi - lo;
+	float const inv_d = d > 0.f ? 1.f / d : 0.f;
+	float h;
+	if (hi == c.x)
+	{
+		h = (c.y - c.z) * inv_d;
+		if (h < 0.f) h += 6.f;
+	}
+	else if (hi == c.y)
+		h = (c.z - c.x) * inv_d + 2.f;
+	else
+		h = (c.x - c.y) * inv_d + 4.f;
+	float const s = hi > 0.f ? d / hi : 0.f;
+	return vec3<float> (h * (1.f / 6.f), s, hi);
+}
+
+inline vec3<float> hsv_to_rgb (vec3<float> const& c)
+{
+	// channel n is v - v s clamp (min (k, 4 - k)) with k = (n + 6 h) mod 6
+	float const h6 = c.x * 6.f;
+	float const vs = c.z * c.y;
+	auto channel = [&] (float n) {
+		float k = n + h6;
+		k -= 6.f * std::floor (k * (1.f / 6.f));
+		return c.z - vs * max (0.f, min (min (k, 4.f - k), 1.f));
+	};
+	return vec3<float> (channel (5.f), channel (3.f), channel (1.f));
+}
+
+// YCOCG
+
+// Luma, orange and green chroma, the inverse only needs additions
+inline vec3<float> rgb_to_ycocg (vec3<float> const& c)
+{
+	float const rb = (c.x + c.z) * 0.25f;
+	float const g = c.y * 0.5f;
+	return vec3<float> (rb + g, (c.x - c.z) * 0.5f, g - rb);
+}
+
+inline vec3<float> ycocg_to_rgb (vec3<float> const& c)
+{
+	float const t = c.x - c.z;
+	return vec3<float> (t + c.y, c.x + c.z, t - c.y);
+}
+
+// PACKING
+
+inline std::uint32_t pack_rgba8 (vec4<float> const& c)
+{
+	auto q = [] (float v) {
+		return static_cast<std::uint32_t> (min (max (v, 0.f), 1.f) * 255.f + 0.5f);
+	};
+	return q (c.x) | q (c.y) << 8 | q (c.z) << 16 | q (c.w) << 24;
+}
+
+inline vec4<float> unpack_rgba8 (std::uint32_t p)
+{
+	float const s = 1.f / 255.f;
+	return vec4<float> (static_cast<float> (p & 0xffu) * s, static_cast<float> (p >> 8 & 0xffu) * s,
+	    static_cast<float> (p >> 16 & 0xffu) * s, static_cast<float> (p >> 24) * s);
+}
+
+inline std::uint32_t pack_rgb10a2 (vec4<float> const& c)
+{
+	auto q = [] (float v, float steps) {
+		return static_cast<std::uint32_t> (min (max (v, 0.f), 1.f) * steps + 0.5f);
+	};
+	return q (c.x, 1023.f) | q (c.y, 1023.f) << 10 | q (c.z, 1023.f) << 20 | q (c.w, 3.f) << 30;
+}
+
+inline vec4<float> unpack_rgb10a2 (std::uint32_t p)
+{
+	float const s = 1.f / 1023.f;
+	return vec4<float> (static_cast<float> (p & 0x3ffu) * s,
+	    static_cast<float> (p >> 10 & 0x3ffu) * s, static_cast<float> (p >> 20 & 0x3ffu) * s,
+	    static_cast<float> (p >> 30) * (1.f / 3.f));
+}
+
+namespace detail
+{
+template <typename V> struct is_pixel : std::false_type
+{
+};
+template <> struct is_pixel<vec3<float>> : std::true_type
+{
+};
+template <> struct is_pixel<vec4<float>> : std::true_type
+{
+};
+
+static_assert (
+    sizeof (vec3<float>) == 4 * sizeof (float), "vec3<float> pixels are four floats apart");
+
+struct srgb_tables
+{
+	float decode[256];
+	// bias and slope of the encoding line of each bucket, in 16.16 fixed point codes
+	std::uint32_t bias[104], slope[104];
+
+	srgb_tables ()
+	{
+		for (int i = 0; i < 256; i++)
+			decode[i] = srgb_to_linear (static_cast<float> (i) / 255.f);
+		for (std::uint32_t b = 0; b < 104; b++)
+		{
+			// least squares line through the exact codes at the middle of each step
+			double st = 0, sy = 0, stt = 0, sty = 0;
+			for (std::uint32_t t = 0; t < 256; t++)
+			{
+				std::uint32_t const bits = encode_min + (b << 20) + (t << 12) + 2048;
+				double const x = bits_float (bits);
+				double const code =
+				    x <= 0.0031308 ? 12.92 * x : 1.055 * std::pow (x, 1 / 2.4) - 0.055;
+				double const y = 65536.0 * (255.0 * code + 0.5);
+				st += t, sy += y, stt += double (t) * t, sty += t * y;
+			}
+			double const s = (256.0 * sty - st * sy) / (256.0 * stt - st * st);
+			bias[b] = static_cast<std::uint32_t> (std::lround ((sy - s * st) / 256.0));
+			slope[b] = static_cast<std::uint32_t> (std::lround (s));
+		}
+	}
+
+	// 2^-13, smaller inputs all encode to 0, and the float below 1
+	static constexpr std::uint32_t encode_min = 0x39000000u;
+	static constexpr std::uint32_t encode_max = 0x3f7fffffu;
+};
+
+inline srgb_tables const& srgb_lut ()
+{
+	static srgb_tables const tables;
+	return tables;
+}
+
+inline std::uint32_t encode_srgb8 (srgb_tables const& lut, float c)
+{
+	std::uint32_t bits = float_bits (c);
+	// also catches negative values and NaN
+	if (!(bits > srgb_tables::encode_min && c > 0.f)) bits = srgb_tables::encode_min;
+	if (bits > srgb_tables::encode_max) bits = srgb_tables::encode_max;
+	std::uint32_t const b = (bits - srgb_tables::encode_min) >> 20;
+	return (lut.bias[b] + lut.slope[b] * (bits >> 12 & 0xffu)) >> 16;
+}
+
+// One operation per struct, on the r, g and b registers of four pixels with SSE2 and
+// on one pixel without
+
+template <precision P> struct srgb_to_linear_op
+{
+#if defined(CML_SSE2)
+	static __m128 curve (__m128 c)
+	{
+		__m128 const linear = _mm_mul_ps (c, _mm_set1_ps (1.f / 12.92f));
+		__m128 const x =
+		    _mm_mul_ps (_mm_add_ps (c, _mm_set1_ps (0.055f)), _mm_set1_ps (1.f / 1.055f));
+		__m128 const power = pow_ps<P> (x, _mm_set1_ps (2.4f));
+		return select_ps (_mm_cmple_ps (c, _mm_set1_ps (0.04045f)), linear, power);
+	}
+	void operator() (__m128& r, __m128& g, __m128& b) const
+	{
+		r = curve (r), g = curve (g), b = curve (b);
+	}
+#else
+	static float curve (float c)
+	{
+		if (c <= 0.04045f) return c * (1.f / 12.92f);
+		return pow_scalar<P> ((c + 0.055f) * (1.f / 1.055f), 2.4f);
+	}
+	vec3<float> operator() (vec3<float> const& c) const
+	{
+		return vec3<float> (curve (c.x), curve (c.y), curve (c.z));
+	}
+#endif
+};
+
+template <precision P> struct linear_to_srgb_op
+{
+#if defined(CML_SSE2)
+	static __m128 curve (__m128 c)
+	{
+		__m128 const linear = _mm_mul_ps (c, _mm_set1_ps (12.92f));
+		__m128 power = pow_ps<P> (c, _mm_set1_ps (1.f / 2.4f));
+		power = _mm_sub_ps (_mm_mul_ps (power, _mm_set1_ps (1.055f)), _mm_set1_ps (0.055f));
+		return select_ps (_mm_cmple_ps (c, _mm_set1_ps (0.0031308f)), linear, power);
+	}
+	void operator() (__m128& r, __m128& g, __m128& b) const
+	{
+		r = curve (r), g = curve (g), b = curve (b);
+	}
+#else
+	static float curve (float c)
+	{
+		return c <= 0.0031308f ? c * 12.92f : pow_scalar<P> (c, 1.f / 2.4f) * 1.055f - 0.055f;
+	}
+	vec3<float> operator() (vec3<float> const& c) const
+	{
+		return vec3<float> (curve (c.x), curve (c.y), curve (c.z));
+	}
+#endif
+};
+
+struct matrix_op
+{
+	mat3<float> m;
+#if defined(CML_SSE2)
+	__m128 row (int i, __m128 r, __m128 g, __m128 b) const
+	{
+		__m128 out = _mm_mul_ps (_mm_set1_ps (m.at (i, 0)), r);
+		out = _mm_add_ps (out, _mm_mul_ps (_mm_set1_ps (m.at (i, 1)), g));
+		return _mm_add_ps (out, _mm_mul_ps (_mm_set1_ps (m.at (i, 2)), b));
+	}
+	void operator() (__m128& r, __m128& g, __m128& b) const
+	{
+		__m128 const x = row (0, r, g, b), y = row (1, r, g, b), z = row (2, r, g, b);
+		r = x, g = y, b = z;
+	}
+#else
+	vec3<float> operator() (vec3<float> const& c) const { return m * c; }
+#endif
+};
+
+struct rgb_to_hsv_op
+{
+#if defined(CML_SSE2)
+	void operator() (__m128& r, __m128& g, __m128& b) const
+	{
+		__m128 const zero = _mm_setzero_ps ();
+		__m128 const hi = _mm_max_ps (r, _mm_max_ps (g, b));
+		__m128 const lo = _mm_min_ps (r, _mm_min_ps (g, b));
+		__m128 const d = _mm_sub_ps (hi, lo);
+		__m128 const inv_d = _mm_and_ps (_mm_cmpgt_ps (d, zero), _mm_div_ps (_mm_set1_ps (1.f), d));
+		__m128 hr = _mm_mul_ps (_mm_sub_ps (g, b), inv_d);
+		hr = _mm_add_ps (hr, _mm_and_ps (_mm_cmplt_ps (hr, zero), _mm_set1_ps (6.f)));
+		__m128 const hg = _mm_add_ps (_mm_mul_ps (_mm_sub_ps (b, r), inv_d), _mm_set1_ps (2.f));
+		__m128 const hb = _mm_add_ps (_mm_mul_ps (_mm_sub_ps (r, g), inv_d), _mm_set1_ps (4.f));
+		__m128 const h =
+		    select_ps (_mm_cmpeq_ps (hi, r), hr, select_ps (_mm_cmpeq_ps (hi, g), hg, hb));
+		__m128 const s = _mm_and_ps (_mm_cmpgt_ps (hi, zero), _mm_div_ps (d, hi));
+		r = _mm_mul_ps (h, _mm_set1_ps (1.f / 6.f)), g = s, b = hi;
+	}
+#else
+	vec3<float> operator() (vec3<float> const& c) const { return rgb_to_hsv (c); }
+#endif
+};
+
+struct hsv_to_rgb_op
+{
+#if defined(CML_SSE2)
+	void operator() (__m128& h, __m128& s, __m128& v) const
+	{
+		__m128 const h6 = _mm_mul_ps (h, _mm_set1_ps (6.f));
+		__m128 const vs = _mm_mul_ps (v, s);
+		auto channel = [&] (float n) {
+			__m128 k = _mm_add_ps (_mm_set1_ps (n), h6);
+			__m128 const turns = floor_ps (_mm_mul_ps (k, _mm_set1_ps (1.f / 6.f)));
+			k = _mm_sub_ps (k, _mm_mul_ps (_mm_set1_ps (6.f), turns));
+			__m128 w = _mm_min_ps (k, _mm_sub_ps (_mm_set1_ps (4.f), k));
+			w = _mm_min_ps (w, _mm_set1_ps (1.f));
+			w = _mm_max_ps (w, _mm_setzero_ps ());
+			return _mm_sub_ps (v, _mm_mul_ps (vs, w));
+		};
+		__m128 const r = channel (5.f), g = channel (3.f), b = channel (1.f);
+		h = r, s = g, v = b;
+	}
+#else
+	vec3<float> operator() (vec3<float> const& c) const { return hsv_to_rgb (c); }
+#endif
+};
+
+struct rgb_to_ycocg_op
+{
+#if defined(CML_SSE2)
+	void operator() (__m128& r, __m128& g, __m128& b) const
+	{
+		__m128 const quarter = _mm_set1_ps (0.25f), half = _mm_set1_ps (0.5f);
+		__m128 const rb = _mm_mul_ps (_mm_add_ps (r, b), quarter);
+		__m128 const hg = _mm_mul_ps (g, half);
+		__m128 const co = _mm_mul_ps (_mm_sub_ps (r, b), half);
+		r = _mm_add_ps (rb, hg), g = co, b = _mm_sub_ps (hg, rb);
+	}
+#else
+	vec3<float> operator() (vec3<float> const& c) const { return rgb_to_ycocg (c); }
+#endif
+};
+
+struct ycocg_to_rgb_op
+{
+#if defined(CML_SSE2)
+	void operator() (__m128& y, __m128& co, __m128& cg) const
+	{
+		__m128 const t = _mm_sub_ps (y, cg);
+		__m128 const g = _mm_add_ps (y, cg);
+		y = _mm_add_ps (t, co), cg = _mm_sub_ps (t, co), co = g;
+	}
+#else
+	vec3<float> operator() (vec3<float> const& c) const { return ycocg_to_rgb (c); }
+#endif
+};
+
+// out[i] = op (in[i]) for pixels four floats apart, the fourth float is copied
+template <typename Op>
+void map_pixels (float const* in, float* out, std::size_t count, Op const& op)
+{
+	std::size_t i = 0;
+#if defined(CML_SSE2)
+	auto four = [&op] (float const* src, float* dst) {
+		__m128 r = _mm_loadu_ps (src), g = _mm_loadu_ps (src + 4);
+		__m128 b = _mm_loadu_ps (src + 8), a = _mm_loadu_ps (src + 12);
+		_MM_TRANSPOSE4_PS (r, g, b, a);
+		op (r, g, b);
+		_MM_TRANSPOSE4_PS (r, g, b, a);
+		_mm_storeu_ps (dst, r), _mm_storeu_ps (dst + 4, g);
+		_mm_storeu_ps (dst + 8, b), _mm_storeu_ps (dst + 12, a);
+	};
+	for (; i + 4 <= count; i += 4)
+		four (in + 4 * i, out + 4 * i);
+	if (i < count)
+	{
+		float tail[16] = {};
+		std::memcpy (tail, in + 4 * i, (count - i) * 4 * sizeof (float));
+		four (tail, tail);
+		std::memcpy (out + 4 * i, tail, (count - i) * 4 * sizeof (float));
+	}
+#else
+	for (; i < count; i++)
+	{
+		float const* src = in + 4 * i;
+		vec3<float> const c = op (vec3<float> (src[0], src[1], src[2]));
+		float* dst = out + 4 * i;
+		dst[3] = src[3];
+		dst[0] = c.x, dst[1] = c.y, dst[2] = c.z;
+	}
+#endif
+}
+
+template <typename V, typename Op>
+void map_pixels (V const* in, V* out, std::size_t count, Op const& op)
+{
+	map_pixels (&in->x, &out->x, count, op);
+}
+} // namespace detail
+
+// ARRAYS OF PIXELS
+
+// Arrays of vec3<float> or vec4<float> pixels, in and out may be the same array
+
+template <typename V, std::enable_if_t<detail::is_pixel<V>::value, int> = 0>
+void srgb_to_linear (V const* in, V* out, std::size_t count, precision p = precision::accurate)
+{
+	if (p == precision::fast)
+		detail::map_pixels (in, out, count, detail::srgb_to_linear_op<precision::fast> ());
+	else
+		detail::map_pixels (in, out, count, detail::srgb_to_linear_op<precision::accurate> ());
+}
+
+template <typename V, std::enable_if_t<detail::is_pixel<V>::value, int> = 0>
+void linear_to_srgb (V const* in, V* out, std::size_t count, precision p = precision::accurate)
+{
+	if (p == precision::fast)
+		detail::map_pixels (in, out, count, detail::linear_to_srgb_op<precision::fast> ());
+	else
+		detail::map_pixels (in, out, count, detail::linear_to_srgb_op<precision::accurate> ());
+}
+
+// out[i] = m * in[i] for the color channels
+template <typename V, std::enable_if_t<detail::is_pixel<V>::value, int> = 0>
+void transform_colors (mat3<float> const& m, V const* in, V* out, std::size_t count)
+{
+	detail::map_pixels (in, out, count, detail::matrix_op{ m });
+}
+
+template <typename V, std::enable_if_t<detail::is_pixel<V>::value, int> = 0>
+void rgb_to_hsv (V const* in, V* out, std::size_t count)
+{
+	detail::map_pixels (in, out, count, detail::rgb_to_hsv_op ());
+}
+
+template <typename V, std::enable_if_t<detail::is_pixel<V>::value, int> = 0>
+void hsv_to_rgb (V const* in, V* out, std::size_t count)
+{
+	detail::map_pixels (in, out, count, detail::hsv_to_rgb_op ());
+}
+
+template <typename V, std::enable_if_t<detail::is_pixel<V>::value, int> = 0>
+void rgb_to_ycocg (V const* in, V* out, std::size_t count)
+{
+	detail::map_pixels (in, out, count, detail::rgb_to_ycocg_op ());
+}
+
+template <typename V, std::enable_if_t<detail::is_pixel<V>::value, int> = 0>
+void ycocg_to_rgb (V const* in, V* out, std::size_t count)
+{
+	detail::map_pixels (in, out, count, detail::ycocg_to_rgb_op ());
+}
+
+// 8 BIT sRGB
+
+inline float srgb8_to_linear (std::uint8_t c) { return detail::srgb_lut ().decode[c]; }
+
+inline std::uint8_t linear_to_srgb8 (float c)
+{
+	return static_cast<std::uint8_t> (detail::encode_srgb8 (detail::srgb_lut (), c));
+}
+
+// sRGB encoded RGBA8 pixels to linear colors, alpha is linear in both
+inline void srgba8_to_linear (std::uint32_t const* in, vec4<float>* out, std::size_t count)
+{
+	detail::srgb_tables const& lut = detail::srgb_lut ();
+	for (std::size_t i = 0; i < count; i++)
+	{
+		std::uint32_t const p = in[i];
+		out[i] = vec4<float> (lut.decode[p & 0xffu], lut.decode[p >> 8 & 0xffu],
+		    lut.decode[p >> 16 & 0xffu], static_cast<float> (p >> 24) * (1.f / 255.f));
+	}
+}
+
+inline void linear_to_srgba8 (vec4<float> const* in, std::uint32_t* out, std::size_t count)
+{
+	detail::srgb_tables const& lut = detail::srgb_lut ();
+	for (std::size_t i = 0; i < count; i++)
+	{
+		vec4<float> const& c = in[i];
+		std::uint32_t const a =
+		    static_cast<std::uint32_t> (min (max (c.w, 0.f), 1.f) * 255.f + 0.5f);
+		out[i] = detail::encode_srgb8 (lut, c.x) | detail::encode_srgb8 (lut, c.y) << 8 |
+		         detail::encode_srgb8 (lut, c.z) << 16 | a << 24;
+	}
+}
+
+// PACKED ARRAYS
+
+inline void pack_rgba8 (vec4<float> const* in, std::uint32_t* out, std::size_t count)
+{
+	std::size_t i = 0;
+#if defined(CML_SSE2)
+	__m128 const zero = _mm_setzero_ps (), one = _mm_set1_ps (1.f);
+	__m128 const scale = _mm_set1_ps (255.f), half = _mm_set1_ps (0.5f);
+	auto quantize = [&] (vec4<float> const& c) {
+		__m128 v = _mm_min_ps (_mm_max_ps (_mm_loadu_ps (&c.x), zero), one);
+		return _mm_cvttps_epi32 (_mm_add_ps (_mm_mul_ps (v, scale), half));
+	};
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i const lo = _mm_packs_epi32 (quantize (in[i]), quantize (in[i + 1]));
+		__m128i const hi = _mm_packs_epi32 (quantize (in[i + 2]), quantize (in[i + 3]));
+		_mm_storeu_si128 (reinterpret_cast<__m128i*> (out + i), _mm_packus_epi16 (lo, hi));
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = pack_rgba8 (in[i]);
+}
+
+inline void unpack_rgba8 (std::uint32_t const* in, vec4<float>* out, std::size_t count)
+{
+	std::size_t i = 0;
+#if defined(CML_SSE2)
+	__m128i const zero = _mm_setzero_si128 ();
+	__m128 const scale = _mm_set1_ps (1.f / 255.f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i const p = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (in + i));
+		__m128i const lo = _mm_unpacklo_epi8 (p, zero), hi = _mm_unpackhi_epi8 (p, zero);
+		__m128i const pixels[4] = { _mm_unpacklo_epi16 (lo, zero), _mm_unpackhi_epi16 (lo, zero),
+			_mm_unpacklo_epi16 (hi, zero), _mm_unpackhi_epi16 (hi, zero) };
+		for (int k = 0; k < 4; k++)
+			_mm_storeu_ps (&out[i + k].x, _mm_mul_ps (_mm_cvtepi32_ps (pixels[k]), scale));
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = unpack_rgba8 (in[i]);
+}
+
+inline void pack_rgb10a2 (vec4<float> const* in, std::uint32_t* out, std::size_t count)
+{
+	std::size_t i = 0;
+#if defined(CML_SSE2)
+	__m128 const zero = _mm_setzero_ps (), one = _mm_set1_ps (1.f), half = _mm_set1_ps (0.5f);
+	auto quantize = [&] (__m128 v, float steps) {
+		v = _mm_min_ps (_mm_max_ps (v, zero), one);
+		return _mm_cvttps_epi32 (_mm_add_ps (_mm_mul_ps (v, _mm_set1_ps (steps)), half));
+	};
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 r = _mm_loadu_ps (&in[i].x), g = _mm_loadu_ps (&in[i + 1].x);
+		__m128 b = _mm_loadu_ps (&in[i + 2].x), a = _mm_loadu_ps (&in[i + 3].x);
+		_MM_TRANSPOSE4_PS (r, g, b, a);
+		__m128i p = quantize (r, 1023.f);
+		p = _mm_or_si128 (p, _mm_slli_epi32 (quantize (g, 1023.f), 10));
+		p = _mm_or_si128 (p, _mm_slli_epi32 (quantize (b, 1023.f), 20));
+		p = _mm_or_si128 (p, _mm_slli_epi32 (quantize (a, 3.f), 30));
+		_mm_storeu_si128 (reinterpret_cast<__m128i*> (out + i), p);
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = pack_rgb10a2 (in[i]);
+}
+
+inline void unpack_rgb10a2 (std::uint32_t const* in, vec4<float>* out, std::size_t count)
+{
+	std::size_t i = 0;
+#if defined(CML_SSE2)
+	__m128i const mask = _mm_set1_epi32 (0x3ff);
+	__m128 const scale = _mm_set1_ps (1.f / 1023.f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i const p = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (in + i));
+		__m128i const gi = _mm_srli_epi32 (p, 10), bi = _mm_srli_epi32 (p, 20);
+		__m128 r = _mm_mul_ps (_mm_cvtepi32_ps (_mm_and_si128 (p, mask)), scale);
+		__m128 g = _mm_mul_ps (_mm_cvtepi32_ps (_mm_and_si128 (gi, mask)), scale);
+		__m128 b = _mm_mul_ps (_mm_cvtepi32_ps (_mm_and_si128 (bi, mask)), scale);
+		__m128 a = _mm_mul_ps (_mm_cvtepi32_ps (_mm_srli_epi32 (p, 30)), _mm_set1_ps (1.f / 3.f));
+		_MM_TRANSPOSE4_PS (r, g, b, a);
+		_mm_storeu_ps (&out[i].x, r), _mm_storeu_ps (&out[i + 1].x, g);
+		_mm_storeu_ps (&out[i + 2].x, b), _mm_storeu_ps (&out[i + 3].x, a);
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = unpack_rgb10a2 (in[i]);
+}
+
+} // namespace cml
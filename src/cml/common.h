@@ -3,6 +3,21 @@
 #include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <type_traits>
+
+// Instruction sets the optimized paths may use, detected from the compiler flags
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CML_SSE2 1
+#endif
+#if defined(__AVX__)
+#define CML_AVX 1
+#endif
+#if defined(__AVX2__)
+#define CML_AVX2 1
+#endif
+#if defined(__BMI2__)
+#define CML_BMI2 1
+#endif
 
 namespace cml
 {
@@ -16,11 +31,39 @@ template <typename T> inline T radians (T val) { return static_cast<T> ((val * P
 
 template <typename T> inline T degrees (T val) { return static_cast<T> ((180.0 * val) / PI); }
 
+namespace detail
+{
+// Base of every vec. The scalar templates here and in cml.h are disabled for vectors, which
+// would otherwise prefer them over the component wise overloads taking vec<N, T>
+struct vector_tag
+{
+};
+
+template <typename T>
+using if_scalar = std::enable_if_t<!std::is_base_of<vector_tag, T>::value, int>;
+} // namespace detail
+
 // MIN/MAX
 
-template <typename T> T min (T const a, T const b) { return a < b ? a : b; }
+template <typename T, detail::if_scalar<T> = 0>
+T min (T const a, T const b) { return a < b ? a : b; }
+
+template <typename T, detail::if_scalar<T> = 0>
+T max (T const a, T const b) { return a > b ? a : b; }
+
+// ROOTS
+
+// Unqualified calls to these let user scalar types provide their own overloads
+template <typename T> T sqrt (T const val) { return static_cast<T> (std::sqrt (val)); }
+
+// TRIG
 
-template <typename T> T max (T const a, T const b) { return a > b ? a : b; }
+template <typename T> T sin (T const val) { return std::sin (val); }
+template <typename T> T cos (T const val) { return std::cos (val); }
+template <typename T> T tan (T const val) { return std::tan (val); }
+template <typename T> T asin (T const val) { return std::asin (val); }
+template <typename T> T acos (T const val) { return std::acos (val); }
+template <typename T> T atan (T const val) { return std::atan (val); }
 
 
 } // namespace cml
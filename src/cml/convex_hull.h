@@ -0,0 +1,540 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "allocator.h"
+#include "parallel.h"
+#include "vec3.h"
+#include "vec4.h"
+
+/*
+3D convex hulls with quickhull.
+
+The hull is a half-edge mesh of triangles kept in flat arrays: face f owns the
+half-edges 3f, 3f + 1 and 3f + 2, so next and face of an edge are arithmetic and
+only the twin is stored. Deleted faces go on a free list and are reused. Points
+outside a face are chained through one next_point array.
+
+Every array the builder uses, scratch included, lives in a frame_arena and is
+sized for the worst case up front: a hull of n points has at most 2n - 4 faces,
+and each step creates at most that many. quickhull_scratch_size gives the bytes
+a build needs, so a caller that keeps one arena and one output hull around
+builds hull after hull without touching the heap once the output has grown.
+
+Distances of many points to one plane are computed over structure of arrays
+copies of the coordinates in SIMD friendly loops: finding the extreme points,
+the initial simplex and handing the points of removed faces to the new ones.
+
+Which faces a point sees is decided from the face vertices in double rather than
+the stored float planes, faces through the point included. Deciding it from
+rounded planes leaves slightly concave edges on dense curved inputs, and later
+steps fold the hull over them.
+
+Large inputs are split into chunks whose hulls are built in parallel. The hull
+of their vertices is the hull of the whole set.
+*/
+
+namespace cml
+{
+
+template <typename T = float> struct convex_hull
+{
+	std::vector<std::uint32_t> vertices; // input indices of the hull vertices, ascending
+	std::vector<std::uint32_t> triangles; // three input indices per face, counter clockwise from outside
+	std::vector<vec4<T>> planes; // outward plane of each face, dot (xyz, p) + w is the signed distance
+
+	std::size_t face_count () const { return planes.size (); }
+	bool empty () const { return planes.empty (); }
+};
+
+namespace detail
+{
+template <typename T> class quickhull_builder
+{
+	public:
+	static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max ();
+
+	// Arena bytes a builder over count points needs at most
+	static std::size_t scratch_size (std::size_t count)
+	{
+		std::size_t const f = face_capacity (count);
+		std::size_t bytes = cache_line_size; // the arena may not be on a cache line yet
+		auto add = [&] (std::size_t arrays, std::size_t size) {
+			bytes += arrays * detail::align_up (size, cache_line_size);
+		};
+		add (7, count * sizeof (T));
+		add (2, count * sizeof (std::uint32_t));
+		add (1, count * sizeof (char));
+		add (1, f * sizeof (face));
+		add (2, 3 * f * sizeof (std::uint32_t));
+		add (7, f * sizeof (std::uint32_t));
+		add (1, f * sizeof (rim_edge));
+		return bytes;
+	}
+
+	// Reserves all storage in the arena, throws std::bad_alloc when it is too small
+	quickhull_builder (vec3<T> const* points, std::size_t count, frame_arena& arena)
+	: count (count), px (arena), py (arena), pz (arena), faces (arena), origin (arena),
+	  twin (arena), free_faces (arena), pending (arena), next_point (arena), ids (arena),
+	  gx (arena), gy (arena), gz (arena), dist (arena), taken (arena), rims (arena),
+	  horizon (arena), visible (arena), created (arena), edge_stack (arena), left_stack (arena)
+	{
+		std::size_t const f = face_capacity (count);
+		for (auto* v : { &px, &py, &pz, &gx, &gy, &gz, &dist })
+			v->reserve (count);
+		for (auto* v : { &next_point, &ids })
+			v->reserve (count);
+		taken.reserve (count);
+		faces.reserve (f);
+		for (auto* v : { &origin, &twin })
+			v->reserve (3 * f);
+		for (auto* v : { &free_faces, &pending, &horizon, &visible, &created, &edge_stack, &left_stack })
+			v->reserve (f);
+		rims.reserve (f);
+
+		px.resize (count);
+		py.resize (count);
+		pz.resize (count);
+		for (std::size_t i = 0; i < count; i++)
+			px[i] = points[i].x, py[i] = points[i].y, pz[i] = points[i].z;
+	}
+
+	// False for point sets without volume
+	bool build ()
+	{
+		if (count < 4) return false;
+		std::uint32_t simplex[4];
+		if (!initial_simplex (simplex)) return false;
+
+		next_point.assign (count, npos);
+
+		std::uint32_t const a = simplex[0], b = simplex[1], c = simplex[2], d = simplex[3];
+		std::uint32_t f[4] = { new_face (a, b, c), new_face (a, d, b), new_face (a, c, d), new_face (b, d, c) };
+		for (std::uint32_t e = 0; e < 12; e++)
+			for (std::uint32_t o = 0; o < 12; o++)
+				if (origin[e] == origin[next (o)] && origin[next (e)] == origin[o]) twin[e] = o;
+
+		ids.resize (count);
+		for (std::size_t i = 0; i < count; i++)
+			ids[i] = static_cast<std::uint32_t> (i);
+		assign (f, 4);
+
+		for (std::uint32_t i = 0; i < 4; i++)
+			queue (f[i]);
+
+		while (!pending.empty ())
+		{
+			std::uint32_t const top = pending.back ();
+			pending.pop_back ();
+			faces[top].queued = false;
+			if (!faces[top].alive || faces[top].head == npos) continue;
+			std::uint32_t const eye = faces[top].farthest;
+
+			// depth first walk over the faces the eye sees, the edges towards faces it doesn't
+			// see form the horizon loop in order
+			stamp++;
+			horizon.clear ();
+			visible.assign (1, top);
+			faces[top].visit = stamp;
+			edge_stack.assign (1, 3 * top);
+			left_stack.assign (1, 3);
+			while (!edge_stack.empty ())
+			{
+				if (left_stack.back () == 0)
+				{
+					edge_stack.pop_back ();
+					left_stack.pop_back ();
+					continue;
+				}
+				std::uint32_t e = edge_stack.back ();
+				edge_stack.back () = next (e);
+				left_stack.back ()--;
+				std::uint32_t t = twin[e], nf = t / 3;
+				if (faces[nf].visit == stamp) continue;
+				if (sees (nf, eye))
+				{
+					faces[nf].visit = stamp;
+					visible.push_back (nf);
+					edge_stack.push_back (next (t));
+					left_stack.push_back (2);
+				}
+				else
+					horizon.push_back (e);
+			}
+
+			// the points of the removed faces, except the eye, wait for the new faces
+			ids.clear ();
+			for (std::uint32_t v : visible)
+			{
+				for (std::uint32_t p = faces[v].head; p != npos; p = next_point[p])
+					if (p != eye) ids.push_back (p);
+				faces[v].alive = false;
+			}
+
+			// read the horizon before freeing, new faces may reuse the removed slots
+			rims.clear ();
+			for (std::uint32_t e : horizon)
+				rims.push_back (rim_edge{ origin[e], origin[next (e)], twin[e] });
+			for (std::uint32_t v : visible)
+				free_faces.push_back (v);
+
+			created.clear ();
+			for (auto const& r : rims)
+			{
+				std::uint32_t nf = new_face (r.from, r.to, eye);
+				twin[3 * nf] = r.outside;
+				twin[r.outside] = 3 * nf;
+				created.push_back (nf);
+			}
+			for (std::size_t i = 0; i < created.size (); i++)
+			{
+				std::uint32_t prev = created[i == 0 ? created.size () - 1 : i - 1];
+				twin[3 * created[i] + 2] = 3 * prev + 1;
+				twin[3 * prev + 1] = 3 * created[i] + 2;
+			}
+
+			assign (created.data (), created.size ());
+			for (std::uint32_t nf : created)
+				queue (nf);
+		}
+		return true;
+	}
+
+	// Writes the hull, map turns point positions of the builder into output indices
+	void output (std::uint32_t const* map, convex_hull<T>& out)
+	{
+		out.vertices.clear ();
+		out.triangles.clear ();
+		out.planes.clear ();
+		auto& used = taken;
+		used.assign (count, 0);
+		for (std::size_t f = 0; f < faces.size (); f++)
+		{
+			if (!faces[f].alive) continue;
+			for (std::size_t k = 0; k < 3; k++)
+			{
+				std::uint32_t v = origin[3 * f + k];
+				used[v] = 1;
+				out.triangles.push_back (map ? map[v] : v);
+			}
+			out.planes.push_back (faces[f].plane);
+		}
+		for (std::size_t i = 0; i < count; i++)
+			if (used[i]) out.vertices.push_back (map ? map[i] : static_cast<std::uint32_t> (i));
+	}
+
+	// Hull vertices, or every point when there is no hull
+	void vertices (std::vector<std::uint32_t>& out, std::uint32_t offset)
+	{
+		auto& used = taken;
+		used.assign (count, faces.empty () ? 1 : 0);
+		for (std::size_t f = 0; f < faces.size (); f++)
+			if (faces[f].alive)
+				for (std::size_t k = 0; k < 3; k++)
+					used[origin[3 * f + k]] = 1;
+		for (std::size_t i = 0; i < count; i++)
+			if (used[i]) out.push_back (static_cast<std::uint32_t> (i) + offset);
+	}
+
+	private:
+	struct face
+	{
+		vec4<T> plane;
+		std::uint32_t head = npos; // first outside point
+		std::uint32_t farthest = npos;
+		T farthest_distance = 0;
+		std::uint32_t visit = 0;
+		bool alive = false;
+		bool queued = false; // on the pending stack, which holds each slot at most once
+	};
+
+	struct rim_edge
+	{
+		std::uint32_t from, to, outside;
+	};
+
+	// a hull of n points has at most 2n - 4 faces, one more step may be in flight
+	static std::size_t face_capacity (std::size_t count) { return 2 * count + 8; }
+
+	static std::uint32_t next (std::uint32_t e) { return e % 3 == 2 ? e - 2 : e + 1; }
+
+	vec3<T> point (std::uint32_t i) const { return vec3<T> (px[i], py[i], pz[i]); }
+
+	T distance (vec4<T> const& plane, std::uint32_t i) const
+	{
+		return plane.x * px[i] + plane.y * py[i] + plane.z * pz[i] + plane.w;
+	}
+
+	// Whether the eye p sees face f. The orientation is taken from the vertices of the
+	// face in double, where it is exact up to the last rounding for float input. Faces p
+	// lies on count as seen, as if p was moved outwards a tiny bit, so the removed faces
+	// always form a disk and no new face is left without area when points are coplanar.
+	bool sees (std::uint32_t f, std::uint32_t p) const
+	{
+		std::uint32_t const a = origin[3 * f], b = origin[3 * f + 1], c = origin[3 * f + 2];
+		double const ax = px[a], ay = py[a], az = pz[a];
+		double const ux = px[b] - ax, uy = py[b] - ay, uz = pz[b] - az;
+		double const vx = px[c] - ax, vy = py[c] - ay, vz = pz[c] - az;
+		double const wx = px[p] - ax, wy = py[p] - ay, wz = pz[p] - az;
+		double const nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+		double const bound = (std::fabs (uy * vz) + std::fabs (uz * vy)) * std::fabs (wx) +
+		                     (std::fabs (uz * vx) + std::fabs (ux * vz)) * std::fabs (wy) +
+		                     (std::fabs (ux * vy) + std::fabs (uy * vx)) * std::fabs (wz);
+		return nx * wx + ny * wy + nz * wz >= -8 * std::numeric_limits<double>::epsilon () * bound;
+	}
+
+	std::uint32_t new_face (std::uint32_t a, std::uint32_t b, std::uint32_t c)
+	{
+		std::uint32_t f;
+		if (!free_faces.empty ())
+		{
+			f = free_faces.back ();
+			free_faces.pop_back ();
+		}
+		else
+		{
+			f = static_cast<std::uint32_t> (faces.size ());
+			faces.emplace_back ();
+			origin.resize (origin.size () + 3);
+			twin.resize (twin.size () + 3, npos);
+		}
+		origin[3 * f] = a, origin[3 * f + 1] = b, origin[3 * f + 2] = c;
+
+		// in double, the normals of thin faces lose most of their digits in float
+		double const ax = px[a], ay = py[a], az = pz[a];
+		double const ux = px[b] - ax, uy = py[b] - ay, uz = pz[b] - az;
+		double const vx = px[c] - ax, vy = py[c] - ay, vz = pz[c] - az;
+		double nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+		double const len = std::sqrt (nx * nx + ny * ny + nz * nz);
+		if (len > 0) nx /= len, ny /= len, nz /= len;
+		face& nf = faces[f];
+		bool const queued = nf.queued; // a reused slot may still be pending
+		nf = face{};
+		nf.queued = queued;
+		nf.plane = vec4<T> (static_cast<T> (nx), static_cast<T> (ny), static_cast<T> (nz),
+		    static_cast<T> (-(nx * ax + ny * ay + nz * az)));
+		nf.alive = true;
+		return f;
+	}
+
+	void queue (std::uint32_t f)
+	{
+		if (faces[f].head == npos || faces[f].queued) return;
+		faces[f].queued = true;
+		pending.push_back (f);
+	}
+
+	// Hands each point in ids to the first of the given faces it lies outside of. Points
+	// inside all of them are inside the hull and dropped.
+	void assign (std::uint32_t const* new_faces, std::size_t face_total)
+	{
+		std::size_t const n = ids.size ();
+		gx.resize (n), gy.resize (n), gz.resize (n), dist.resize (n);
+		taken.assign (n, 0);
+		for (std::size_t i = 0; i < n; i++)
+			gx[i] = px[ids[i]], gy[i] = py[ids[i]], gz[i] = pz[ids[i]];
+
+		for (std::size_t k = 0; k < face_total; k++)
+		{
+			face& f = faces[new_faces[k]];
+			T const a = f.plane.x, b = f.plane.y, c = f.plane.z, w = f.plane.w;
+			T* d = dist.data ();
+			T const* x = gx.data ();
+			T const* y = gy.data ();
+			T const* z = gz.data ();
+			for (std::size_t i = 0; i < n; i++)
+				d[i] = a * x[i] + b * y[i] + c * z[i] + w;
+			for (std::size_t i = 0; i < n; i++)
+			{
+				if (taken[i] || d[i] <= eps) continue;
+				taken[i] = 1;
+				next_point[ids[i]] = f.head;
+				f.head = ids[i];
+				if (d[i] > f.farthest_distance) f.farthest_distance = d[i], f.farthest = ids[i];
+			}
+		}
+	}
+
+	// Index of the largest value over count entries of v, in 8 lanes
+	static std::size_t arg_max (T const* v, std::size_t n)
+	{
+		constexpr std::size_t W = 8;
+		T best[W];
+		std::int32_t index[W];
+		for (std::size_t l = 0; l < W; l++)
+			best[l] = std::numeric_limits<T>::lowest (), index[l] = 0;
+		std::size_t const blocks = n / W;
+		for (std::size_t b = 0; b < blocks; b++)
+			for (std::size_t l = 0; l < W; l++)
+			{
+				T s = v[b * W + l];
+				std::int32_t better = s > best[l];
+				best[l] = better ? s : best[l];
+				index[l] = better ? static_cast<std::int32_t> (b * W + l) : index[l];
+			}
+		for (std::size_t i = blocks * W; i < n; i++)
+			if (v[i] > best[0]) best[0] = v[i], index[0] = static_cast<std::int32_t> (i);
+		std::size_t top = 0;
+		for (std::size_t l = 1; l < W; l++)
+			if (best[l] > best[top] || (best[l] == best[top] && index[l] < index[top])) top = l;
+		return static_cast<std::size_t> (index[top]);
+	}
+
+	// Four points spanning a tetrahedron of positive volume, wound so that the faces
+	// (0 1 2), (0 3 1), (0 2 3) and (1 3 2) face outwards
+	bool initial_simplex (std::uint32_t (&s)[4])
+	{
+		dist.resize (count);
+		T* d = dist.data ();
+		arena_vector<T> const* axes[3] = { &px, &py, &pz };
+		std::uint32_t lo[3], hi[3];
+		T extent = 0;
+		for (int a = 0; a < 3; a++)
+		{
+			T const* v = axes[a]->data ();
+			hi[a] = static_cast<std::uint32_t> (arg_max (v, count));
+			for (std::size_t i = 0; i < count; i++)
+				d[i] = -v[i];
+			lo[a] = static_cast<std::uint32_t> (arg_max (d, count));
+			extent += std::fmax (std::fabs (v[lo[a]]), std::fabs (v[hi[a]]));
+		}
+		eps = 3 * std::numeric_limits<T>::epsilon () * extent;
+
+		// the widest axis pair, then the point furthest from their line and plane
+		int best_axis = 0;
+		T best_span = -1;
+		for (int a = 0; a < 3; a++)
+		{
+			T span = (point (hi[a]) - point (lo[a])).mag_sqrt ();
+			if (span > best_span) best_span = span, best_axis = a;
+		}
+		s[0] = lo[best_axis];
+		s[1] = hi[best_axis];
+		if (std::sqrt (best_span) <= eps) return false;
+
+		vec3<T> const p0 = point (s[0]), dir = normalize (point (s[1]) - p0);
+		for (std::size_t i = 0; i < count; i++)
+		{
+			T x = px[i] - p0.x, y = py[i] - p0.y, z = pz[i] - p0.z;
+			T along = x * dir.x + y * dir.y + z * dir.z;
+			d[i] = x * x + y * y + z * z - along * along;
+		}
+		s[2] = static_cast<std::uint32_t> (arg_max (d, count));
+		if (std::sqrt (std::fmax (d[s[2]], T (0))) <= eps) return false;
+
+		vec3<T> n = normalize (cross (point (s[1]) - p0, point (s[2]) - p0));
+		T const w = -dot (n, p0);
+		for (std::size_t i = 0; i < count; i++)
+			d[i] = std::fabs (n.x * px[i] + n.y * py[i] + n.z * pz[i] + w);
+		s[3] = static_cast<std::uint32_t> (arg_max (d, count));
+		if (d[s[3]] <= eps) return false;
+
+		// keep the fourth point below the first face
+		if (dot (n, point (s[3])) + w > 0) std::swap (s[1], s[2]);
+		return true;
+	}
+
+	std::size_t count;
+	arena_vector<T> px, py, pz;
+	T eps = 0;
+
+	arena_vector<face> faces;
+	arena_vector<std::uint32_t> origin, twin; // per half-edge, edge 3f + k belongs to face f
+	arena_vector<std::uint32_t> free_faces, pending;
+	arena_vector<std::uint32_t> next_point;
+	std::uint32_t stamp = 0;
+
+	// scratch
+	arena_vector<std::uint32_t> ids;
+	arena_vector<T> gx, gy, gz, dist;
+	arena_vector<char> taken;
+	arena_vector<rim_edge> rims;
+	arena_vector<std::uint32_t> horizon, visible, created;
+	arena_vector<std::uint32_t> edge_stack, left_stack;
+};
+} // namespace detail
+
+// Bytes of frame_arena a quickhull over count points needs at most
+template <typename T> std::size_t quickhull_scratch_size (std::size_t count)
+{
+	return detail::quickhull_builder<T>::scratch_size (count);
+}
+
+// Convex hull of count points into out, single threaded. All working memory comes from
+// scratch, which is rewound before returning, and out keeps its capacity, so repeated
+// builds do not allocate. Throws std::bad_alloc when scratch has less room left than
+// quickhull_scratch_size (count).
+template <typename T>
+void quickhull (vec3<T> const* points, std::size_t count, frame_arena& scratch, convex_hull<T>& out)
+{
+	frame_arena::marker const start = scratch.mark ();
+	{
+		detail::quickhull_builder<T> builder (points, count, scratch);
+		if (builder.build ())
+			builder.output (nullptr, out);
+		else
+			out.vertices.clear (), out.triangles.clear (), out.planes.clear ();
+	}
+	scratch.rewind (start);
+}
+
+// Convex hull of count points. Point sets without volume (fewer than four points, or
+// all on one plane) give an empty hull.
+template <typename T>
+convex_hull<T> quickhull (vec3<T> const* points, std::size_t count, unsigned threads = 1)
+{
+	convex_hull<T> out;
+	constexpr std::size_t grain = std::size_t (1) << 15;
+	std::size_t chunks = threads == 0 ? 1 : threads;
+	chunks = std::min (chunks, count / grain);
+	if (chunks <= 1)
+	{
+		frame_arena scratch (quickhull_scratch_size<T> (count));
+		quickhull (points, count, scratch, out);
+		return out;
+	}
+
+	// hulls of the chunks in parallel, then the hull of their vertices
+	std::size_t const per_chunk = (count + chunks - 1) / chunks;
+	std::vector<std::vector<std::uint32_t>> chunk_vertices (chunks);
+	parallel_for (
+	    chunks,
+	    1,
+	    [&] (std::size_t first, std::size_t last) {
+		    for (std::size_t c = first; c < last; c++)
+		    {
+			    std::size_t begin = c * per_chunk;
+			    std::size_t n = std::min (per_chunk, count - begin);
+			    frame_arena scratch (quickhull_scratch_size<T> (n));
+			    detail::quickhull_builder<T> builder (points + begin, n, scratch);
+			    builder.build ();
+			    builder.vertices (chunk_vertices[c], static_cast<std::uint32_t> (begin));
+		    }
+	    },
+	    threads);
+
+	std::vector<std::uint32_t> map;
+	for (auto const& v : chunk_vertices)
+		map.insert (map.end (), v.begin (), v.end ());
+	std::vector<vec3<T>> merged (map.size ());
+	for (std::size_t i = 0; i < map.size (); i++)
+		merged[i] = points[map[i]];
+
+	frame_arena scratch (quickhull_scratch_size<T> (merged.size ()));
+	detail::quickhull_builder<T> builder (merged.data (), merged.size (), scratch);
+	if (builder.build ()) builder.output (map.data (), out);
+	return out;
+}
+
+template <typename T> convex_hull<T> quickhull (std::vector<vec3<T>> const& points, unsigned threads = 1)
+{
+	return quickhull (points.data (), points.size (), threads);
+}
+
+} // namespace cml
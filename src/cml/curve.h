@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "quat.h"
+#include "vec2.h"
+#include "vec3.h"
+#include "vec4.h"
+
+/*
+Cubic curve evaluation for scalars, vec2, vec3, vec4 and vec<N, T>.
+
+Bezier, Hermite, Catmull-Rom and uniform B-spline segments are all converted once
+to power form c0 + c1 t + c2 t^2 + c3 t^3, so evaluating any of them is the same
+three multiply adds per component. Uniform sampling uses forward differencing,
+three adds per sample. An arc length table maps distance along a segment back to
+its parameter for constant speed motion.
+
+Rotations are interpolated with squad, which is smooth across keys unlike
+chained slerps.
+*/
+
+namespace cml
+{
+
+namespace detail
+{
+template <typename V, typename = void> struct scalar_of
+{
+	using type = V;
+};
+template <typename V> struct scalar_of<V, std::void_t<typename V::value_type>>
+{
+	using type = typename V::value_type;
+};
+
+template <typename V> auto norm (V const& v)
+{
+	if constexpr (std::is_arithmetic<V>::value)
+		return v < 0 ? -v : v;
+	else
+		return v.length ();
+}
+} // namespace detail
+
+template <typename V> class cubic
+{
+	public:
+	using scalar = typename detail::scalar_of<V>::type;
+
+	V c[4]; // power form coefficients, f (t) = c[0] + c[1] t + c[2] t^2 + c[3] t^3
+
+	// CONSTRUCTION
+
+	// Starts at p0 towards p1, ends at p3 coming from p2
+	static cubic bezier (V const& p0, V const& p1, V const& p2, V const& p3)
+	{
+		return cubic{ { p0, (p1 - p0) * scalar (3), (p0 - p1 * scalar (2) + p2) * scalar (3),
+			p3 - p0 + (p1 - p2) * scalar (3) } };
+	}
+
+	// From p0 with tangent m0 to p1 with tangent m1
+	static cubic hermite (V const& p0, V const& m0, V const& p1, V const& m1)
+	{
+		return cubic{ { p0, m0, (p1 - p0) * scalar (3) - m0 * scalar (2) - m1, (p0 - p1) * scalar (2) + m0 + m1 } };
+	}
+
+	// Passes through p1 at t = 0 and p2 at t = 1
+	static cubic catmull_rom (V const& p0, V const& p1, V const& p2, V const& p3)
+	{
+		scalar const half = scalar (0.5);
+		return cubic{ { p1, (p2 - p0) * half, (p0 * scalar (2) - p1 * scalar (5) + p2 * scalar (4) - p3) * half,
+			(p3 - p0 + (p1 - p2) * scalar (3)) * half } };
+	}
+
+	// Uniform cubic B-spline segment, approximates the control points with C2 continuity
+	static cubic bspline (V const& p0, V const& p1, V const& p2, V const& p3)
+	{
+		scalar const sixth = scalar (1) / scalar (6);
+		return cubic{ { (p0 + p1 * scalar (4) + p2) * sixth, (p2 - p0) * scalar (0.5),
+			(p0 - p1 * scalar (2) + p2) * scalar (0.5), (p3 - p0 + (p1 - p2) * scalar (3)) * sixth } };
+	}
+
+	// EVALUATION
+
+	V operator() (scalar t) const { return c[0] + (c[1] + (c[2] + c[3] * t) * t) * t; }
+
+	V derivative (scalar t) const { return c[1] + (c[2] * scalar (2) + c[3] * (scalar (3) * t)) * t; }
+
+	// count samples at t = 0, 1 / (count - 1), ... 1 by forward differencing
+	void sample (std::size_t count, V* out) const
+	{
+		if (count == 0) return;
+		if (count == 1)
+		{
+			out[0] = c[0];
+			return;
+		}
+		scalar const h = scalar (1) / static_cast<scalar> (count - 1);
+		scalar const h2 = h * h, h3 = h2 * h;
+		V d0 = c[0];
+		V d1 = c[1] * h + c[2] * h2 + c[3] * h3;
+		V d2 = c[2] * (scalar (2) * h2) + c[3] * (scalar (6) * h3);
+		V const d3 = c[3] * (scalar (6) * h3);
+		for (std::size_t i = 0; i < count; i++)
+		{
+			out[i] = d0;
+			d0 += d1;
+			d1 += d2;
+			d2 += d3;
+		}
+	}
+};
+
+template <typename V> V bezier (V const& p0, V const& p1, V const& p2, V const& p3, typename cubic<V>::scalar t)
+{
+	return cubic<V>::bezier (p0, p1, p2, p3) (t);
+}
+
+template <typename V> V hermite (V const& p0, V const& m0, V const& p1, V const& m1, typename cubic<V>::scalar t)
+{
+	return cubic<V>::hermite (p0, m0, p1, m1) (t);
+}
+
+template <typename V> V catmull_rom (V const& p0, V const& p1, V const& p2, V const& p3, typename cubic<V>::scalar t)
+{
+	return cubic<V>::catmull_rom (p0, p1, p2, p3) (t);
+}
+
+template <typename V> V bspline (V const& p0, V const& p1, V const& p2, V const& p3, typename cubic<V>::scalar t)
+{
+	return cubic<V>::bspline (p0, p1, p2, p3) (t);
+}
+
+// Catmull-Rom path through count points, u runs from 0 at the first point to count - 1 at the last
+template <typename V> V catmull_rom (V const* points, std::size_t count, typename cubic<V>::scalar u)
+{
+	using scalar = typename cubic<V>::scalar;
+	assert (count > 0);
+	if (count == 1) return points[0];
+	scalar const last = static_cast<scalar> (count - 1);
+	u = u < scalar (0) ? scalar (0) : (u > last ? last : u);
+	std::size_t i = static_cast<std::size_t> (u);
+	if (i >= count - 1) i = count - 2;
+	// the end points are repeated to give the first and last segment their outer neighbour
+	V const& p0 = points[i == 0 ? 0 : i - 1];
+	V const& p3 = points[i + 2 < count ? i + 2 : count - 1];
+	return catmull_rom (p0, points[i], points[i + 1], p3, u - static_cast<scalar> (i));
+}
+
+// BATCHED EVALUATION
+
+// out[c * t_count + i] = curves[c] (t[i])
+template <typename V>
+void evaluate (cubic<V> const* curves,
+    std::size_t curve_count,
+    typename cubic<V>::scalar const* t,
+    std::size_t t_count,
+    V* out)
+{
+	for (std::size_t c = 0; c < curve_count; c++)
+	{
+		V const c0 = curves[c].c[0], c1 = curves[c].c[1], c2 = curves[c].c[2], c3 = curves[c].c[3];
+		V* row = out + c * t_count;
+		for (std::size_t i = 0; i < t_count; i++)
+			row[i] = c0 + (c1 + (c2 + c3 * t[i]) * t[i]) * t[i];
+	}
+}
+
+// out[c * count + i] = curves[c] (i / (count - 1)), by forward differencing
+template <typename V> void sample (cubic<V> const* curves, std::size_t curve_count, std::size_t count, V* out)
+{
+	for (std::size_t c = 0; c < curve_count; c++)
+		curves[c].sample (count, out + c * count);
+}
+
+// ARC LENGTH
+
+// Cumulative length of a curve at uniform parameter steps, maps distance to parameter
+template <typename V> class arc_length_table
+{
+	public:
+	using scalar = typename cubic<V>::scalar;
+
+	explicit arc_length_table (cubic<V> const& curve, std::size_t samples = 64)
+	{
+		samples = samples < 2 ? 2 : samples;
+		std::vector<V> points (samples);
+		curve.sample (samples, points.data ());
+		lengths.resize (samples);
+		lengths[0] = scalar (0);
+		for (std::size_t i = 1; i < samples; i++)
+			lengths[i] = lengths[i - 1] + detail::norm (points[i] - points[i - 1]);
+	}
+
+	scalar length () const { return lengths.back (); }
+
+	// Parameter t where the curve has covered distance, clamped to the curve
+	scalar parameter (scalar distance) const
+	{
+		if (distance <= scalar (0)) return scalar (0);
+		if (distance >= length ()) return scalar (1);
+		std::size_t i = static_cast<std::size_t> (
+		    std::upper_bound (lengths.begin (), lengths.end (), distance) - lengths.begin ());
+		scalar const segment = lengths[i] - lengths[i - 1];
+		scalar const frac = segment > scalar (0) ? (distance - lengths[i - 1]) / segment : scalar (0);
+		return (static_cast<scalar> (i - 1) + frac) / static_cast<scalar> (lengths.size () - 1);
+	}
+
+	// count points evenly spaced by distance along the curve
+	void sample_constant_speed (cubic<V> const& curve, std::size_t count, V* out) const
+	{
+		if (count == 0) return;
+		scalar const step = count > 1 ? length () / static_cast<scalar> (count - 1) : scalar (0);
+		for (std::size_t i = 0; i < count; i++)
+			out[i] = curve (parameter (step * static_cast<scalar> (i)));
+	}
+
+	private:
+	std::vector<scalar> lengths;
+};
+
+// SQUAD
+
+namespace detail
+{
+// Logarithm of a unit quaternion, a pure quaternion of axis * half angle
+template <typename T> quat<T> quat_log (quat<T> const& q)
+{
+	vec3<T> v = q.getImag ();
+	T s = v.length ();
+	T theta = std::atan2 (s, q.getReal ());
+	return quat<T> (s > static_cast<T> (1e-6) ? v * (theta / s) : v, 0);
+}
+
+template <typename T> quat<T> quat_exp (quat<T> const& q)
+{
+	vec3<T> v = q.getImag ();
+	T theta = v.length ();
+	T scale = theta > static_cast<T> (1e-6) ? sin (theta) / theta : static_cast<T> (1);
+	return quat<T> (v * scale, cos (theta));
+}
+} // namespace detail
+
+// Inner control rotation of key q between its neighbours prev and next
+template <typename T> quat<T> squad_control (quat<T> prev, quat<T> const& q, quat<T> next)
+{
+	if (dot (q, prev) < 0) prev = -prev;
+	if (dot (q, next) < 0) next = -next;
+	quat<T> inv = ~q;
+	quat<T> sum = detail::quat_log (inv * next) + detail::quat_log (inv * prev);
+	return q * detail::quat_exp (sum * static_cast<T> (-0.25));
+}
+
+// Smooth interpolation from q0 to q1, s0 and s1 are their squad_control rotations
+template <typename T> quat<T> squad (quat<T> const& q0, quat<T> const& q1, quat<T> const& s0, quat<T> const& s1, T t)
+{
+	return slerp (slerp (q0, q1, t), slerp (s0, s1, t), static_cast<T> (2) * t * (static_cast<T> (1) - t));
+}
+
+// Squad through count keys, u runs from 0 at the first key to count - 1 at the last
+template <typename T> quat<T> squad (quat<T> const* keys, std::size_t count, T u)
+{
+	assert (count > 0);
+	if (count == 1) return keys[0];
+	T const last = static_cast<T> (count - 1);
+	u = u < 0 ? static_cast<T> (0) : (u > last ? last : u);
+	std::size_t i = static_cast<std::size_t> (u);
+	if (i >= count - 1) i = count - 2;
+	quat<T> q0 = keys[i], q1 = keys[i + 1];
+	if (dot (q0, q1) < 0) q1 = -q1;
+	quat<T> s0 = squad_control (keys[i == 0 ? 0 : i - 1], q0, q1);
+	quat<T> s1 = squad_control (q0, q1, keys[i + 2 < count ? i + 2 : count - 1]);
+	return squad (q0, q1, s0, s1, u - static_cast<T> (i));
+}
+
+} // namespace cml
@@ -0,0 +1,583 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "common.h"
+
+#if defined(CML_SSE2)
+#include <emmintrin.h>
+#endif
+
+#include "vec2.h"
+#include "vec3.h"
+#include "vec4.h"
+
+/*
+Polynomial exp, exp2, log, log2 and pow for floats, vectors and arrays of either.
+
+exp2 splits x into floor (x) and a fraction f in [0, 1), builds 2^floor (x) in
+the exponent bits and evaluates a minimax polynomial for 2^f. exp does the same
+after reducing x by a two part ln 2, so large inputs keep their precision. log2
+takes the exponent from the bits, moves the mantissa m into [sqrt (1/2), sqrt 2)
+and evaluates t = (m - 1) / (m + 1) times a minimax polynomial in t^2. pow is
+exp2 (y log2 (x)), whose relative error grows with |y log2 (x)| by about 2^-24
+per unit.
+
+precision::accurate is within a few ulp of the exact result. precision::fast
+keeps about 13 bits, enough for colors and falloff curves, and saves half the
+polynomial terms. Infinities, NaN and zero behave like the standard library, except
+that exp and exp2 flush results below the smallest normal float to zero and pow
+of a negative base is NaN. Use the integer exponent pow for negative bases.
+
+With SSE2 arrays are processed four floats at a time and single values go through
+the same code, so they give the same results. vec3<float> has a padding lane
+which is computed and stored along with the others. The scalar versions without
+SSE2 use the same polynomials.
+*/
+
+namespace cml
+{
+
+enum class precision
+{
+	fast,
+	accurate
+};
+
+namespace detail
+{
+// minimax 2^f on [0, 1), relative error 7.5e-5 and 1.9e-9
+constexpr float exp2_fast[4] = { 0.9999252186f, 0.6958335405f, 0.2260671554f, 0.07802452266f };
+constexpr float exp2_accurate[7] = { 1.000000002f, 0.6931469838f, 0.2402298363f, 0.05548334198f,
+	0.009678840996f, 0.001243968783f, 0.0002170225546f };
+
+// minimax log2 ((1 + t) / (1 - t)) / t in u = t^2 for |t| <= 3 - 2 sqrt 2,
+// relative error 2.2e-5 and 6.9e-10
+constexpr float log2_fast[2] = { 2.88532587f, 0.979128065f };
+constexpr float log2_accurate[4] = { 2.88539008f, 0.961798848f, 0.576714384f, 0.431735879f };
+
+constexpr float log2_e = 1.44269504089f;
+constexpr float ln_2 = 0.69314718056f;
+// ln 2 in two parts, k ln2_hi is exact for the exponents of finite results
+constexpr float ln2_hi = 0.693359375f, ln2_lo = -2.12194440e-4f;
+constexpr float sqrt_2 = 1.41421356237f;
+
+template <precision P> inline float exp2_poly (float f)
+{
+	constexpr int n = P == precision::fast ? 4 : 7;
+	float const* c = P == precision::fast ? exp2_fast : exp2_accurate;
+	float p = c[n - 1];
+	for (int k = n - 2; k >= 0; k--)
+		p = p * f + c[k];
+	return p;
+}
+
+template <precision P> inline float log2_poly (float u)
+{
+	constexpr int n = P == precision::fast ? 2 : 4;
+	float const* c = P == precision::fast ? log2_fast : log2_accurate;
+	float p = c[n - 1];
+	for (int k = n - 2; k >= 0; k--)
+		p = p * u + c[k];
+	return p;
+}
+
+inline float bits_float (std::uint32_t bits)
+{
+	float f;
+	std::memcpy (&f, &bits, sizeof f);
+	return f;
+}
+
+inline std::uint32_t float_bits (float f)
+{
+	std::uint32_t bits;
+	std::memcpy (&bits, &f, sizeof bits);
+	return bits;
+}
+
+// 2^(i + f) for f about in [0, 1), saturating outside of the normal exponents
+template <precision P> inline float scale_exp2 (float i, float f)
+{
+	if (i >= 128.f) return std::numeric_limits<float>::infinity ();
+	if (i < -126.f) return 0.f;
+	std::uint32_t const bits = static_cast<std::uint32_t> (static_cast<int> (i) + 127) << 23;
+	return exp2_poly<P> (f) * bits_float (bits);
+}
+
+template <precision P> inline float exp2_scalar (float x)
+{
+	if (x != x) return x;
+	float const i = std::floor (min (max (x, -127.f), 128.f));
+	return scale_exp2<P> (i, x - i);
+}
+
+template <precision P> inline float exp_scalar (float x)
+{
+	if (x != x) return x;
+	float const i = std::floor (min (max (x * log2_e, -127.f), 128.f));
+	float const r = (x - i * ln2_hi) - i * ln2_lo;
+	return scale_exp2<P> (i, r * log2_e);
+}
+
+template <precision P> inline float log2_scalar (float x)
+{
+	if (x == 0.f) return -std::numeric_limits<float>::infinity ();
+	if (!(x > 0.f)) return std::numeric_limits<float>::quiet_NaN ();
+	if (x == std::numeric_limits<float>::infinity ()) return x;
+	float e = 0.f;
+	if (x < std::numeric_limits<float>::min ())
+	{
+		x *= 8388608.f; // 2^23
+		e = -23.f;
+	}
+	std::uint32_t const bits = float_bits (x);
+	e += static_cast<float> (static_cast<int> (bits >> 23) - 127);
+	float m = bits_float ((bits & 0x007fffffu) | 0x3f800000u);
+	if (m > sqrt_2)
+	{
+		m *= 0.5f;
+		e += 1.f;
+	}
+	float const t = (m - 1.f) / (m + 1.f);
+	return e + t * log2_poly<P> (t * t);
+}
+
+template <precision P> inline float pow_scalar (float x, float y)
+{
+	// like std::pow, 1 to any power is 1 even for a NaN or infinite exponent
+	if (y == 0.f || x == 1.f) return 1.f;
+	return exp2_scalar<P> (y * log2_scalar<P> (x));
+}
+
+inline unsigned magnitude (int n)
+{
+	return n < 0 ? 0u - static_cast<unsigned> (n) : static_cast<unsigned> (n);
+}
+
+inline float powi_scalar (float x, int n)
+{
+	float r = 1.f;
+	for (unsigned k = magnitude (n); k != 0; k >>= 1)
+	{
+		if (k & 1u) r *= x;
+		x *= x;
+	}
+	return n < 0 ? 1.f / r : r;
+}
+
+#if defined(CML_SSE2)
+inline __m128 select_ps (__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b));
+}
+
+// NaN becomes -127
+inline __m128 clamp_exponent (__m128 x)
+{
+	return _mm_min_ps (_mm_max_ps (x, _mm_set1_ps (-127.f)), _mm_set1_ps (128.f));
+}
+
+inline __m128 floor_ps (__m128 x)
+{
+	__m128 const t = _mm_cvtepi32_ps (_mm_cvttps_epi32 (x));
+	return _mm_sub_ps (t, _mm_and_ps (_mm_cmplt_ps (x, t), _mm_set1_ps (1.f)));
+}
+
+template <precision P> inline __m128 exp2_poly (__m128 f)
+{
+	constexpr int n = P == precision::fast ? 4 : 7;
+	float const* c = P == precision::fast ? exp2_fast : exp2_accurate;
+	__m128 p = _mm_set1_ps (c[n - 1]);
+	for (int k = n - 2; k >= 0; k--)
+		p = _mm_add_ps (_mm_mul_ps (p, f), _mm_set1_ps (c[k]));
+	return p;
+}
+
+template <precision P> inline __m128 log2_poly (__m128 u)
+{
+	constexpr int n = P == precision::fast ? 2 : 4;
+	float const* c = P == precision::fast ? log2_fast : log2_accurate;
+	__m128 p = _mm_set1_ps (c[n - 1]);
+	for (int k = n - 2; k >= 0; k--)
+		p = _mm_add_ps (_mm_mul_ps (p, u), _mm_set1_ps (c[k]));
+	return p;
+}
+
+// 2^(i + f) for integral i, x is the input only for NaN
+template <precision P> inline __m128 scale_exp2 (__m128 i, __m128 f, __m128 x)
+{
+	__m128 const over = _mm_cmpge_ps (i, _mm_set1_ps (128.f));
+	__m128 const under = _mm_cmplt_ps (i, _mm_set1_ps (-126.f));
+	__m128 const in_range = _mm_min_ps (_mm_max_ps (i, _mm_set1_ps (-126.f)), _mm_set1_ps (127.f));
+	__m128i const e = _mm_add_epi32 (_mm_cvttps_epi32 (in_range), _mm_set1_epi32 (127));
+	__m128 r = _mm_mul_ps (exp2_poly<P> (f), _mm_castsi128_ps (_mm_slli_epi32 (e, 23)));
+	__m128 const inf = _mm_set1_ps (std::numeric_limits<float>::infinity ());
+	r = select_ps (over, inf, _mm_andnot_ps (under, r));
+	return _mm_or_ps (r, _mm_cmpunord_ps (x, x));
+}
+
+template <precision P> inline __m128 exp2_ps (__m128 x)
+{
+	__m128 const i = floor_ps (clamp_exponent (x));
+	return scale_exp2<P> (i, _mm_sub_ps (x, i), x);
+}
+
+template <precision P> inline __m128 exp_ps (__m128 x)
+{
+	__m128 const y = _mm_mul_ps (x, _mm_set1_ps (log2_e));
+	__m128 const i = floor_ps (clamp_exponent (y));
+	__m128 r = _mm_sub_ps (x, _mm_mul_ps (i, _mm_set1_ps (ln2_hi)));
+	r = _mm_sub_ps (r, _mm_mul_ps (i, _mm_set1_ps (ln2_lo)));
+	return scale_exp2<P> (i, _mm_mul_ps (r, _mm_set1_ps (log2_e)), x);
+}
+
+template <precision P> inline __m128 log2_ps (__m128 x)
+{
+	__m128 const denormal = _mm_cmplt_ps (x, _mm_set1_ps (std::numeric_limits<float>::min ()));
+	__m128 const xs = select_ps (denormal, _mm_mul_ps (x, _mm_set1_ps (8388608.f)), x);
+	__m128i const bits = _mm_castps_si128 (xs);
+	__m128 e = _mm_cvtepi32_ps (_mm_sub_epi32 (_mm_srli_epi32 (bits, 23), _mm_set1_epi32 (127)));
+	e = _mm_sub_ps (e, _mm_and_ps (denormal, _mm_set1_ps (23.f)));
+	__m128i const mantissa = _mm_and_si128 (bits, _mm_set1_epi32 (0x007fffff));
+	__m128 m = _mm_castsi128_ps (_mm_or_si128 (mantissa, _mm_set1_epi32 (0x3f800000)));
+	__m128 const big = _mm_cmpgt_ps (m, _mm_set1_ps (sqrt_2));
+	m = select_ps (big, _mm_mul_ps (m, _mm_set1_ps (0.5f)), m);
+	e = _mm_add_ps (e, _mm_and_ps (big, _mm_set1_ps (1.f)));
+	__m128 const one = _mm_set1_ps (1.f);
+	__m128 const t = _mm_div_ps (_mm_sub_ps (m, one), _mm_add_ps (m, one));
+	__m128 r = _mm_add_ps (e, _mm_mul_ps (t, log2_poly<P> (_mm_mul_ps (t, t))));
+
+	__m128 const inf = _mm_set1_ps (std::numeric_limits<float>::infinity ());
+	r = select_ps (_mm_cmpeq_ps (x, inf), inf, r);
+	r = select_ps (_mm_cmpeq_ps (x, _mm_setzero_ps ()), _mm_sub_ps (_mm_setzero_ps (), inf), r);
+	// negative and NaN
+	return _mm_or_ps (r, _mm_cmpnge_ps (x, _mm_setzero_ps ()));
+}
+
+template <precision P> inline __m128 pow_ps (__m128 x, __m128 y)
+{
+	__m128 const r = exp2_ps<P> (_mm_mul_ps (y, log2_ps<P> (x)));
+	__m128 const one = _mm_set1_ps (1.f);
+	return select_ps (_mm_or_ps (_mm_cmpeq_ps (y, _mm_setzero_ps ()), _mm_cmpeq_ps (x, one)), one, r);
+}
+
+inline __m128 powi_ps (__m128 x, int n)
+{
+	__m128 r = _mm_set1_ps (1.f);
+	for (unsigned k = magnitude (n); k != 0; k >>= 1)
+	{
+		if (k & 1u) r = _mm_mul_ps (r, x);
+		x = _mm_mul_ps (x, x);
+	}
+	return n < 0 ? _mm_div_ps (_mm_set1_ps (1.f), r) : r;
+}
+
+template <precision P> inline __m128 log_ps (__m128 x)
+{
+	return _mm_mul_ps (log2_ps<P> (x), _mm_set1_ps (ln_2));
+}
+#endif
+
+template <precision P> inline float log_scalar (float x) { return log2_scalar<P> (x) * ln_2; }
+
+// One function object per operation, on four floats with SSE2 and on one without
+
+#if defined(CML_SSE2)
+#define CML_EXP_LOG_OP(name)                                                                      \
+	template <precision P> struct name##_op                                                       \
+	{                                                                                             \
+		__m128 operator() (__m128 x) const { return name##_ps<P> (x); }                           \
+	};
+#else
+#define CML_EXP_LOG_OP(name)                                                                      \
+	template <precision P> struct name##_op                                                       \
+	{                                                                                             \
+		float operator() (float x) const { return name##_scalar<P> (x); }                         \
+	};
+#endif
+CML_EXP_LOG_OP (exp2)
+CML_EXP_LOG_OP (exp)
+CML_EXP_LOG_OP (log2)
+CML_EXP_LOG_OP (log)
+#undef CML_EXP_LOG_OP
+
+template <precision P> struct pow_op
+{
+#if defined(CML_SSE2)
+	__m128 operator() (__m128 x, __m128 y) const { return pow_ps<P> (x, y); }
+#else
+	float operator() (float x, float y) const { return pow_scalar<P> (x, y); }
+#endif
+};
+
+// out[i] = f (in[i])
+template <typename F> void map (float const* in, float* out, std::size_t count, F f)
+{
+	std::size_t i = 0;
+#if defined(CML_SSE2)
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps (out + i, f (_mm_loadu_ps (in + i)));
+	if (i < count)
+	{
+		// the tail goes through the same code as the rest
+		float tail[4] = { 1.f, 1.f, 1.f, 1.f };
+		std::memcpy (tail, in + i, (count - i) * sizeof (float));
+		_mm_storeu_ps (tail, f (_mm_loadu_ps (tail)));
+		std::memcpy (out + i, tail, (count - i) * sizeof (float));
+	}
+#else
+	for (; i < count; i++)
+		out[i] = f (in[i]);
+#endif
+}
+
+// out[i] = f (a[i], b[i])
+template <typename F> void map (float const* a, float const* b, float* out, std::size_t count, F f)
+{
+	std::size_t i = 0;
+#if defined(CML_SSE2)
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps (out + i, f (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i)));
+	if (i < count)
+	{
+		float ta[4] = { 1.f, 1.f, 1.f, 1.f }, tb[4] = { 1.f, 1.f, 1.f, 1.f };
+		std::memcpy (ta, a + i, (count - i) * sizeof (float));
+		std::memcpy (tb, b + i, (count - i) * sizeof (float));
+		_mm_storeu_ps (ta, f (_mm_loadu_ps (ta), _mm_loadu_ps (tb)));
+		std::memcpy (out + i, ta, (count - i) * sizeof (float));
+	}
+#else
+	for (; i < count; i++)
+		out[i] = f (a[i], b[i]);
+#endif
+}
+
+template <template <precision> class Op>
+void map (precision p, float const* in, float* out, std::size_t count)
+{
+	if (p == precision::fast)
+		map (in, out, count, Op<precision::fast> ());
+	else
+		map (in, out, count, Op<precision::accurate> ());
+}
+
+// base^y for a whole exponent by repeated squaring
+struct powi_op
+{
+	int y;
+#if defined(CML_SSE2)
+	__m128 operator() (__m128 x) const { return powi_ps (x, y); }
+#else
+	float operator() (float x) const { return powi_scalar (x, y); }
+#endif
+};
+
+// base^y for one exponent
+template <precision P> struct pow_const_op
+{
+	float y;
+#if defined(CML_SSE2)
+	__m128 operator() (__m128 x) const { return pow_ps<P> (x, _mm_set1_ps (y)); }
+#else
+	float operator() (float x) const { return pow_scalar<P> (x, y); }
+#endif
+};
+
+template <typename V> struct is_float_vector : std::false_type
+{
+};
+template <> struct is_float_vector<vec2<float>> : std::true_type
+{
+};
+template <> struct is_float_vector<vec3<float>> : std::true_type
+{
+};
+template <> struct is_float_vector<vec4<float>> : std::true_type
+{
+};
+
+// floats per element of an array of V, vec3<float> includes its padding lane
+template <typename V> constexpr std::size_t lanes = sizeof (V) / sizeof (float);
+
+template <template <precision> class Op, typename V> V map_one (precision p, V const& v)
+{
+	static_assert (sizeof (V) <= 4 * sizeof (float), "more than one register");
+	float in[4] = { 1.f, 1.f, 1.f, 1.f };
+	float out[4];
+	std::memcpy (in, &v, sizeof v);
+	map<Op> (p, in, out, 4);
+	V r;
+	std::memcpy (&r, out, sizeof r);
+	return r;
+}
+} // namespace detail
+
+// ARRAYS
+
+// out[i] = 2^in[i], in and out may be the same array
+inline void exp2 (float const* in, float* out, std::size_t count, precision p = precision::accurate)
+{
+	detail::map<detail::exp2_op> (p, in, out, count);
+}
+
+// out[i] = e^in[i]
+inline void exp (float const* in, float* out, std::size_t count, precision p = precision::accurate)
+{
+	detail::map<detail::exp_op> (p, in, out, count);
+}
+
+// out[i] = log2 (in[i])
+inline void log2 (float const* in, float* out, std::size_t count, precision p = precision::accurate)
+{
+	detail::map<detail::log2_op> (p, in, out, count);
+}
+
+// out[i] = ln (in[i])
+inline void log (float const* in, float* out, std::size_t count, precision p = precision::accurate)
+{
+	detail::map<detail::log_op> (p, in, out, count);
+}
+
+// out[i] = base[i]^exponent[i]
+inline void pow (float const* base,
+    float const* exponent,
+    float* out,
+    std::size_t count,
+    precision p = precision::accurate)
+{
+	if (p == precision::fast)
+		detail::map (base, exponent, out, count, detail::pow_op<precision::fast> ());
+	else
+		detail::map (base, exponent, out, count, detail::pow_op<precision::accurate> ());
+}
+
+// out[i] = base[i]^exponent by repeated squaring, which also works for negative bases
+inline void pow (float const* base, float* out, std::size_t count, int exponent)
+{
+	detail::map (base, out, count, detail::powi_op{ exponent });
+}
+
+// out[i] = base[i]^exponent, whole exponents take the repeated squaring path and 1/2 is a
+// square root
+inline void pow (float const* base,
+    float* out,
+    std::size_t count,
+    float exponent,
+    precision p = precision::accurate)
+{
+	if (exponent == std::floor (exponent) && std::fabs (exponent) <= 64.f)
+		pow (base, out, count, static_cast<int> (exponent));
+	else if (exponent == 0.5f)
+		for (std::size_t i = 0; i < count; i++)
+			out[i] = std::sqrt (base[i]);
+	else if (p == precision::fast)
+		detail::map (base, out, count, detail::pow_const_op<precision::fast>{ exponent });
+	else
+		detail::map (base, out, count, detail::pow_const_op<precision::accurate>{ exponent });
+}
+
+// Arrays of vec2<float>, vec3<float> or vec4<float>, component by component
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+void exp2 (V const* in, V* out, std::size_t count, precision p = precision::accurate)
+{
+	exp2 (&in->x, &out->x, count * detail::lanes<V>, p);
+}
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+void exp (V const* in, V* out, std::size_t count, precision p = precision::accurate)
+{
+	exp (&in->x, &out->x, count * detail::lanes<V>, p);
+}
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+void log2 (V const* in, V* out, std::size_t count, precision p = precision::accurate)
+{
+	log2 (&in->x, &out->x, count * detail::lanes<V>, p);
+}
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+void log (V const* in, V* out, std::size_t count, precision p = precision::accurate)
+{
+	log (&in->x, &out->x, count * detail::lanes<V>, p);
+}
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+void pow (
+    V const* base, V const* exponent, V* out, std::size_t count, precision p = precision::accurate)
+{
+	pow (&base->x, &exponent->x, &out->x, count * detail::lanes<V>, p);
+}
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+void pow (
+    V const* base, V* out, std::size_t count, float exponent, precision p = precision::accurate)
+{
+	pow (&base->x, &out->x, count * detail::lanes<V>, exponent, p);
+}
+
+// SINGLE VALUES
+
+// The precision argument is required, so that the calls without it keep using the
+// standard library versions.
+
+inline float exp2 (float x, precision p) { return detail::map_one<detail::exp2_op> (p, x); }
+inline float exp (float x, precision p) { return detail::map_one<detail::exp_op> (p, x); }
+inline float log2 (float x, precision p) { return detail::map_one<detail::log2_op> (p, x); }
+inline float log (float x, precision p) { return detail::map_one<detail::log_op> (p, x); }
+
+inline float pow (float base, float exponent, precision p)
+{
+	float out;
+	pow (&base, &exponent, &out, 1, p);
+	return out;
+}
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+V exp2 (V const& v, precision p)
+{
+	return detail::map_one<detail::exp2_op> (p, v);
+}
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+V exp (V const& v, precision p)
+{
+	return detail::map_one<detail::exp_op> (p, v);
+}
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+V log2 (V const& v, precision p)
+{
+	return detail::map_one<detail::log2_op> (p, v);
+}
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+V log (V const& v, precision p)
+{
+	return detail::map_one<detail::log_op> (p, v);
+}
+
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+V pow (V const& base, V const& exponent, precision p)
+{
+	V out;
+	pow (&base, &exponent, &out, 1, p);
+	return out;
+}
+
+// base^exponent for every component, with the fast paths for whole exponents and 1/2
+template <typename V, std::enable_if_t<detail::is_float_vector<V>::value, int> = 0>
+V pow (V const& base, float exponent, precision p)
+{
+	V out;
+	pow (&base, &out, 1, exponent, p);
+	return out;
+}
+
+} // namespace cml
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "common.h"
+
+/*
+Deterministic fixed point scalar.
+
+fixed<Bits, Frac> stores a signed Bits wide integer with Frac fractional bits.
+Every operation, including sqrt, rsqrt, sin and cos, is done with integer math
+only, so results are bit identical on every machine and compiler. vec2/3/4,
+mat3/mat4 and quat can be instantiated with it directly; the library's sqrt and
+trig calls pick up the overloads below.
+
+Conversion from float and double is meant for constants and input. Conversion
+back is explicit.
+
+The 64 bit variants need a 128 bit integer type (GCC and Clang).
+*/
+
+namespace cml
+{
+
+namespace detail
+{
+template <int Bits> struct fixed_storage;
+template <> struct fixed_storage<32>
+{
+	using raw = std::int32_t;
+	using wide = std::int64_t;
+	using uwide = std::uint64_t;
+};
+#if defined(__SIZEOF_INT128__)
+template <> struct fixed_storage<64>
+{
+	using raw = std::int64_t;
+	__extension__ typedef __int128 wide;
+	__extension__ typedef unsigned __int128 uwide;
+};
+#endif
+
+// Bitwise integer square root, exact floor(sqrt(n))
+template <typename U> constexpr U isqrt (U n)
+{
+	U res = 0;
+	U bit = U (1) << (sizeof (U) * 8 - 2);
+	while (bit > n)
+		bit >>= 2;
+	while (bit != 0)
+	{
+		if (n >= res + bit)
+		{
+			n -= res + bit;
+			res = (res >> 1) + bit;
+		}
+		else
+		{
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return res;
+}
+} // namespace detail
+
+template <int Bits, int Frac> class fixed
+{
+	static_assert (Frac > 0 && Frac < Bits - 1, "need at least one fractional and one integer bit");
+
+	using storage = detail::fixed_storage<Bits>;
+
+	public:
+	using raw_type = typename storage::raw;
+	using wide_type = typename storage::wide;
+
+	static constexpr int bits = Bits;
+	static constexpr int frac_bits = Frac;
+	static constexpr raw_type one_raw = raw_type (1) << Frac;
+
+	constexpr fixed () noexcept {}
+
+	template <typename I, std::enable_if_t<std::is_integral_v<I>, int> = 0>
+	constexpr fixed (I val) noexcept : value (static_cast<raw_type> (val) * one_raw)
+	{
+	}
+
+	template <typename F, std::enable_if_t<std::is_floating_point_v<F>, int> = 0>
+	constexpr fixed (F val) noexcept
+	: value (static_cast<raw_type> (val * static_cast<F> (one_raw) + (val < 0 ? F (-0.5) : F (0.5))))
+	{
+	}
+
+	static constexpr fixed from_raw (raw_type raw)
+	{
+		fixed out;
+		out.value = raw;
+		return out;
+	}
+
+	constexpr raw_type raw () const { return value; }
+
+	template <typename F, std::enable_if_t<std::is_floating_point_v<F>, int> = 0>
+	constexpr explicit operator F () const
+	{
+		return static_cast<F> (value) / static_cast<F> (one_raw);
+	}
+
+	template <typename I, std::enable_if_t<std::is_integral_v<I>, int> = 0>
+	constexpr explicit operator I () const
+	{
+		return static_cast<I> (value / one_raw);
+	}
+
+	// ARITHMETIC
+
+	constexpr fixed operator- () const { return from_raw (-value); }
+
+	constexpr fixed& operator+= (fixed const val)
+	{
+		value += val.value;
+		return *this;
+	}
+	constexpr fixed& operator-= (fixed const val)
+	{
+		value -= val.value;
+		return *this;
+	}
+	// rounds to nearest
+	constexpr fixed& operator*= (fixed const val)
+	{
+		wide_type prod = static_cast<wide_type> (value) * val.value;
+		value = static_cast<raw_type> ((prod + (wide_type (1) << (Frac - 1))) >> Frac);
+		return *this;
+	}
+	// truncates towards zero
+	constexpr fixed& operator/= (fixed const val)
+	{
+		assert (val.value != 0);
+		value = static_cast<raw_type> ((static_cast<wide_type> (value) * one_raw) / val.value);
+		return *this;
+	}
+
+	friend constexpr fixed operator+ (fixed a, fixed const b) { return a += b; }
+	friend constexpr fixed operator- (fixed a, fixed const b) { return a -= b; }
+	friend constexpr fixed operator* (fixed a, fixed const b) { return a *= b; }
+	friend constexpr fixed operator/ (fixed a, fixed const b) { return a /= b; }
+
+	// COMPARISON
+
+	friend constexpr bool operator== (fixed const a, fixed const b) { return a.value == b.value; }
+	friend constexpr bool operator!= (fixed const a, fixed const b) { return a.value != b.value; }
+	friend constexpr bool operator< (fixed const a, fixed const b) { return a.value < b.value; }
+	friend constexpr bool operator<= (fixed const a, fixed const b) { return a.value <= b.value; }
+	friend constexpr bool operator> (fixed const a, fixed const b) { return a.value > b.value; }
+	friend constexpr bool operator>= (fixed const a, fixed const b) { return a.value >= b.value; }
+
+	private:
+	raw_type value = 0;
+};
+
+using fixed32 = fixed<32, 16>;
+#if defined(__SIZEOF_INT128__)
+using fixed64 = fixed<64, 32>;
+#endif
+
+template <int B, int F> constexpr fixed<B, F> abs (fixed<B, F> const val)
+{
+	return val.raw () < 0 ? -val : val;
+}
+
+// ROOTS
+
+template <int B, int F> constexpr fixed<B, F> sqrt (fixed<B, F> const val)
+{
+	assert (val.raw () >= 0);
+	if (val.raw () <= 0) return fixed<B, F> ();
+	using uwide = typename detail::fixed_storage<B>::uwide;
+	uwide scaled = static_cast<uwide> (val.raw ()) << F;
+	return fixed<B, F>::from_raw (static_cast<typename fixed<B, F>::raw_type> (detail::isqrt (scaled)));
+}
+
+template <int B, int F> constexpr fixed<B, F> rsqrt (fixed<B, F> const val)
+{
+	return fixed<B, F> (1) / sqrt (val);
+}
+
+// TRIG
+
+// Angles in radians. Reduced to [-pi/2, pi/2] then evaluated with a fixed
+// odd polynomial, accurate to a few ulp for up to 32 fractional bits.
+template <int B, int F> constexpr fixed<B, F> sin (fixed<B, F> val)
+{
+	using fx = fixed<B, F>;
+	constexpr fx pi = fx (PI);
+	constexpr fx half_pi = fx (PI / 2.0);
+	constexpr fx two_pi = fx (2.0 * PI);
+
+	typename fx::raw_type r = val.raw () % two_pi.raw ();
+	if (r > pi.raw ()) r -= two_pi.raw ();
+	if (r < -pi.raw ()) r += two_pi.raw ();
+	fx x = fx::from_raw (r);
+
+	if (x > half_pi) x = pi - x;
+	if (x < -half_pi) x = -pi - x;
+
+	fx x2 = x * x;
+	fx poly = fx (-1.0 / 1307674368000.0);
+	poly = poly * x2 + fx (1.0 / 6227020800.0);
+	poly = poly * x2 + fx (-1.0 / 39916800.0);
+	poly = poly * x2 + fx (1.0 / 362880.0);
+	poly = poly * x2 + fx (-1.0 / 5040.0);
+	poly = poly * x2 + fx (1.0 / 120.0);
+	poly = poly * x2 + fx (-1.0 / 6.0);
+	return x + x * x2 * poly;
+}
+
+template <int B, int F> constexpr fixed<B, F> cos (fixed<B, F> const val)
+{
+	return sin (val + fixed<B, F> (PI / 2.0));
+}
+
+template <int B, int F> constexpr fixed<B, F> tan (fixed<B, F> const val)
+{
+	return sin (val) / cos (val);
+}
+
+} // namespace cml
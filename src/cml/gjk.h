@@ -0,0 +1,570 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "obb.h"
+#include "vec3.h"
+
+/*
+Convex collision queries between support mapped shapes.
+
+A shape only has to provide support (shape, d), its furthest point in direction d.
+Spheres, capsules, oriented boxes (obb) and convex point sets are built in, other
+shapes can add their own overload. The point set support scans the vertices in
+8 lanes of dot products.
+
+gjk_overlap and gjk_distance run GJK on the Minkowski difference a - b. gjk_epa
+expands the final GJK simplex into a polytope to find the penetration depth
+when the shapes overlap. Spheres and capsules take part as their center point
+or segment and add their radius at the end, GJK and EPA converge slowly on
+curved surfaces.
+
+A gjk_cache keeps the last search direction of a pair. Fed back in on the next
+frame it usually is still a separating axis, which gjk_overlap confirms with a
+single support call per shape.
+*/
+
+namespace cml
+{
+
+// SHAPES
+
+struct sphere
+{
+	vec3<float> center;
+	float radius = 0.f;
+};
+
+// Segment from a to b swept by a sphere
+struct capsule
+{
+	vec3<float> a, b;
+	float radius = 0.f;
+};
+
+// Convex hull of a span of points, the points themselves don't have to be the hull
+struct convex_points
+{
+	vec3<float> const* points = nullptr;
+	std::size_t count = 0;
+};
+
+inline vec3<float> support (sphere const& s, vec3<float> const& d)
+{
+	float len = d.length ();
+	return len > 0.f ? s.center + d * (s.radius / len) : s.center;
+}
+
+inline vec3<float> support (capsule const& c, vec3<float> const& d)
+{
+	float len = d.length ();
+	vec3<float> end = dot (d, c.b - c.a) > 0.f ? c.b : c.a;
+	return len > 0.f ? end + d * (c.radius / len) : end;
+}
+
+inline vec3<float> support (obb<float> const& box, vec3<float> const& d)
+{
+	vec3<float> out = box.center;
+	for (int i = 0; i < 3; i++)
+	{
+		vec3<float> axis = box.axis (i);
+		out += axis * (dot (d, axis) >= 0.f ? box.half_extent.get (i) : -box.half_extent.get (i));
+	}
+	return out;
+}
+
+inline vec3<float> support (convex_points const& hull, vec3<float> const& d)
+{
+	assert (hull.count > 0);
+	constexpr std::size_t W = 8;
+	float best[W];
+	std::int32_t index[W];
+	for (std::size_t l = 0; l < W; l++)
+		best[l] = std::numeric_limits<float>::lowest (), index[l] = 0;
+
+	std::size_t const blocks = hull.count / W;
+	for (std::size_t b = 0; b < blocks; b++)
+	{
+		vec3<float> const* p = hull.points + b * W;
+		for (std::size_t l = 0; l < W; l++)
+		{
+			float s = p[l].x * d.x + p[l].y * d.y + p[l].z * d.z;
+			std::int32_t better = s > best[l];
+			best[l] = better ? s : best[l];
+			index[l] = better ? static_cast<std::int32_t> (b * W + l) : index[l];
+		}
+	}
+	for (std::size_t i = blocks * W; i < hull.count; i++)
+	{
+		float s = dot (hull.points[i], d);
+		if (s > best[0]) best[0] = s, index[0] = static_cast<std::int32_t> (i);
+	}
+
+	std::size_t top = 0;
+	for (std::size_t l = 1; l < W; l++)
+		if (best[l] > best[top]) top = l;
+	return hull.points[index[top]];
+}
+
+// QUERIES
+
+// Search direction of the previous query of a pair of shapes
+struct gjk_cache
+{
+	vec3<float> direction = vec3<float> (1.f, 0.f, 0.f);
+};
+
+struct gjk_result
+{
+	bool overlap = false;
+	float distance = 0.f; // zero when overlapping
+	vec3<float> point_a; // closest points, only valid when not overlapping
+	vec3<float> point_b;
+	int iterations = 0;
+};
+
+struct penetration
+{
+	bool overlap = false;
+	float depth = 0.f;
+	vec3<float> normal; // from a towards b, moving b by normal * depth separates the shapes
+	vec3<float> point_a; // deepest point of a inside b
+	vec3<float> point_b; // deepest point of b inside a
+};
+
+namespace detail
+{
+struct simplex_vertex
+{
+	vec3<float> w, a, b; // w = a - b
+};
+
+struct simplex
+{
+	simplex_vertex v[4];
+	float bary[4];
+	int size = 0;
+
+	void set (std::initializer_list<int> keep, std::initializer_list<float> weights)
+	{
+		simplex_vertex old[4] = { v[0], v[1], v[2], v[3] };
+		size = 0;
+		auto weight = weights.begin ();
+		for (int i : keep)
+		{
+			v[size] = old[i];
+			bary[size++] = *weight++;
+		}
+	}
+
+	vec3<float> point_a () const
+	{
+		vec3<float> p;
+		for (int i = 0; i < size; i++)
+			p += v[i].a * bary[i];
+		return p;
+	}
+
+	vec3<float> point_b () const
+	{
+		vec3<float> p;
+		for (int i = 0; i < size; i++)
+			p += v[i].b * bary[i];
+		return p;
+	}
+};
+
+template <typename A, typename B> simplex_vertex support_vertex (A const& a, B const& b, vec3<float> const& d)
+{
+	simplex_vertex out;
+	out.a = support (a, d);
+	out.b = support (b, -d);
+	out.w = out.a - out.b;
+	return out;
+}
+
+inline vec3<float> closest_segment (simplex& s)
+{
+	vec3<float> a = s.v[0].w, ab = s.v[1].w - a;
+	float len2 = dot (ab, ab);
+	float t = len2 > 0.f ? -dot (a, ab) / len2 : 0.f;
+	if (t <= 0.f)
+	{
+		s.set ({ 0 }, { 1.f });
+		return a;
+	}
+	if (t >= 1.f)
+	{
+		s.set ({ 1 }, { 1.f });
+		return s.v[0].w;
+	}
+	s.bary[0] = 1.f - t, s.bary[1] = t;
+	return a + ab * t;
+}
+
+// Closest point of triangle v[i], v[j], v[k] to the origin by Voronoi regions, reduces
+// the simplex to the feature it lies on
+inline vec3<float> closest_triangle (simplex& s, int i, int j, int k)
+{
+	vec3<float> a = s.v[i].w, b = s.v[j].w, c = s.v[k].w;
+	vec3<float> ab = b - a, ac = c - a;
+	float d1 = -dot (ab, a), d2 = -dot (ac, a);
+	if (d1 <= 0.f && d2 <= 0.f)
+	{
+		s.set ({ i }, { 1.f });
+		return a;
+	}
+	float d3 = -dot (ab, b), d4 = -dot (ac, b);
+	if (d3 >= 0.f && d4 <= d3)
+	{
+		s.set ({ j }, { 1.f });
+		return b;
+	}
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+	{
+		float t = d1 / (d1 - d3);
+		s.set ({ i, j }, { 1.f - t, t });
+		return a + ab * t;
+	}
+	float d5 = -dot (ab, c), d6 = -dot (ac, c);
+	if (d6 >= 0.f && d5 <= d6)
+	{
+		s.set ({ k }, { 1.f });
+		return c;
+	}
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+	{
+		float t = d2 / (d2 - d6);
+		s.set ({ i, k }, { 1.f - t, t });
+		return a + ac * t;
+	}
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f)
+	{
+		float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		s.set ({ j, k }, { 1.f - t, t });
+		return b + (c - b) * t;
+	}
+	float denom = 1.f / (va + vb + vc);
+	float v = vb * denom, w = vc * denom;
+	s.set ({ i, j, k }, { 1.f - v - w, v, w });
+	return a + ab * v + ac * w;
+}
+
+// Closest point of the tetrahedron to the origin. Only faces with the origin on their
+// outer side are candidates, if there are none the origin is inside.
+inline vec3<float> closest_tetrahedron (simplex& s)
+{
+	int const faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+	float best = std::numeric_limits<float>::max ();
+	vec3<float> closest;
+	simplex reduced = s;
+	bool inside = true;
+	for (auto const& f : faces)
+	{
+		vec3<float> a = s.v[f[0]].w;
+		vec3<float> n = cross (s.v[f[1]].w - a, s.v[f[2]].w - a);
+		vec3<float> to_opposite = s.v[f[3]].w - a;
+		float side_origin = -dot (n, a), side_opposite = dot (n, to_opposite);
+		// an opposite vertex close to the face plane of a flat tetrahedron can't be trusted
+		float flat = 1e-4f * std::sqrt (dot (n, n) * dot (to_opposite, to_opposite));
+		if (side_origin * side_opposite > 0.f && std::fabs (side_opposite) > flat) continue;
+		inside = false;
+		simplex face = s;
+		vec3<float> p = closest_triangle (face, f[0], f[1], f[2]);
+		if (dot (p, p) < best) best = dot (p, p), closest = p, reduced = face;
+	}
+	if (inside)
+	{
+		// origin inside, the weights are not needed
+		for (int i = 0; i < 4; i++)
+			s.bary[i] = 0.25f;
+		return vec3<float> (0.f);
+	}
+	s = reduced;
+	return closest;
+}
+
+inline vec3<float> closest (simplex& s)
+{
+	switch (s.size)
+	{
+		case 1: s.bary[0] = 1.f; return s.v[0].w;
+		case 2: return closest_segment (s);
+		case 3: return closest_triangle (s, 0, 1, 2);
+		default: return closest_tetrahedron (s);
+	}
+}
+
+constexpr int gjk_max_iterations = 64;
+constexpr float gjk_tolerance = 1e-5f;
+// closer than this fraction of the shape size counts as touching, below it float
+// rounding decides which side of the origin the simplex ends up
+constexpr float gjk_contact = 1e-4f;
+
+// GJK on a - b. Stops early with a separating axis when separating_only is set. Leaves
+// the final simplex in s.
+template <typename A, typename B>
+gjk_result gjk (A const& a, B const& b, gjk_cache* cache, bool separating_only, simplex& s)
+{
+	gjk_result out;
+	s.size = 0;
+	vec3<float> v = cache && cache->direction.mag_sqrt () > 0.f ? cache->direction : vec3<float> (1.f, 0.f, 0.f);
+	float scale = 0.f;
+	for (out.iterations = 1; out.iterations <= gjk_max_iterations; out.iterations++)
+	{
+		simplex_vertex sv = support_vertex (a, b, -v);
+		float vv = dot (v, v), vw = dot (v, sv.w);
+		if (separating_only && vw > 0.f) break;
+		// no progress towards the origin, v is the closest point
+		if (s.size > 0 && vv - vw <= gjk_tolerance * vv) break;
+		bool repeated = false;
+		for (int i = 0; i < s.size; i++)
+			repeated = repeated || (s.v[i].w.x == sv.w.x && s.v[i].w.y == sv.w.y && s.v[i].w.z == sv.w.z);
+		if (repeated) break;
+
+		simplex const previous = s;
+		s.v[s.size++] = sv;
+		scale = std::fmax (scale, dot (sv.w, sv.w));
+		vec3<float> next = closest (s);
+		if (s.size == 4 || dot (next, next) <= gjk_contact * gjk_contact * scale)
+		{
+			out.overlap = true;
+			break;
+		}
+		// rounding stopped the distance from shrinking, the previous simplex is as close as it gets
+		if (previous.size > 0 && dot (next, next) >= vv)
+		{
+			s = previous;
+			break;
+		}
+		v = next;
+	}
+
+	if (cache) cache->direction = out.overlap ? cache->direction : v;
+	if (!out.overlap)
+	{
+		out.distance = v.length ();
+		out.point_a = s.point_a ();
+		out.point_b = s.point_b ();
+	}
+	return out;
+}
+// Spheres and capsules are handled as their center point or segment grown by a radius.
+// Queries run on these polyhedral cores, which converge in a few steps, and add the
+// radii afterwards.
+template <typename S> struct core_shape
+{
+	S const& shape;
+};
+
+template <typename S> vec3<float> support (core_shape<S> const& c, vec3<float> const& d)
+{
+	return support (c.shape, d);
+}
+
+inline vec3<float> support (core_shape<sphere> const& c, vec3<float> const&) { return c.shape.center; }
+
+inline vec3<float> support (core_shape<capsule> const& c, vec3<float> const& d)
+{
+	return dot (d, c.shape.b - c.shape.a) > 0.f ? c.shape.b : c.shape.a;
+}
+
+template <typename S> float margin (S const&) { return 0.f; }
+inline float margin (sphere const& s) { return s.radius; }
+inline float margin (capsule const& c) { return c.radius; }
+
+// Expanding polytope algorithm, grows the simplex s of an overlapping GJK run on a - b
+// until its nearest face to the origin lies on the boundary
+template <typename A, typename B> penetration epa (A const& a, B const& b, simplex const& s)
+{
+	penetration out;
+	out.overlap = true;
+
+	std::vector<detail::simplex_vertex> verts (s.v, s.v + s.size);
+
+	// grow the simplex into a tetrahedron around the origin
+	vec3<float> const axes[3] = { vec3<float> (1, 0, 0), vec3<float> (0, 1, 0), vec3<float> (0, 0, 1) };
+	for (int i = 0; verts.size () == 1 && i < 6; i++)
+	{
+		auto sv = support_vertex (a, b, i < 3 ? axes[i] : -axes[i - 3]);
+		if ((sv.w - verts[0].w).mag_sqrt () > 1e-12f) verts.push_back (sv);
+	}
+	if (verts.size () == 2)
+	{
+		vec3<float> d = verts[1].w - verts[0].w;
+		// the axis least aligned with the segment gives a stable perpendicular
+		int lean = std::fabs (d.x) < std::fabs (d.y) ? 0 : 1;
+		lean = std::fabs (d.z) < std::fabs (d.get (lean)) ? 2 : lean;
+		vec3<float> p = normalize (cross (d, axes[lean])), q = normalize (cross (d, p));
+		for (int i = 0; verts.size () == 2 && i < 6; i++)
+		{
+			float angle = static_cast<float> (i) * static_cast<float> (PI / 3.0);
+			auto sv = support_vertex (a, b, p * std::cos (angle) + q * std::sin (angle));
+			if (cross (sv.w - verts[0].w, d).mag_sqrt () > 1e-12f * d.mag_sqrt ()) verts.push_back (sv);
+		}
+	}
+	if (verts.size () == 3)
+	{
+		vec3<float> n = cross (verts[1].w - verts[0].w, verts[2].w - verts[0].w);
+		auto sv = support_vertex (a, b, n);
+		if (std::fabs (dot (sv.w - verts[0].w, n)) <= 1e-12f) sv = support_vertex (a, b, -n);
+		verts.push_back (sv);
+	}
+	if (verts.size () < 4) return out; // flat shapes, no volume to measure a depth in
+
+	// wind the tetrahedron so every face normal points away from the opposite vertex
+	if (dot (cross (verts[1].w - verts[0].w, verts[2].w - verts[0].w), verts[3].w - verts[0].w) > 0.f)
+		std::swap (verts[1], verts[2]);
+
+	struct face
+	{
+		int i, j, k;
+		vec3<float> normal;
+		float dist;
+	};
+	std::vector<face> faces;
+	auto add_face = [&] (int i, int j, int k) {
+		vec3<float> n = cross (verts[j].w - verts[i].w, verts[k].w - verts[i].w);
+		float len = n.length ();
+		// slivers without a normal stay in the hull but are never expanded
+		if (len == 0.f)
+			faces.push_back (face{ i, j, k, n, std::numeric_limits<float>::max () });
+		else
+			faces.push_back (face{ i, j, k, n / len, dot (n, verts[i].w) / len });
+	};
+	add_face (0, 1, 2);
+	add_face (0, 3, 1);
+	add_face (0, 2, 3);
+	add_face (1, 3, 2);
+
+	std::vector<std::pair<int, int>> horizon;
+	for (int iteration = 0;; iteration++)
+	{
+		std::size_t nearest = 0;
+		for (std::size_t f = 1; f < faces.size (); f++)
+			if (faces[f].dist < faces[nearest].dist) nearest = f;
+		face const best = faces[nearest];
+
+		auto sv = support_vertex (a, b, best.normal);
+		bool converged = dot (sv.w, best.normal) - best.dist <= 1e-5f * (best.dist > 1.f ? best.dist : 1.f);
+		if (converged || iteration + 1 == gjk_max_iterations)
+		{
+			// contact from the barycentric coordinates of the origin projected onto the face
+			out.depth = best.dist;
+			out.normal = best.normal;
+			vec3<float> v0 = verts[best.j].w - verts[best.i].w, v1 = verts[best.k].w - verts[best.i].w;
+			vec3<float> v2 = best.normal * best.dist - verts[best.i].w;
+			float d00 = dot (v0, v0), d01 = dot (v0, v1), d11 = dot (v1, v1);
+			float d20 = dot (v2, v0), d21 = dot (v2, v1);
+			float denom = d00 * d11 - d01 * d01;
+			float u = denom != 0.f ? (d11 * d20 - d01 * d21) / denom : 0.f;
+			float w = denom != 0.f ? (d00 * d21 - d01 * d20) / denom : 0.f;
+			out.point_a = verts[best.i].a * (1.f - u - w) + verts[best.j].a * u + verts[best.k].a * w;
+			out.point_b = verts[best.i].b * (1.f - u - w) + verts[best.j].b * u + verts[best.k].b * w;
+			return out;
+		}
+
+		// remove the faces seen from the new point, their outline is the horizon. The seen
+		// faces are flooded out from the nearest face along shared edges, so rounding can't
+		// punch separate holes into the hull.
+		int const index = static_cast<int> (verts.size ());
+		verts.push_back (sv);
+		horizon.clear ();
+		std::vector<char> seen (faces.size (), 0);
+		std::vector<std::size_t> open (1, nearest);
+		seen[nearest] = 1;
+		while (!open.empty ())
+		{
+			face const f = faces[open.back ()];
+			open.pop_back ();
+			int const edges[3][2] = { { f.i, f.j }, { f.j, f.k }, { f.k, f.i } };
+			for (auto const& e : edges)
+			{
+				std::size_t n = 0;
+				while (n < faces.size () && !((faces[n].i == e[1] && faces[n].j == e[0]) ||
+				                               (faces[n].j == e[1] && faces[n].k == e[0]) ||
+				                               (faces[n].k == e[1] && faces[n].i == e[0])))
+					n++;
+				if (n < faces.size () && seen[n]) continue;
+				if (n < faces.size () && dot (faces[n].normal, sv.w - verts[faces[n].i].w) > 0.f)
+				{
+					seen[n] = 1;
+					open.push_back (n);
+				}
+				else
+					horizon.emplace_back (e[0], e[1]);
+			}
+		}
+		for (std::size_t f = faces.size (); f-- > 0;)
+			if (seen[f])
+			{
+				faces[f] = faces.back ();
+				faces.pop_back ();
+			}
+		for (auto const& e : horizon)
+			add_face (e.first, e.second, index);
+	}
+}
+
+} // namespace detail
+
+// True when the shapes intersect, exits as soon as a separating axis is found
+template <typename A, typename B> bool gjk_overlap (A const& a, B const& b, gjk_cache* cache = nullptr)
+{
+	detail::simplex s;
+	return detail::gjk (a, b, cache, true, s).overlap;
+}
+
+// Distance and closest points of two shapes, overlap is set when they intersect
+template <typename A, typename B> gjk_result gjk_distance (A const& a, B const& b, gjk_cache* cache = nullptr)
+{
+	detail::simplex s;
+	float const ma = detail::margin (a), mb = detail::margin (b);
+	gjk_result out = detail::gjk (detail::core_shape<A>{ a }, detail::core_shape<B>{ b }, cache, false, s);
+	if (out.overlap || out.distance <= ma + mb)
+	{
+		out.overlap = true;
+		out.distance = 0.f;
+		return out;
+	}
+	vec3<float> n = (out.point_b - out.point_a) / out.distance;
+	out.point_a += n * ma;
+	out.point_b -= n * mb;
+	out.distance -= ma + mb;
+	return out;
+}
+
+// Penetration depth and normal of intersecting shapes. overlap is false when the shapes
+// are apart.
+template <typename A, typename B> penetration gjk_epa (A const& a, B const& b, gjk_cache* cache = nullptr)
+{
+	penetration out;
+	detail::simplex s;
+	float const ma = detail::margin (a), mb = detail::margin (b);
+	gjk_result cores = detail::gjk (detail::core_shape<A>{ a }, detail::core_shape<B>{ b }, cache, false, s);
+	if (!cores.overlap)
+	{
+		// only the radii overlap, the closest points of the cores give the exact answer
+		if (cores.distance >= ma + mb) return out;
+		out.overlap = true;
+		out.normal = (cores.point_b - cores.point_a) / cores.distance;
+		out.depth = ma + mb - cores.distance;
+		out.point_a = cores.point_a + out.normal * ma;
+		out.point_b = cores.point_b - out.normal * mb;
+		return out;
+	}
+	if (ma + mb > 0.f && !detail::gjk (a, b, cache, false, s).overlap) return out;
+	return detail::epa (a, b, s);
+}
+
+} // namespace cml
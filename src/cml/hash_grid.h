@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "aabb.h"
+#include "allocator.h"
+#include "parallel.h"
+#include "vec3.h"
+
+/*
+Uniform spatial hash grid for broad phase proximity queries.
+
+Points are quantized to vec3<int> cells, cells are hashed into a power of two
+bucket table and the whole set is rebuilt at once with a counting sort. After a
+rebuild the points of each bucket are contiguous, with a copy of their positions
+stored in bucket order, so a query walks a few short linear runs instead of
+chasing pointers.
+
+The sort keeps one bucket histogram, with threads > 1 the counting and scatter
+passes update it with relaxed atomics, so within a bucket points come in input
+order for a single thread and in an unspecified order otherwise. The scratch
+arrays only grow, a rebuild that needs no more points or buckets than an earlier
+one does not touch the heap itself, but with threads > 1 parallel_for starts and
+joins its worker threads on every call.
+
+Cells that collide in the table share a bucket, queries filter by cell and
+shape so every point is reported at most once.
+*/
+
+namespace cml
+{
+
+class hash_grid
+{
+	public:
+	class query_iterator;
+
+	// Points within a sphere or box, iterates their indices in the input array
+	class query_range
+	{
+		public:
+		query_iterator begin () const { return query_iterator (grid, box, center, radius_sqrt); }
+		query_iterator end () const { return query_iterator (); }
+
+		private:
+		friend class hash_grid;
+		query_range (hash_grid const* grid, aabb<float> const& box, vec3<float> const& center, float radius_sqrt)
+		: grid (grid), box (box), center (center), radius_sqrt (radius_sqrt)
+		{
+		}
+
+		hash_grid const* grid;
+		aabb<float> box;
+		vec3<float> center;
+		float radius_sqrt; // negative for box queries
+	};
+
+	class query_iterator
+	{
+		public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::uint32_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::uint32_t const*;
+		using reference = std::uint32_t const&;
+
+		query_iterator () {}
+
+		reference operator* () const { return grid->indices[pos]; }
+
+		query_iterator& operator++ ()
+		{
+			pos++;
+			advance ();
+			return *this;
+		}
+
+		query_iterator operator++ (int)
+		{
+			query_iterator old = *this;
+			++*this;
+			return old;
+		}
+
+		bool operator== (query_iterator const& other) const
+		{
+			return done () == other.done () && (done () || pos == other.pos);
+		}
+		bool operator!= (query_iterator const& other) const { return !(*this == other); }
+
+		private:
+		friend class query_range;
+		query_iterator (hash_grid const* grid, aabb<float> const& box, vec3<float> const& center, float radius_sqrt)
+		: grid (grid), box (box), center (center), radius_sqrt (radius_sqrt)
+		{
+			if (grid->starts.empty () || box.empty ()) return;
+			lo = grid->cell (box.min);
+			hi = grid->cell (box.max);
+			cell = lo;
+			enter_cell ();
+			advance ();
+		}
+
+		bool done () const { return grid == nullptr || cell.z > hi.z; }
+
+		void enter_cell ()
+		{
+			std::uint32_t bucket = grid->bucket (cell);
+			pos = grid->starts[bucket];
+			end = grid->starts[bucket + 1];
+		}
+
+		// Moves to the first matching point at or after pos
+		void advance ()
+		{
+			for (;;)
+			{
+				for (; pos < end; pos++)
+				{
+					vec3<float> const& p = grid->points[pos];
+					if (!box.contains (p)) continue;
+					if (radius_sqrt >= 0.f && (p - center).mag_sqrt () > radius_sqrt) continue;
+					vec3<int> c = grid->cell (p);
+					if (c.x == cell.x && c.y == cell.y && c.z == cell.z) return;
+				}
+				if (++cell.x > hi.x)
+				{
+					cell.x = lo.x;
+					if (++cell.y > hi.y)
+					{
+						cell.y = lo.y;
+						if (++cell.z > hi.z) return;
+					}
+				}
+				enter_cell ();
+			}
+		}
+
+		hash_grid const* grid = nullptr;
+		aabb<float> box;
+		vec3<float> center;
+		float radius_sqrt = -1.f;
+		vec3<int> lo, hi, cell;
+		std::uint32_t pos = 0, end = 0;
+	};
+
+	// cell_size should be about the typical query radius. bucket_count of 0 picks
+	// the next power of two above the point count on every rebuild.
+	explicit hash_grid (float cell_size, std::size_t bucket_count = 0)
+	: inv_cell_size (1.f / cell_size), fixed_buckets (bucket_count)
+	{
+		assert (cell_size > 0.f);
+		assert (bucket_count == 0 || detail::is_pow2 (bucket_count));
+	}
+
+	vec3<int> cell (vec3<float> const& p) const
+	{
+		return vec3<int> (static_cast<int> (std::floor (p.x * inv_cell_size)),
+		    static_cast<int> (std::floor (p.y * inv_cell_size)),
+		    static_cast<int> (std::floor (p.z * inv_cell_size)));
+	}
+
+	static std::uint32_t hash (vec3<int> const& c)
+	{
+		return (static_cast<std::uint32_t> (c.x) * 73856093u) ^ (static_cast<std::uint32_t> (c.y) * 19349663u) ^
+		       (static_cast<std::uint32_t> (c.z) * 83492791u);
+	}
+
+	std::uint32_t bucket (vec3<int> const& c) const { return hash (c) & mask; }
+
+	// REBUILD
+
+	void rebuild (vec3<float> const* in, std::size_t count, unsigned threads = 1)
+	{
+		std::size_t buckets = fixed_buckets;
+		if (buckets == 0)
+		{
+			buckets = 1;
+			while (buckets < count)
+				buckets <<= 1;
+		}
+		mask = static_cast<std::uint32_t> (buckets - 1);
+
+		keys.resize (count);
+		points.resize (count);
+		indices.resize (count);
+		starts.resize (buckets + 1);
+		if (cursor_capacity < buckets)
+		{
+			cursors.reset (new std::atomic<std::uint32_t>[buckets]);
+			cursor_capacity = buckets;
+		}
+		for (std::size_t b = 0; b < buckets; b++)
+			cursors[b].store (0, std::memory_order_relaxed);
+
+		// the same split parallel_for makes, a single chunk needs no atomic increments
+		bool const shared = threads > 1 && count > min_chunk;
+		auto bump = [shared] (std::atomic<std::uint32_t>& n) {
+			if (shared) return n.fetch_add (1, std::memory_order_relaxed);
+			std::uint32_t old = n.load (std::memory_order_relaxed);
+			n.store (old + 1, std::memory_order_relaxed);
+			return old;
+		};
+
+		// histogram
+		parallel_for (
+		    count,
+		    min_chunk,
+		    [&] (std::size_t first, std::size_t last) {
+			    for (std::size_t i = first; i < last; i++)
+			    {
+				    keys[i] = bucket (cell (in[i]));
+				    bump (cursors[keys[i]]);
+			    }
+		    },
+		    threads);
+
+		// exclusive prefix sum, the cursors become the next free slot of each bucket
+		std::uint32_t offset = 0;
+		for (std::size_t b = 0; b < buckets; b++)
+		{
+			starts[b] = offset;
+			offset += cursors[b].load (std::memory_order_relaxed);
+			cursors[b].store (starts[b], std::memory_order_relaxed);
+		}
+		starts[buckets] = offset;
+
+		parallel_for (
+		    count,
+		    min_chunk,
+		    [&] (std::size_t first, std::size_t last) {
+			    for (std::size_t i = first; i < last; i++)
+			    {
+				    std::uint32_t slot = bump (cursors[keys[i]]);
+				    points[slot] = in[i];
+				    indices[slot] = static_cast<std::uint32_t> (i);
+			    }
+		    },
+		    threads);
+	}
+
+	// QUERIES
+
+	query_range query_radius (vec3<float> const& center, float radius) const
+	{
+		aabb<float> box (center - vec3<float> (radius), center + vec3<float> (radius));
+		return query_range (this, box, center, radius * radius);
+	}
+
+	query_range query_box (aabb<float> const& box) const { return query_range (this, box, vec3<float> (), -1.f); }
+
+	std::size_t size () const { return points.size (); }
+	std::size_t bucket_count () const { return starts.empty () ? 0 : starts.size () - 1; }
+
+	// Bucket sorted copy of the positions, and the input index of each
+	aligned_vector<vec3<float>> points;
+	std::vector<std::uint32_t> indices;
+
+	private:
+	static constexpr std::size_t min_chunk = 4096;
+
+	float inv_cell_size;
+	std::size_t fixed_buckets;
+	std::uint32_t mask = 0;
+	std::vector<std::uint32_t> starts; // first point of each bucket, plus one past the end
+	std::vector<std::uint32_t> keys;
+	std::unique_ptr<std::atomic<std::uint32_t>[]> cursors; // per bucket histogram, then next free slot
+	std::size_t cursor_capacity = 0;
+};
+
+} // namespace cml
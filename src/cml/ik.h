@@ -0,0 +1,330 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "common.h"
+#include "orthonormalize.h"
+#include "parallel.h"
+#include "quat.h"
+#include "vec3.h"
+
+/*
+Inverse kinematics for joint chains.
+
+A chain is count joints in world space, joint i + 1 hangs off joint i and the
+last joint is the end effector. Each joint has a world position and a world
+rotation in flat arrays, so a whole skeleton can be passed with each chain a
+range of it. Solvers move the positions and rotate the rotations along with
+them, bone lengths stay the same.
+
+No solver goes through angles. Rotations are built directly from the two
+directions they map between, the shortest arc q = (a x b, |a| |b| + a . b)
+normalized, which costs two square roots and no trig.
+
+two_bone_ik places the middle joint with the law of cosines in the plane of
+the target and a pole point. ccd_ik turns each joint in turn, tip to root, so
+the end effector points at the target. fabrik_ik alternately drags the chain
+from the target and the root by moving joints along the bones, then builds the
+rotations from the old and new bone directions at the end. Both iterative
+solvers stop as soon as the end effector is within the tolerance, or when it
+stops moving.
+
+Joint limits are cones, cos_limits[i] is the cosine of the largest angle
+between bone i - 1 and bone i. Entries for the root and the end effector are
+not used, -1 leaves a joint free. FABRIK applies them in its forward pass only.
+*/
+
+namespace cml
+{
+
+struct ik_settings
+{
+	int max_iterations = 16;
+	float tolerance = 1e-3f; // distance from the target that counts as reached
+};
+
+// Joints [first, first + count) of the joint arrays
+struct ik_chain
+{
+	std::uint32_t first;
+	std::uint32_t count;
+};
+
+enum class ik_solver
+{
+	ccd,
+	fabrik
+};
+
+// longest chain the iterative solvers handle, they keep bone data on the stack
+constexpr std::size_t max_ik_joints = 64;
+
+// Shortest arc rotation taking the direction of from to the direction of to
+inline quat<float> from_to_rotation (vec3<float> const& from, vec3<float> const& to)
+{
+	float const scale = std::sqrt (from.mag_sqrt () * to.mag_sqrt ());
+	float const w = scale + dot (from, to);
+	if (w <= 1e-6f * scale)
+	{
+		// opposite directions, half a turn around any perpendicular axis
+		vec3<float> axis = std::fabs (from.x) > std::fabs (from.z)
+		                       ? vec3<float> (-from.y, from.x, 0.f)
+		                       : vec3<float> (0.f, -from.z, from.y);
+		float const len = axis.length ();
+		if (len == 0.f) return quat<float> ();
+		return quat<float> (axis / len, 0.f);
+	}
+	quat<float> q (cross (from, to), w);
+	return q * (1.f / std::sqrt (q.magSqrd ()));
+}
+
+namespace detail
+{
+// q v q^-1 for a unit quaternion
+inline vec3<float> rotate_unit (quat<float> const& q, vec3<float> const& v)
+{
+	vec3<float> const u = q.getImag ();
+	vec3<float> const t = cross (u, v) * 2.f;
+	return v + t * q.getReal () + cross (u, t);
+}
+
+// v / |v|, or fallback for vectors too short to have a direction
+inline vec3<float> direction (vec3<float> const& v, vec3<float> const& fallback)
+{
+	float const len_sqr = v.mag_sqrt ();
+	return len_sqr > 1e-20f ? v * (1.f / std::sqrt (len_sqr)) : fallback;
+}
+
+// Unit direction d moved the least to be within acos (cos_max) of the unit axis
+inline vec3<float> clamp_cone (vec3<float> const& d, vec3<float> const& axis, float cos_max)
+{
+	float const c = dot (d, axis);
+	if (c >= cos_max) return d;
+	vec3<float> side = d - axis * c;
+	float const len_sqr = side.mag_sqrt ();
+	if (len_sqr > 1e-12f)
+		side = side * (1.f / std::sqrt (len_sqr));
+	else
+		side = normalize (std::fabs (axis.x) > std::fabs (axis.z)
+		                      ? vec3<float> (-axis.y, axis.x, 0.f)
+		                      : vec3<float> (0.f, -axis.z, axis.y));
+	return axis * cos_max + side * std::sqrt (max (0.f, 1.f - cos_max * cos_max));
+}
+
+// Rotates joints (first, count) of the chain about joint first, and the rotations from first on
+inline void turn_chain (
+    vec3<float>* p, quat<float>* q, std::size_t first, std::size_t count, quat<float> const& r)
+{
+	for (std::size_t k = first + 1; k < count; k++)
+		p[k] = p[first] + rotate_unit (r, p[k] - p[first]);
+	for (std::size_t k = first; k < count; k++)
+		q[k] = r * q[k];
+}
+
+// Rotates every bone from its old vector to its new one, each bone first carried along with
+// its parent so twist is kept
+inline void rotate_bones (
+    vec3<float> const* old_bones, vec3<float> const* p, quat<float>* q, std::size_t count)
+{
+	quat<float> turn;
+	for (std::size_t i = 0; i + 1 < count; i++)
+	{
+		vec3<float> const carried = rotate_unit (turn, old_bones[i]);
+		turn = from_to_rotation (carried, p[i + 1] - p[i]) * turn;
+		q[i] = turn * q[i];
+	}
+	q[count - 1] = turn * q[count - 1];
+}
+
+inline bool near_target (vec3<float> const& end, vec3<float> const& target, float tolerance)
+{
+	return (end - target).mag_sqrt () <= tolerance * tolerance;
+}
+} // namespace detail
+
+// ANALYTIC
+
+// Solves the three joint chain p[0], p[1], p[2], bending at p[1] towards the pole point.
+// Returns whether the target is within reach, out of reach the chain is stretched towards it.
+inline bool two_bone_ik (
+    vec3<float>* p, quat<float>* q, vec3<float> const& target, vec3<float> const& pole)
+{
+	vec3<float> const old_bones[2] = { p[1] - p[0], p[2] - p[1] };
+	float const a = old_bones[0].length ();
+	float const b = old_bones[1].length ();
+	vec3<float> const to = target - p[0];
+	float const dist = to.length ();
+	vec3<float> const reach_dir = detail::direction (p[2] - p[0], vec3<float> (0.f, 1.f, 0.f));
+	vec3<float> const dir = detail::direction (to, reach_dir);
+
+	// bend in the plane of the target and the pole, or the current plane without a usable pole
+	vec3<float> bend = pole - p[0];
+	bend = bend - dir * dot (bend, dir);
+	if (bend.mag_sqrt () < 1e-12f)
+	{
+		bend = old_bones[0] - dir * dot (old_bones[0], dir);
+		if (bend.mag_sqrt () < 1e-12f)
+			bend = std::fabs (dir.x) > std::fabs (dir.z) ? vec3<float> (-dir.y, dir.x, 0.f)
+			                                                : vec3<float> (0.f, -dir.z, dir.y);
+	}
+	bend = normalize (bend);
+
+	float const reach_min = std::fabs (a - b), reach_max = a + b;
+	float const d = min (max (dist, reach_min), reach_max);
+	// law of cosines, the angle at the root between the target and the first bone
+	float cos_root = a * d > 0.f ? (a * a + d * d - b * b) / (2.f * a * d) : 1.f;
+	cos_root = min (max (cos_root, -1.f), 1.f);
+	float const sin_root = std::sqrt (1.f - cos_root * cos_root);
+
+	p[1] = p[0] + (dir * cos_root + bend * sin_root) * a;
+	p[2] = p[0] + dir * d;
+	detail::rotate_bones (old_bones, p, q, 3);
+	renormalize (q, 3);
+	return dist >= reach_min && dist <= reach_max;
+}
+
+// ITERATIVE
+
+// Cyclic coordinate descent. cos_limits may be null for a chain without limits.
+// Returns whether the end effector reached the target.
+inline bool ccd_ik (vec3<float>* p, quat<float>* q, float const* cos_limits, std::size_t count,
+    vec3<float> const& target, ik_settings const& settings = ik_settings ())
+{
+	assert (count >= 2);
+	std::size_t const end = count - 1;
+	bool reached = detail::near_target (p[end], target, settings.tolerance);
+	for (int iteration = 0; iteration < settings.max_iterations && !reached; iteration++)
+	{
+		vec3<float> const before = p[end];
+		for (std::size_t n = count - 1; n-- > 0;)
+		{
+			quat<float> r = from_to_rotation (p[end] - p[n], target - p[n]);
+			if (cos_limits && n > 0 && cos_limits[n] > -1.f)
+			{
+				vec3<float> const bone = p[n + 1] - p[n];
+				vec3<float> const turned = detail::rotate_unit (r, bone);
+				vec3<float> const parent = detail::direction (p[n] - p[n - 1], turned);
+				vec3<float> const limited =
+				    detail::clamp_cone (detail::direction (turned, parent), parent, cos_limits[n]);
+				r = from_to_rotation (turned, limited) * r;
+			}
+			detail::turn_chain (p, q, n, count, r);
+		}
+		reached = detail::near_target (p[end], target, settings.tolerance);
+		// stalled, the target is out of reach or blocked by the limits
+		if ((p[end] - before).mag_sqrt () <= 1e-4f * settings.tolerance * settings.tolerance) break;
+	}
+	renormalize (q, count);
+	return reached;
+}
+
+// Forward and backward reaching. cos_limits may be null for a chain without limits.
+// Returns whether the end effector reached the target.
+inline bool fabrik_ik (vec3<float>* p, quat<float>* q, float const* cos_limits, std::size_t count,
+    vec3<float> const& target, ik_settings const& settings = ik_settings ())
+{
+	assert (count >= 2 && count <= max_ik_joints);
+	std::size_t const end = count - 1;
+	vec3<float> old_bones[max_ik_joints];
+	float lengths[max_ik_joints];
+	for (std::size_t i = 0; i < end; i++)
+	{
+		old_bones[i] = p[i + 1] - p[i];
+		lengths[i] = old_bones[i].length ();
+	}
+
+	vec3<float> const root = p[0];
+	bool reached = detail::near_target (p[end], target, settings.tolerance);
+	for (int iteration = 0; iteration < settings.max_iterations && !reached; iteration++)
+	{
+		vec3<float> const before = p[end];
+		p[end] = target;
+		for (std::size_t i = end; i-- > 0;)
+			p[i] = p[i + 1] + detail::direction (p[i] - p[i + 1], -old_bones[i]) * lengths[i];
+
+		p[0] = root;
+		vec3<float> parent = detail::direction (old_bones[0], vec3<float> (0.f, 1.f, 0.f));
+		for (std::size_t i = 0; i < end; i++)
+		{
+			vec3<float> d = detail::direction (p[i + 1] - p[i], parent);
+			if (cos_limits && i > 0 && cos_limits[i] > -1.f)
+				d = detail::clamp_cone (d, parent, cos_limits[i]);
+			p[i + 1] = p[i] + d * lengths[i];
+			parent = d;
+		}
+		reached = detail::near_target (p[end], target, settings.tolerance);
+		if ((p[end] - before).mag_sqrt () <= 1e-4f * settings.tolerance * settings.tolerance) break;
+	}
+	detail::rotate_bones (old_bones, p, q, count);
+	renormalize (q, count);
+	return reached;
+}
+
+// BATCHES
+
+// Solves every chain towards its target, returns how many reached it. Chains must not share joints.
+inline std::size_t solve_ik (ik_solver solver,
+    vec3<float>* positions,
+    quat<float>* rotations,
+    float const* cos_limits,
+    ik_chain const* chains,
+    vec3<float> const* targets,
+    std::size_t chain_count,
+    ik_settings const& settings = ik_settings (),
+    unsigned threads = 1)
+{
+	std::atomic<std::size_t> reached{ 0 };
+	parallel_for (
+	    chain_count,
+	    64,
+	    [&] (std::size_t first, std::size_t last) {
+		    std::size_t n = 0;
+		    for (std::size_t c = first; c < last; c++)
+		    {
+			    vec3<float>* p = positions + chains[c].first;
+			    quat<float>* q = rotations + chains[c].first;
+			    float const* limits = cos_limits ? cos_limits + chains[c].first : nullptr;
+			    if (solver == ik_solver::ccd)
+				    n += ccd_ik (p, q, limits, chains[c].count, targets[c], settings);
+			    else
+				    n += fabrik_ik (p, q, limits, chains[c].count, targets[c], settings);
+		    }
+		    reached += n;
+	    },
+	    threads);
+	return reached;
+}
+
+// Two bone chains of three joints each, bending towards poles[c]. Returns how many targets were
+// within reach.
+inline std::size_t solve_two_bone_ik (vec3<float>* positions,
+    quat<float>* rotations,
+    ik_chain const* chains,
+    vec3<float> const* targets,
+    vec3<float> const* poles,
+    std::size_t chain_count,
+    unsigned threads = 1)
+{
+	std::atomic<std::size_t> reached{ 0 };
+	parallel_for (
+	    chain_count,
+	    256,
+	    [&] (std::size_t first, std::size_t last) {
+		    std::size_t n = 0;
+		    for (std::size_t c = first; c < last; c++)
+		    {
+			    assert (chains[c].count == 3);
+			    std::uint32_t const root = chains[c].first;
+			    n += two_bone_ik (positions + root, rotations + root, targets[c], poles[c]);
+		    }
+		    reached += n;
+	    },
+	    threads);
+	return reached;
+}
+
+} // namespace cml
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "allocator.h"
+#include "parallel.h"
+#include "vec3.h"
+
+/*
+Static k-d tree over a vec3<float> point cloud for nearest neighbour queries.
+
+The tree is balanced and implicit: every inner node splits its range of points
+at the median, so the range of a node follows from its position and only the
+split plane is stored, in heap order (children of node i at 2i + 1 and 2i + 2).
+The recursion stops once a range holds at most bucket_size points. Leaf points
+are stored as structure of arrays in tree order so a leaf is scanned with one
+SIMD loop.
+*/
+
+namespace cml
+{
+
+class kd_tree
+{
+	public:
+	static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max ();
+	static constexpr std::size_t bucket_size = 8;
+
+	kd_tree () {}
+
+	// BUILD
+
+	void build (vec3<float> const* points, std::size_t count, unsigned threads = 1)
+	{
+		point_count = count;
+		levels = 0;
+		while (((count + (std::size_t (1) << levels) - 1) >> levels) > bucket_size)
+			levels++;
+
+		std::size_t inner = (std::size_t (1) << levels) - 1;
+		split.assign (inner, 0.f);
+		axis.assign (inner, 0);
+		indices.resize (count);
+		for (std::size_t i = 0; i < count; i++)
+			indices[i] = static_cast<std::uint32_t> (i);
+
+		int spawn_depth = 0;
+		while ((1u << spawn_depth) < threads)
+			spawn_depth++;
+		build_node (points, 0, 0, static_cast<std::uint32_t> (count), 0, spawn_depth);
+
+		px.resize (count);
+		py.resize (count);
+		pz.resize (count);
+		for (std::size_t i = 0; i < count; i++)
+		{
+			vec3<float> const& p = points[indices[i]];
+			px[i] = p.x, py[i] = p.y, pz[i] = p.z;
+		}
+	}
+
+	void build (std::vector<vec3<float>> const& points, unsigned threads = 1)
+	{
+		build (points.data (), points.size (), threads);
+	}
+
+	// QUERIES
+
+	// The k nearest points to q, closest first. Returns how many were found (less than
+	// k only when the tree is smaller than k), unused slots get npos and infinity.
+	std::size_t nearest (vec3<float> const& q, std::size_t k, std::uint32_t* out_index, float* out_dist_sqrt) const
+	{
+		std::fill (out_index, out_index + k, npos);
+		std::fill (out_dist_sqrt, out_dist_sqrt + k, std::numeric_limits<float>::infinity ());
+		if (k == 0 || point_count == 0) return 0;
+
+		std::size_t found = 0;
+		visit (q, out_dist_sqrt[k - 1], [&] (std::uint32_t lo, std::uint32_t hi, float (&dist)[bucket_size]) {
+			for (std::uint32_t i = lo; i < hi; i++)
+			{
+				float d = dist[i - lo];
+				if (d >= out_dist_sqrt[k - 1]) continue;
+				// insertion into the sorted result list
+				std::size_t j = found < k ? found++ : k - 1;
+				while (j > 0 && out_dist_sqrt[j - 1] > d)
+				{
+					out_dist_sqrt[j] = out_dist_sqrt[j - 1];
+					out_index[j] = out_index[j - 1];
+					j--;
+				}
+				out_dist_sqrt[j] = d;
+				out_index[j] = indices[i];
+			}
+			return out_dist_sqrt[k - 1];
+		});
+		return found;
+	}
+
+	// Index of the closest point, npos for an empty tree
+	std::uint32_t nearest (vec3<float> const& q) const
+	{
+		std::uint32_t index;
+		float dist_sqrt;
+		nearest (q, 1, &index, &dist_sqrt);
+		return index;
+	}
+
+	// Calls f (index, dist_sqrt) for every point within radius of q
+	template <typename F> void for_each_in_radius (vec3<float> const& q, float radius, F&& f) const
+	{
+		if (point_count == 0) return;
+		float const r2 = radius * radius;
+		visit (q, r2, [&] (std::uint32_t lo, std::uint32_t hi, float (&dist)[bucket_size]) {
+			for (std::uint32_t i = lo; i < hi; i++)
+				if (dist[i - lo] <= r2) f (indices[i], dist[i - lo]);
+			return r2;
+		});
+	}
+
+	void radius (vec3<float> const& q, float radius, std::vector<std::uint32_t>& out) const
+	{
+		out.clear ();
+		for_each_in_radius (q, radius, [&] (std::uint32_t index, float) { out.push_back (index); });
+	}
+
+	// BATCHED QUERIES
+
+	// k nearest of every query, out arrays hold k entries per query
+	void nearest (vec3<float> const* queries,
+	    std::size_t count,
+	    std::size_t k,
+	    std::uint32_t* out_index,
+	    float* out_dist_sqrt,
+	    unsigned threads = 1) const
+	{
+		parallel_for (
+		    count,
+		    256,
+		    [&] (std::size_t begin, std::size_t end) {
+			    for (std::size_t i = begin; i < end; i++)
+				    nearest (queries[i], k, out_index + i * k, out_dist_sqrt + i * k);
+		    },
+		    threads);
+	}
+
+	// Points within radius of every query, in compressed rows: the results of query i
+	// are results[offsets[i]] to results[offsets[i + 1]]
+	void radius (vec3<float> const* queries,
+	    std::size_t count,
+	    float radius,
+	    std::vector<std::uint32_t>& offsets,
+	    std::vector<std::uint32_t>& results,
+	    unsigned threads = 1) const
+	{
+		offsets.assign (count + 1, 0);
+		parallel_for (
+		    count,
+		    256,
+		    [&] (std::size_t begin, std::size_t end) {
+			    for (std::size_t i = begin; i < end; i++)
+				    for_each_in_radius (queries[i], radius, [&] (std::uint32_t, float) { offsets[i + 1]++; });
+		    },
+		    threads);
+		for (std::size_t i = 0; i < count; i++)
+			offsets[i + 1] += offsets[i];
+
+		results.resize (offsets[count]);
+		parallel_for (
+		    count,
+		    256,
+		    [&] (std::size_t begin, std::size_t end) {
+			    for (std::size_t i = begin; i < end; i++)
+			    {
+				    std::uint32_t next = offsets[i];
+				    for_each_in_radius (
+				        queries[i], radius, [&] (std::uint32_t index, float) { results[next++] = index; });
+			    }
+		    },
+		    threads);
+	}
+
+	std::size_t size () const { return point_count; }
+
+	// Points in tree order, and the input index of each
+	aligned_vector<float> px, py, pz;
+	std::vector<std::uint32_t> indices;
+
+	private:
+	void build_node (vec3<float> const* points,
+	    std::size_t node,
+	    std::uint32_t lo,
+	    std::uint32_t hi,
+	    int depth,
+	    int spawn_depth)
+	{
+		if (depth == levels) return;
+
+		vec3<float> min_p (std::numeric_limits<float>::max ());
+		vec3<float> max_p (std::numeric_limits<float>::lowest ());
+		for (std::uint32_t i = lo; i < hi; i++)
+		{
+			min_p = cml::min (min_p, points[indices[i]]);
+			max_p = cml::max (max_p, points[indices[i]]);
+		}
+		vec3<float> e = max_p - min_p;
+		int a = e.x > e.y ? (e.x > e.z ? 0 : 2) : (e.y > e.z ? 1 : 2);
+
+		std::uint32_t mid = lo + (hi - lo) / 2;
+		std::nth_element (indices.begin () + lo, indices.begin () + mid, indices.begin () + hi,
+		    [&] (std::uint32_t l, std::uint32_t r) { return points[l].get (a) < points[r].get (a); });
+		split[node] = points[indices[mid]].get (a);
+		axis[node] = static_cast<std::uint8_t> (a);
+
+		if (spawn_depth > 0)
+		{
+			std::thread worker ([=] { build_node (points, 2 * node + 1, lo, mid, depth + 1, spawn_depth - 1); });
+			build_node (points, 2 * node + 2, mid, hi, depth + 1, spawn_depth - 1);
+			worker.join ();
+		}
+		else
+		{
+			build_node (points, 2 * node + 1, lo, mid, depth + 1, 0);
+			build_node (points, 2 * node + 2, mid, hi, depth + 1, 0);
+		}
+	}
+
+	// Depth first walk, near side first. leaf (lo, hi, dist_sqrt) scans one bucket and
+	// returns the new culling distance, subtrees further than it are skipped.
+	template <typename F> void visit (vec3<float> const& q, float cull_sqrt, F&& leaf) const
+	{
+		struct entry
+		{
+			std::uint32_t node, lo, hi;
+			int depth;
+			float plane_sqrt;
+		};
+		entry stack[64];
+		int stack_size = 0;
+		stack[stack_size++] = entry{ 0, 0, static_cast<std::uint32_t> (point_count), 0, 0.f };
+
+		while (stack_size > 0)
+		{
+			entry e = stack[--stack_size];
+			if (e.plane_sqrt > cull_sqrt) continue;
+
+			// walk down to a leaf, pushing the far children
+			while (e.depth < levels)
+			{
+				std::uint32_t mid = e.lo + (e.hi - e.lo) / 2;
+				std::uint32_t left = 2 * e.node + 1;
+				float diff = q.get (axis[e.node]) - split[e.node];
+				float far_sqrt = std::max (e.plane_sqrt, diff * diff);
+				entry near_child = diff < 0.f ? entry{ left, e.lo, mid, e.depth + 1, e.plane_sqrt }
+				                              : entry{ left + 1, mid, e.hi, e.depth + 1, e.plane_sqrt };
+				entry far_child = diff < 0.f ? entry{ left + 1, mid, e.hi, e.depth + 1, far_sqrt }
+				                             : entry{ left, e.lo, mid, e.depth + 1, far_sqrt };
+				if (far_sqrt <= cull_sqrt) stack[stack_size++] = far_child;
+				e = near_child;
+			}
+
+			float dist[bucket_size];
+			std::uint32_t n = e.hi - e.lo;
+			for (std::uint32_t i = 0; i < bucket_size; i++)
+			{
+				std::uint32_t p = e.lo + (i < n ? i : 0);
+				float dx = px[p] - q.x, dy = py[p] - q.y, dz = pz[p] - q.z;
+				dist[i] = dx * dx + dy * dy + dz * dz;
+			}
+			cull_sqrt = leaf (e.lo, e.hi, dist);
+		}
+	}
+
+	std::size_t point_count = 0;
+	int levels = 0;
+	std::vector<float> split;
+	std::vector<std::uint8_t> axis;
+};
+
+} // namespace cml
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include "vec.h"
+
+/*
+Generic R row by C column matrix, stored in column major order.
+
+The element wise operations and products live once in detail::mat_base and are
+shared by every size. mat<3, 3, T> and mat<4, 4, T> are partial specializations
+(in mat3.h and mat4.h) that add their constructors, inverse, determinant and SIMD
+products on top of mat_base. mat3<T> and mat4<T> derive from those and only add
+constructors, so mat4 m; still means mat4<float>. Results of 3x3 and 4x4
+operations are returned as mat3 and mat4.
+
+Element wise operations expand over an index sequence of all R * C elements,
+products are written as sums of scaled columns so every kernel is a vec<R, T>
+operation.
+
+The shorthand aliases follow the GLSL convention, matCxR has C columns and R rows.
+*/
+
+namespace cml
+{
+
+template <std::size_t R, std::size_t C, typename T = float> class mat;
+template <typename T = float> class mat3;
+template <typename T = float> class mat4;
+
+namespace detail
+{
+// The named class for 3x3 and 4x4 matrices, mat<R, C, T> for the others
+template <std::size_t R, std::size_t C, typename T> struct mat_of
+{
+	using type = mat<R, C, T>;
+};
+template <typename T> struct mat_of<3, 3, T>
+{
+	using type = mat3<T>;
+};
+template <typename T> struct mat_of<4, 4, T>
+{
+	using type = mat4<T>;
+};
+
+template <std::size_t R, std::size_t C, typename T>
+using named_mat = typename mat_of<R, C, T>::type;
+
+template <std::size_t R, std::size_t C, typename T> class mat_base
+{
+	static_assert (R > 0 && C > 0, "mat needs at least one row and column");
+	using elements = std::make_index_sequence<R * C>;
+	using columns = std::make_index_sequence<C>;
+
+	public:
+	using value_type = T;
+	static constexpr std::size_t rows = R;
+	static constexpr std::size_t cols = C;
+
+	T data[R * C]; // Stored in column major order
+
+	// Builds the matrix from f(index) over the column major element index
+	template <typename F> static constexpr named_mat<R, C, T> generate (F f)
+	{
+		named_mat<R, C, T> out;
+		fill (out, f, elements{});
+		return out;
+	}
+
+	static constexpr named_mat<R, C, T> from_cols (vec<R, T> const (&col_vecs)[C])
+	{
+		return generate ([&] (std::size_t i) { return col_vecs[i / R][i % R]; });
+	}
+
+	// returns constant address to the data
+	static T const* ptr (mat<R, C, T> const& m) { return &(m.data[0]); }
+
+	T get (int index) const
+	{
+		assert (index >= 0 && index < static_cast<int> (R * C));
+		return data[index];
+	}
+	void set (int index, T value)
+	{
+		assert (index >= 0 && index < static_cast<int> (R * C));
+		data[index] = value;
+	}
+
+	// Resets to zero matrix
+	constexpr void zero ()
+	{
+		for (std::size_t i = 0; i < R * C; i++)
+			data[i] = 0;
+	}
+
+	// get at
+	constexpr T& at (std::size_t const row, std::size_t const col)
+	{
+		assert (row < R && col < C);
+		return data[col * R + row];
+	}
+
+	constexpr T const& at (std::size_t const row, std::size_t const col) const
+	{
+		assert (row < R && col < C);
+		return data[col * R + row];
+	}
+
+	void set (int const row, int const col, T const value) { at (row, col) = value; }
+
+	constexpr named_vec<C, T> get_row (std::size_t const x) const
+	{
+		return vec<C, T>::generate ([&] (std::size_t c) { return at (x, c); });
+	}
+	constexpr named_vec<R, T> get_col (std::size_t const y) const
+	{
+		return vec<R, T>::generate ([&] (std::size_t r) { return at (r, y); });
+	}
+
+	constexpr void set_row (std::size_t const x, vec<C, T> const& val)
+	{
+		for (std::size_t c = 0; c < C; c++)
+			at (x, c) = val[c];
+	}
+	constexpr void set_col (std::size_t const y, vec<R, T> const& val)
+	{
+		for (std::size_t r = 0; r < R; r++)
+			at (r, y) = val[r];
+	}
+
+	// MATRIX ADDITION
+	constexpr named_mat<R, C, T> operator+ (mat<R, C, T> const& val) const
+	{
+		return generate ([&] (std::size_t i) { return data[i] + val.data[i]; });
+	}
+
+	// SCALAR ADDITION
+	constexpr named_mat<R, C, T> operator+ (T const val) const
+	{
+		return generate ([&] (std::size_t i) { return data[i] + val; });
+	}
+
+	// MATRIX SUBTRACTION
+	constexpr named_mat<R, C, T> operator- (mat<R, C, T> const& val) const
+	{
+		return generate ([&] (std::size_t i) { return data[i] - val.data[i]; });
+	}
+
+	// SCALAR SUBTRACTION
+	constexpr named_mat<R, C, T> operator- (T const val) const
+	{
+		return generate ([&] (std::size_t i) { return data[i] - val; });
+	}
+
+	// SCALAR MULTIPLICATION
+	constexpr named_mat<R, C, T> operator* (T const val) const
+	{
+		return generate ([&] (std::size_t i) { return data[i] * val; });
+	}
+
+	// SCALAR DIVISION
+	constexpr named_mat<R, C, T> operator/ (T const val) const
+	{
+		return generate ([&] (std::size_t i) { return data[i] / val; });
+	}
+
+	// VECTOR MULTIPLICATION
+	constexpr named_vec<R, T> operator* (vec<C, T> const& val) const
+	{
+		return mul (val, columns{});
+	}
+
+	// MATRIX MULTIPLICATION
+	template <std::size_t K> constexpr named_mat<R, K, T> operator* (mat<C, K, T> const& val) const
+	{
+		named_mat<R, K, T> out;
+		for (std::size_t k = 0; k < K; k++)
+			out.set_col (k, (*this) * val.get_col (k));
+		return out;
+	}
+
+	// EQUALITY CHECK
+	constexpr bool operator== (mat<R, C, T> const& val) const { return equal (val, elements{}); }
+
+	constexpr bool operator!= (mat<R, C, T> const& val) const { return !(*this == val); }
+
+	// TRANSPOSE
+	constexpr named_mat<C, R, T> transpose () const
+	{
+		return mat<C, R, T>::generate ([&] (std::size_t i) { return at (i / C, i % C); });
+	}
+
+	protected:
+	constexpr mat_base () noexcept : data{} {}
+
+	private:
+	template <typename F, std::size_t... I>
+	static constexpr void fill (named_mat<R, C, T>& out, F f, std::index_sequence<I...>)
+	{
+		((out.data[I] = static_cast<T> (f (I))), ...);
+	}
+
+	template <std::size_t... I>
+	constexpr named_vec<R, T> mul (vec<C, T> const& val, std::index_sequence<I...>) const
+	{
+		return ((get_col (I) * val[I]) + ...);
+	}
+
+	template <std::size_t... I>
+	constexpr bool equal (mat<R, C, T> const& val, std::index_sequence<I...>) const
+	{
+		return ((data[I] == val.data[I]) && ...);
+	}
+};
+} // namespace detail
+
+template <std::size_t R, std::size_t C, typename T> class mat : public detail::mat_base<R, C, T>
+{
+	using base = detail::mat_base<R, C, T>;
+
+	public:
+	// Identity matrix constructor, non square matrices get ones on the main diagonal
+	constexpr mat () noexcept : mat (static_cast<T> (1)) {}
+
+	// fill diagonal constructor
+	constexpr explicit mat (T const val) noexcept
+	{
+		for (std::size_t i = 0; i < R * C; i++)
+			base::data[i] = i % R == i / R ? val : 0;
+	}
+};
+
+template <std::size_t R, std::size_t C, typename T>
+constexpr detail::named_vec<C, T> operator* (vec<R, T> const& val, mat<R, C, T> const& m)
+{
+	return vec<C, T>::generate ([&] (std::size_t c) { return dot (val, m.get_col (c)); });
+}
+
+// DETERMINANT
+
+template <std::size_t N, typename T> constexpr T det (mat<N, N, T> const& m)
+{
+	static_assert (N <= 3, "det is only provided up to 3x3, use mat4::det for 4x4");
+	if constexpr (N == 1)
+		return m.data[0];
+	else if constexpr (N == 2)
+		return m.data[0] * m.data[3] - m.data[2] * m.data[1];
+	else
+		return m.det ();
+}
+
+// INVERSE
+
+template <typename T> constexpr detail::named_mat<2, 2, T> inverse (mat<2, 2, T> const& m)
+{
+	T inv_det = static_cast<T> (1) / det (m);
+	return mat<2, 2, T>::generate ([&] (std::size_t i) {
+		T const adj[4] = { m.data[3], -m.data[1], -m.data[2], m.data[0] };
+		return adj[i] * inv_det;
+	});
+}
+
+template <typename T = float> using mat2 = mat<2, 2, T>;
+template <typename T = float> using mat2x3 = mat<3, 2, T>;
+template <typename T = float> using mat2x4 = mat<4, 2, T>;
+template <typename T = float> using mat3x2 = mat<2, 3, T>;
+template <typename T = float> using mat3x4 = mat<4, 3, T>;
+template <typename T = float> using mat4x2 = mat<2, 4, T>;
+template <typename T = float> using mat4x3 = mat<3, 4, T>;
+
+using mat2f = mat2<float>;
+using mat2d = mat2<double>;
+using mat3x4f = mat3x4<float>;
+using mat3x4d = mat3x4<double>;
+using mat4x3f = mat4x3<float>;
+using mat4x3d = mat4x3<double>;
+
+} // namespace cml
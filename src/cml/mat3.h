@@ -1,212 +1,142 @@
 #pragma once
 
+#include <type_traits>
+
+#include "common.h"
+
+#if defined(CML_SSE2)
+#include <emmintrin.h>
+#endif
+
+#include "mat.h"
 #include "vec3.h"
 
-/* stuff to do.
+/*
+3x3 matrix, mostly used for rotations and normal transforms. mat3<T> derives
+from the mat<3, 3, T> specialization, the element wise operations come from mat.h.
 
-determinant
-inverse
-isIdentity
-[i,j]
-transpose
-Operator * (multiply matricies)
+With SSE2 the float and double products load whole columns at once. data has no
+padding, so the last float column is loaded from data + 5 and shifted down
+instead of reading past the end of the matrix.
 
-setTRS (translation, rotation, and scaling)
+stuff to do.
 
+[i,j]
 
 static functions.
-Create orthographic projection matrix
-Create perspective projection matrix
 create scale matrix
-create TRS (translation, rotation, and scaling)
-
-
 */
 
-// temp!
-
 namespace cml
 {
 
-template <typename T = float> class mat3
+template <typename T> class mat<3, 3, T> : public detail::mat_base<3, 3, T>
 {
-	private:
+	using base = detail::mat_base<3, 3, T>;
 	static constexpr float identity_data[9]{ 1, 0, 0, 0, 1, 0, 0, 0, 1 };
 
 	public:
-	T data[9]; // Stored in column major order
+	using base::at;
+	using base::data;
+	using base::operator*;
 
 	// Identity matrix constructor
-	constexpr mat3 () : data{ 1, 0, 0, 0, 1, 0, 0, 0, 1 } {}
+	constexpr mat () { set_identity (); }
 
 	// copy from array
-	constexpr mat3 (T const val[9])
-	: data{ val[0], val[3], val[6], val[1], val[4], val[7], val[2], val[5], val[8] }
+	constexpr mat (T const val[9])
 	{
+		for (int i = 0; i < 9; i++)
+			at (i / 3, i % 3) = val[i];
 	}
 
 	// Constructor for values
-	constexpr mat3 (
+	constexpr mat (
 	    T const v00, T const v01, T const v02, T const v10, T const v11, T const v12, T const v20, T const v21, T const v22) noexcept
-	: data{ v00, v10, v20, v01, v11, v21, v02, v12, v22 }
-	{
-	}
-
-	constexpr mat3 (vec3<T> const row_a, vec3<T> const row_b, vec3<T> const row_c)
-	{
-		set_row (0, row_a);
-		set_row (1, row_b);
-		set_row (2, row_c);
-	}
-
-	// returns constant address to the data
-	static T const* ptr (mat3<T> const& mat) { return &(mat.data[0]); }
-
-	T get (int index) const
-	{
-		assert (index >= 0 && index <= 8);
-		return data[index];
-	}
-	void set (int index, T value)
-	{
-		assert (index >= 0 && index < 16);
-		data[index] = value;
-	}
-
-	// Resets matrix to identity
-	void set_identity () { data = identity_data; }
-
-	void zero ()
 	{
+		T const rows[9] = { v00, v01, v02, v10, v11, v12, v20, v21, v22 };
 		for (int i = 0; i < 9; i++)
-		{
-			data[i] = 0;
-		}
-	}
-
-	// Get at
-	T& at (int row, int col) { return data[col * 3 + row]; }
-
-	// Const get at
-	const T& at (int row, int col) const { return data[col * 3 + row]; }
-
-	void set (int const row, int const col, T const val) const { at (row, col) = val; }
-
-	vec3<T> get_row (int x) const
-	{
-		assert (x >= 0 && x < 3);
-		return vec3<T> (at (x, 0), at (x, 1), at (x, 2));
-	}
-	vec3<T> get_col (int y) const
-	{
-		assert (y >= 0 && y < 3);
-		return vec3<T> (at (0, y), at (1, y), at (2, y));
-	}
-
-	void set_row (const int i, const vec3<T>& val)
-	{
-		at (0, i) = val.x;
-		at (1, i) = val.y;
-		at (2, i) = val.z;
+			at (i / 3, i % 3) = rows[i];
 	}
 
-	void set_column (const int i, const vec3<T>& val)
+	constexpr mat (vec3<T> const row_a, vec3<T> const row_b, vec3<T> const row_c)
 	{
-		at (i, 0) = val.x;
-		at (i, 1) = val.y;
-		at (i, 2) = val.z;
+		base::set_row (0, row_a);
+		base::set_row (1, row_b);
+		base::set_row (2, row_c);
 	}
 
-	// MATRIX ADDITION
-
-	mat3<T> operator+ (mat3<T> const& val) const
-	{
-		mat3<T> out;
-		for (int i = 0; i < 9; i++)
-			out.data[i] = data[i] + val.data[i];
-		return out;
-	}
-
-	// SCALAR ADDITION
-	mat3<T> operator+ (vec3<T> const& val) const
-	{
-		mat3<T> out;
-		for (int i = 0; i < 9; i++)
-			out.data[i] = data[i] + val;
-		return out;
-	}
-
-	// MATRIX SUBTRACTION
-
-	mat3<T> operator- (mat3<T> const& val) const
+	// Resets matrix to identity
+	constexpr void set_identity ()
 	{
-		mat3<T> out;
 		for (int i = 0; i < 9; i++)
-			out.data[i] = data[i] - val.data[i];
-		return out;
+			data[i] = identity_data[i];
 	}
 
-	// SCALAR SUBTRACTION
-	mat3<T> operator- (T const val) const
-	{
-		mat3<T> out;
-		for (int i = 0; i < 9; i++)
-			out.data[i] = data[i] - val;
-		return out;
-	}
+	bool isIdentity () const { return (*this) == identity; }
 
-	// SCALAR MULTIPLICATION
-	mat3<T> operator* (T const val) const
-	{
-		mat3<T> out;
-		for (int i = 0; i < 9; i++)
-			out.data[i] = data[i] * val;
-		return out;
-	}
+	void set_column (const int i, const vec3<T>& val) { base::set_col (i, val); }
 
 	// VECTOR MULTIPLICATION
-	vec3<T> operator* (const vec3<T>& val)
+	vec3<T> operator* (const vec3<T>& val) const
 	{
-		return vec3<T> (data[0] * val.x + data[3] * val.y + data[6] * val.z,
-		    data[1] * val.x + data[4] * val.y + data[7] * val.z,
-		    data[2] * val.x + data[5] * val.y + data[8] * val.z);
+#if defined(CML_SSE2)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			// vec3<float> is 16 byte aligned with a padding lane
+			__m128 v = _mm_load_ps (&val.x);
+			__m128 r = _mm_mul_ps (column_ps (0), _mm_shuffle_ps (v, v, _MM_SHUFFLE (0, 0, 0, 0)));
+			r = _mm_add_ps (r, _mm_mul_ps (column_ps (1), _mm_shuffle_ps (v, v, _MM_SHUFFLE (1, 1, 1, 1))));
+			r = _mm_add_ps (r, _mm_mul_ps (column_ps (2), _mm_shuffle_ps (v, v, _MM_SHUFFLE (2, 2, 2, 2))));
+			vec3<T> out;
+			_mm_store_ps (&out.x, r);
+			return out;
+		}
+		else if constexpr (std::is_same<T, double>::value)
+		{
+			vec3<T> out;
+			column_pd (val.x, val.y, val.z, &out.x);
+			return out;
+		}
+		else
+#endif
+			return base::operator* (val);
 	}
 
 	// MATRIX MULTIPLICATION
+	// Column j of the product is this * column j of val
 	mat3<T> operator* (mat3<T> const& val) const
 	{
-		return mat3<T> (at (0, 0) * val.at (0, 0) + at (0, 1) * val.at (1, 0) + at (0, 2) * val.at (2, 0),
-		    at (0, 0) * val.at (0, 1) + at (0, 1) * val.at (1, 1) + at (0, 2) * val.at (2, 1),
-		    at (0, 0) * val.at (0, 2) + at (0, 1) * val.at (1, 2) + at (0, 2) * val.at (2, 2),
-		    at (1, 0) * val.at (0, 0) + at (1, 1) * val.at (1, 0) + at (1, 2) * val.at (2, 0),
-		    at (1, 0) * val.at (0, 1) + at (1, 1) * val.at (1, 1) + at (1, 2) * val.at (2, 1),
-		    at (1, 0) * val.at (0, 2) + at (1, 1) * val.at (1, 2) + at (1, 2) * val.at (2, 2),
-		    at (2, 0) * val.at (0, 0) + at (2, 1) * val.at (1, 0) + at (2, 2) * val.at (2, 0),
-		    at (2, 0) * val.at (0, 1) + at (2, 1) * val.at (1, 1) + at (2, 2) * val.at (2, 1),
-		    at (2, 0) * val.at (0, 2) + at (2, 1) * val.at (1, 2) + at (2, 2) * val.at (2, 2));
-	}
-
-	// SCALAR DIVISION
-	mat3<T> operator/ (T const val) const
-	{
+#if defined(CML_SSE2)
 		mat3<T> out;
-		for (int i = 0; i < 9; i++)
-			out.data[i] = data[i] / val;
-		return out;
-	}
-
-	// EQUALITY CHECK
-	bool operator== (const mat3<T>& val) const
-	{
-		for (int i = 0; i < 9; i++)
+		if constexpr (std::is_same<T, float>::value)
+		{
+			__m128 a0 = column_ps (0), a1 = column_ps (1), a2 = column_ps (2);
+			__m128 c[3];
+			for (int j = 0; j < 3; j++)
+			{
+				T const* b = val.data + 3 * j;
+				c[j] = _mm_add_ps (_mm_mul_ps (a0, _mm_set1_ps (b[0])), _mm_mul_ps (a1, _mm_set1_ps (b[1])));
+				c[j] = _mm_add_ps (c[j], _mm_mul_ps (a2, _mm_set1_ps (b[2])));
+			}
+			// the third column is stored shifted up one lane so it ends at data[8]
+			__m128 t = _mm_shuffle_ps (c[1], c[2], _MM_SHUFFLE (0, 0, 2, 2));
+			_mm_storeu_ps (out.data, c[0]);
+			_mm_storeu_ps (out.data + 3, c[1]);
+			_mm_storeu_ps (out.data + 5, _mm_shuffle_ps (t, c[2], _MM_SHUFFLE (2, 1, 2, 0)));
+			return out;
+		}
+		else if constexpr (std::is_same<T, double>::value)
 		{
-			if (data[i] != val.data[i]) return false;
+			for (int j = 0; j < 3; j++)
+				column_pd (val.data[3 * j], val.data[3 * j + 1], val.data[3 * j + 2], out.data + 3 * j);
+			return out;
 		}
-		return true;
+		else
+#endif
+			return base::operator* (val);
 	}
 
-	bool operator!= (const mat3<T>& val) const { return !(*this == val); }
-
 	// Creates a rotation matrix with specified values in degrees
 	static mat3<T> createRotationMatrix (const T xRot, const T yRot, const T zRot)
 	{
@@ -215,12 +145,12 @@ template <typename T = float> class mat3
 		T zRad = radians (zRot);
 
 		mat3<T> ma, mb, mc;
-		float ac = cos (xRad);
-		float as = sin (xRad);
-		float bc = cos (yRad);
-		float bs = sin (yRad);
-		float cc = cos (zRad);
-		float cs = sin (zRad);
+		T ac = cos (xRad);
+		T as = sin (xRad);
+		T bc = cos (yRad);
+		T bs = sin (yRad);
+		T cc = cos (zRad);
+		T cs = sin (zRad);
 
 		ma.at (1, 1) = ac;
 		ma.at (2, 1) = as;
@@ -240,50 +170,70 @@ template <typename T = float> class mat3
 		return ma * mb * mc;
 	}
 
-	T det () const
+	constexpr T det () const
 	{
-		return at (0, 0) * (at (1, 1) * at (2, 2) - at (1, 2) * at (2, 1)) -
-		       at (0, 1) * (at (1, 0) * at (2, 2) - at (1, 2) * at (2, 0)) +
-		       at (0, 2) * (at (1, 0) * at (2, 1) - at (1, 1) * at (2, 0));
+		return data[0] * (data[4] * data[8] - data[7] * data[5]) -
+		       data[3] * (data[1] * data[8] - data[7] * data[2]) +
+		       data[6] * (data[1] * data[5] - data[4] * data[2]);
 	}
 
-	// TRANSPOSE
-	mat3<T> transpose () const
+	// Adjugate over determinant
+	mat3<T> inverse () const
 	{
-		mat3<T> out;
-		for (int i = 0; i < 3; i++)
-		{
-			for (int j = 0; j < 3; j++)
-			{
-				out.at (i, j) = at (j, i);
-			}
-		}
-		return out;
+		T const c00 = data[4] * data[8] - data[7] * data[5];
+		T const c01 = data[7] * data[2] - data[1] * data[8];
+		T const c02 = data[1] * data[5] - data[4] * data[2];
+		T const d = data[0] * c00 + data[3] * c01 + data[6] * c02;
+		T const inv = static_cast<T> (1) / d;
+		return mat3<T> (c00 * inv,
+		    (data[6] * data[5] - data[3] * data[8]) * inv,
+		    (data[3] * data[7] - data[6] * data[4]) * inv,
+		    c01 * inv,
+		    (data[0] * data[8] - data[6] * data[2]) * inv,
+		    (data[6] * data[1] - data[0] * data[7]) * inv,
+		    c02 * inv,
+		    (data[3] * data[2] - data[0] * data[5]) * inv,
+		    (data[0] * data[4] - data[3] * data[1]) * inv);
 	}
 
-	mat3<T> inverse () const
+	private:
+#if defined(CML_SSE2)
+	// Column i in the first three lanes, the last lane holds junk
+	__m128 column_ps (int i) const
 	{
-		// m_row_col
-		T m00 = at (1, 1) * at (2, 2) - at (1, 2) * at (2, 1);
-		T m01 = at (1, 0) * at (2, 2) - at (1, 2) * at (2, 0);
-		T m02 = at (1, 0) * at (2, 1) - at (1, 1) * at (2, 0);
+		if (i < 2) return _mm_loadu_ps (data + 3 * i);
+		__m128 c = _mm_loadu_ps (data + 5);
+		return _mm_shuffle_ps (c, c, _MM_SHUFFLE (3, 3, 2, 1));
+	}
 
-		T m10 = at (0, 1) * at (2, 2) - at (0, 2) * at (2, 1);
-		T m11 = at (0, 0) * at (2, 2) - at (0, 2) * at (2, 0);
-		T m12 = at (0, 0) * at (2, 1) - at (0, 1) * at (2, 0);
+	// out[0..2] = this * (x, y, z), x and y rows in one register and z in another
+	void column_pd (double x, double y, double z, double* out) const
+	{
+		__m128d bx = _mm_set1_pd (x), by = _mm_set1_pd (y), bz = _mm_set1_pd (z);
+		__m128d xy = _mm_add_pd (_mm_mul_pd (_mm_loadu_pd (data), bx), _mm_mul_pd (_mm_loadu_pd (data + 3), by));
+		xy = _mm_add_pd (xy, _mm_mul_pd (_mm_loadu_pd (data + 6), bz));
+		__m128d zz = _mm_add_sd (_mm_mul_sd (_mm_load_sd (data + 2), bx), _mm_mul_sd (_mm_load_sd (data + 5), by));
+		zz = _mm_add_sd (zz, _mm_mul_sd (_mm_load_sd (data + 8), bz));
+		_mm_storeu_pd (out, xy);
+		_mm_store_sd (out + 2, zz);
+	}
+#endif
 
-		T m20 = at (0, 1) * at (1, 2) - at (0, 2) * at (1, 1);
-		T m21 = at (0, 0) * at (1, 2) - at (0, 2) * at (1, 0);
-		T m22 = at (0, 0) * at (1, 1) - at (0, 1) * at (1, 0);
+	public:
+	static const mat3<T> identity;
+};
 
-		return mat3<T> (m00, -m01, m02, -m10, m11, -m12, m20, -m21, m22).transpose () / det ();
-	}
+template <typename T> class mat3 : public mat<3, 3, T>
+{
+	public:
+	using mat<3, 3, T>::mat;
 
+	constexpr mat3 () noexcept {}
 
-	static const mat3<T> identity;
+	constexpr mat3 (mat<3, 3, T> const& m) noexcept : mat<3, 3, T> (m) {}
 };
 
-template <typename T> const mat3<T> mat3<T>::identity = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+template <typename T> const mat3<T> mat<3, 3, T>::identity = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
 
 typedef mat3<float> mat3f;
 typedef mat3<int> mat3i;
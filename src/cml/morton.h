@@ -0,0 +1,435 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+
+#if defined(CML_BMI2)
+#include <immintrin.h>
+#endif
+
+#include "aabb.h"
+#include "parallel.h"
+#include "vec3.h"
+
+/*
+Morton (Z order) and Hilbert curve keys for 3D points, and a radix sort to reorder
+point arrays along them.
+
+30 bit keys hold 10 bits per axis, 63 bit keys 21 bits per axis. Float points are
+first quantized to the integer grid spanned by a bounding box. Single key
+encoding uses PDEP/PEXT when compiled with BMI2. The bulk encoders use shift and
+mask bit spreading written as plain lane loops, which the compiler vectorizes,
+and which is also faster than PDEP on CPUs that microcode it.
+
+Sorting points by either key puts points that are close in space close in
+memory. Hilbert keys cost more to compute but never jump across the domain, so
+they give slightly better locality.
+*/
+
+namespace cml
+{
+
+namespace detail
+{
+// Spreads the low 10 bits of v so there are two zero bits between each
+inline std::uint32_t spread3 (std::uint32_t v)
+{
+	v &= 0x3ffu;
+	v = (v | (v << 16)) & 0x030000ffu;
+	v = (v | (v << 8)) & 0x0300f00fu;
+	v = (v | (v << 4)) & 0x030c30c3u;
+	v = (v | (v << 2)) & 0x09249249u;
+	return v;
+}
+
+inline std::uint32_t compact3 (std::uint32_t v)
+{
+	v &= 0x09249249u;
+	v = (v | (v >> 2)) & 0x030c30c3u;
+	v = (v | (v >> 4)) & 0x0300f00fu;
+	v = (v | (v >> 8)) & 0x030000ffu;
+	v = (v | (v >> 16)) & 0x3ffu;
+	return v;
+}
+
+// Spreads the low 21 bits of v so there are two zero bits between each
+inline std::uint64_t spread3 (std::uint64_t v)
+{
+	v &= 0x1fffffull;
+	v = (v | (v << 32)) & 0x001f00000000ffffull;
+	v = (v | (v << 16)) & 0x001f0000ff0000ffull;
+	v = (v | (v << 8)) & 0x100f00f00f00f00full;
+	v = (v | (v << 4)) & 0x10c30c30c30c30c3ull;
+	v = (v | (v << 2)) & 0x1249249249249249ull;
+	return v;
+}
+
+inline std::uint64_t compact3 (std::uint64_t v)
+{
+	v &= 0x1249249249249249ull;
+	v = (v | (v >> 2)) & 0x10c30c30c30c30c3ull;
+	v = (v | (v >> 4)) & 0x100f00f00f00f00full;
+	v = (v | (v >> 8)) & 0x001f0000ff0000ffull;
+	v = (v | (v >> 16)) & 0x001f00000000ffffull;
+	v = (v | (v >> 32)) & 0x1fffffull;
+	return v;
+}
+
+template <typename Key> Key interleave3 (std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+#if defined(CML_BMI2)
+	if constexpr (sizeof (Key) == 4)
+		return _pdep_u32 (x, 0x09249249u) | _pdep_u32 (y, 0x12492492u) | _pdep_u32 (z, 0x24924924u);
+	else
+		return _pdep_u64 (x, 0x1249249249249249ull) | _pdep_u64 (y, 0x2492492492492492ull) |
+		       _pdep_u64 (z, 0x4924924924924924ull);
+#else
+	return spread3 (Key (x)) | (spread3 (Key (y)) << 1) | (spread3 (Key (z)) << 2);
+#endif
+}
+
+template <typename Key> vec3<int> deinterleave3 (Key key)
+{
+#if defined(CML_BMI2)
+	if constexpr (sizeof (Key) == 4)
+		return vec3<int> (static_cast<int> (_pext_u32 (key, 0x09249249u)),
+		    static_cast<int> (_pext_u32 (key, 0x12492492u)),
+		    static_cast<int> (_pext_u32 (key, 0x24924924u)));
+	else
+		return vec3<int> (static_cast<int> (_pext_u64 (key, 0x1249249249249249ull)),
+		    static_cast<int> (_pext_u64 (key, 0x2492492492492492ull)),
+		    static_cast<int> (_pext_u64 (key, 0x4924924924924924ull)));
+#else
+	return vec3<int> (static_cast<int> (compact3 (key)),
+	    static_cast<int> (compact3 (Key (key >> 1))),
+	    static_cast<int> (compact3 (Key (key >> 2))));
+#endif
+}
+
+// Skilling's transform from axes to the transposed Hilbert index, branch free
+template <int Bits> void hilbert_transpose (std::uint32_t (&x)[3])
+{
+	for (std::uint32_t q = 1u << (Bits - 1); q > 1; q >>= 1)
+	{
+		std::uint32_t p = q - 1;
+		for (int i = 0; i < 3; i++)
+		{
+			std::uint32_t set = 0u - ((x[i] & q) != 0);
+			std::uint32_t t = (x[0] ^ x[i]) & p & ~set;
+			x[0] ^= (p & set) | t;
+			x[i] ^= t;
+		}
+	}
+	x[1] ^= x[0];
+	x[2] ^= x[1];
+	std::uint32_t t = 0;
+	for (std::uint32_t q = 1u << (Bits - 1); q > 1; q >>= 1)
+		t ^= (q - 1) & (0u - ((x[2] & q) != 0));
+	x[0] ^= t, x[1] ^= t, x[2] ^= t;
+}
+
+template <int Bits> void hilbert_untranspose (std::uint32_t (&x)[3])
+{
+	std::uint32_t t = x[2] >> 1;
+	x[2] ^= x[1];
+	x[1] ^= x[0];
+	x[0] ^= t;
+	for (std::uint32_t q = 2; q != (1u << Bits); q <<= 1)
+	{
+		std::uint32_t p = q - 1;
+		for (int i = 2; i >= 0; i--)
+		{
+			std::uint32_t set = 0u - ((x[i] & q) != 0);
+			std::uint32_t s = (x[0] ^ x[i]) & p & ~set;
+			x[0] ^= (p & set) | s;
+			x[i] ^= s;
+		}
+	}
+}
+
+template <typename Key, int Bits> Key hilbert_encode (vec3<int> const& c)
+{
+	std::uint32_t x[3] = { static_cast<std::uint32_t> (c.x), static_cast<std::uint32_t> (c.y),
+		static_cast<std::uint32_t> (c.z) };
+	hilbert_transpose<Bits> (x);
+	// the first axis holds the most significant bit of each triple
+	return interleave3<Key> (x[2], x[1], x[0]);
+}
+
+template <typename Key, int Bits> vec3<int> hilbert_decode (Key key)
+{
+	vec3<int> t = deinterleave3 (key);
+	std::uint32_t x[3] = { static_cast<std::uint32_t> (t.z), static_cast<std::uint32_t> (t.y),
+		static_cast<std::uint32_t> (t.x) };
+	hilbert_untranspose<Bits> (x);
+	return vec3<int> (static_cast<int> (x[0]), static_cast<int> (x[1]), static_cast<int> (x[2]));
+}
+} // namespace detail
+
+// QUANTIZATION
+
+// Maps p inside bounds onto the integer grid [0, 2^bits - 1] on each axis, clamping outside points
+inline vec3<int> quantize (vec3<float> const& p, aabb<float> const& bounds, int bits)
+{
+	float const cells = static_cast<float> (1 << bits);
+	float const top = cells - 1.f;
+	vec3<float> e = bounds.extent ();
+	vec3<float> scale (e.x > 0.f ? cells / e.x : 0.f, e.y > 0.f ? cells / e.y : 0.f, e.z > 0.f ? cells / e.z : 0.f);
+	vec3<float> q = cml::min (cml::max ((p - bounds.min) * scale, vec3<float> (0.f)), vec3<float> (top));
+	return vec3<int> (static_cast<int> (q.x), static_cast<int> (q.y), static_cast<int> (q.z));
+}
+
+// MORTON
+
+inline std::uint32_t morton_encode30 (vec3<int> const& c)
+{
+	return detail::interleave3<std::uint32_t> (static_cast<std::uint32_t> (c.x) & 0x3ffu,
+	    static_cast<std::uint32_t> (c.y) & 0x3ffu,
+	    static_cast<std::uint32_t> (c.z) & 0x3ffu);
+}
+
+inline std::uint64_t morton_encode63 (vec3<int> const& c)
+{
+	return detail::interleave3<std::uint64_t> (static_cast<std::uint32_t> (c.x) & 0x1fffffu,
+	    static_cast<std::uint32_t> (c.y) & 0x1fffffu,
+	    static_cast<std::uint32_t> (c.z) & 0x1fffffu);
+}
+
+inline vec3<int> morton_decode30 (std::uint32_t key) { return detail::deinterleave3 (key); }
+inline vec3<int> morton_decode63 (std::uint64_t key) { return detail::deinterleave3 (key); }
+
+inline std::uint32_t morton_encode30 (vec3<float> const& p, aabb<float> const& bounds)
+{
+	return morton_encode30 (quantize (p, bounds, 10));
+}
+
+inline std::uint64_t morton_encode63 (vec3<float> const& p, aabb<float> const& bounds)
+{
+	return morton_encode63 (quantize (p, bounds, 21));
+}
+
+// HILBERT
+
+inline std::uint32_t hilbert_encode30 (vec3<int> const& c)
+{
+	return detail::hilbert_encode<std::uint32_t, 10> (
+	    vec3<int> (c.x & 0x3ff, c.y & 0x3ff, c.z & 0x3ff));
+}
+
+inline std::uint64_t hilbert_encode63 (vec3<int> const& c)
+{
+	return detail::hilbert_encode<std::uint64_t, 21> (
+	    vec3<int> (c.x & 0x1fffff, c.y & 0x1fffff, c.z & 0x1fffff));
+}
+
+inline vec3<int> hilbert_decode30 (std::uint32_t key) { return detail::hilbert_decode<std::uint32_t, 10> (key); }
+inline vec3<int> hilbert_decode63 (std::uint64_t key) { return detail::hilbert_decode<std::uint64_t, 21> (key); }
+
+inline std::uint32_t hilbert_encode30 (vec3<float> const& p, aabb<float> const& bounds)
+{
+	return hilbert_encode30 (quantize (p, bounds, 10));
+}
+
+inline std::uint64_t hilbert_encode63 (vec3<float> const& p, aabb<float> const& bounds)
+{
+	return hilbert_encode63 (quantize (p, bounds, 21));
+}
+
+// BULK ENCODING
+
+// out[i] = morton_encode30 (in[i], bounds)
+inline void morton_encode30 (vec3<float> const* in, std::uint32_t* out, std::size_t count, aabb<float> const& bounds)
+{
+	for (std::size_t i = 0; i < count; i++)
+	{
+		vec3<int> c = quantize (in[i], bounds, 10);
+		out[i] = detail::spread3 (std::uint32_t (c.x)) | (detail::spread3 (std::uint32_t (c.y)) << 1) |
+		         (detail::spread3 (std::uint32_t (c.z)) << 2);
+	}
+}
+
+// out[i] = morton_encode63 (in[i], bounds)
+inline void morton_encode63 (vec3<float> const* in, std::uint64_t* out, std::size_t count, aabb<float> const& bounds)
+{
+	for (std::size_t i = 0; i < count; i++)
+	{
+		vec3<int> c = quantize (in[i], bounds, 21);
+		out[i] = detail::spread3 (std::uint64_t (c.x)) | (detail::spread3 (std::uint64_t (c.y)) << 1) |
+		         (detail::spread3 (std::uint64_t (c.z)) << 2);
+	}
+}
+
+inline void morton_encode30 (vec3<int> const* in, std::uint32_t* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = detail::spread3 (std::uint32_t (in[i].x)) | (detail::spread3 (std::uint32_t (in[i].y)) << 1) |
+		         (detail::spread3 (std::uint32_t (in[i].z)) << 2);
+}
+
+inline void morton_encode63 (vec3<int> const* in, std::uint64_t* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = detail::spread3 (std::uint64_t (in[i].x)) | (detail::spread3 (std::uint64_t (in[i].y)) << 1) |
+		         (detail::spread3 (std::uint64_t (in[i].z)) << 2);
+}
+
+inline void hilbert_encode30 (vec3<float> const* in, std::uint32_t* out, std::size_t count, aabb<float> const& bounds)
+{
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = hilbert_encode30 (in[i], bounds);
+}
+
+inline void hilbert_encode63 (vec3<float> const* in, std::uint64_t* out, std::size_t count, aabb<float> const& bounds)
+{
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = hilbert_encode63 (in[i], bounds);
+}
+
+inline void hilbert_encode30 (vec3<int> const* in, std::uint32_t* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = hilbert_encode30 (in[i]);
+}
+
+inline void hilbert_encode63 (vec3<int> const* in, std::uint64_t* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = hilbert_encode63 (in[i]);
+}
+
+// RADIX SORT
+
+// Stable LSD radix sort of keys, one byte per pass. order receives the input index
+// of each sorted key. Passes where every key has the same byte are skipped.
+template <typename Key>
+void radix_sort (Key* keys, std::uint32_t* order, std::size_t count, unsigned threads = 1)
+{
+	static_assert (std::is_unsigned<Key>::value, "radix_sort needs unsigned keys");
+	constexpr std::size_t min_chunk = 16384;
+	constexpr std::size_t radix = 256;
+
+	std::size_t chunks = threads == 0 ? 1 : threads;
+	std::size_t per_chunk = std::max ((count + chunks - 1) / chunks, min_chunk);
+	chunks = count == 0 ? 1 : (count + per_chunk - 1) / per_chunk;
+
+	for (std::size_t i = 0; i < count; i++)
+		order[i] = static_cast<std::uint32_t> (i);
+
+	std::vector<Key> key_scratch (count);
+	std::vector<std::uint32_t> order_scratch (count);
+	std::vector<std::uint32_t> counts (chunks * radix);
+	Key* src_keys = keys;
+	Key* dst_keys = key_scratch.data ();
+	std::uint32_t* src_order = order;
+	std::uint32_t* dst_order = order_scratch.data ();
+
+	for (int shift = 0; shift < static_cast<int> (sizeof (Key) * 8); shift += 8)
+	{
+		std::fill (counts.begin (), counts.end (), 0);
+		parallel_for (
+		    chunks,
+		    1,
+		    [&] (std::size_t first_chunk, std::size_t last_chunk) {
+			    for (std::size_t c = first_chunk; c < last_chunk; c++)
+			    {
+				    std::uint32_t* hist = &counts[c * radix];
+				    std::size_t last = std::min (count, (c + 1) * per_chunk);
+				    for (std::size_t i = c * per_chunk; i < last; i++)
+					    hist[(src_keys[i] >> shift) & 0xff]++;
+			    }
+		    },
+		    threads);
+
+		std::uint32_t offset = 0;
+		bool trivial = false;
+		for (std::size_t b = 0; b < radix; b++)
+		{
+			std::uint32_t total = 0;
+			for (std::size_t c = 0; c < chunks; c++)
+			{
+				std::uint32_t n = counts[c * radix + b];
+				counts[c * radix + b] = offset + total;
+				total += n;
+			}
+			trivial |= total == count;
+			offset += total;
+		}
+		if (trivial) continue;
+
+		parallel_for (
+		    chunks,
+		    1,
+		    [&] (std::size_t first_chunk, std::size_t last_chunk) {
+			    for (std::size_t c = first_chunk; c < last_chunk; c++)
+			    {
+				    std::uint32_t* next = &counts[c * radix];
+				    std::size_t last = std::min (count, (c + 1) * per_chunk);
+				    for (std::size_t i = c * per_chunk; i < last; i++)
+				    {
+					    std::uint32_t slot = next[(src_keys[i] >> shift) & 0xff]++;
+					    dst_keys[slot] = src_keys[i];
+					    dst_order[slot] = src_order[i];
+				    }
+			    }
+		    },
+		    threads);
+		std::swap (src_keys, dst_keys);
+		std::swap (src_order, dst_order);
+	}
+
+	if (src_keys != keys)
+	{
+		std::copy (src_keys, src_keys + count, keys);
+		std::copy (src_order, src_order + count, order);
+	}
+}
+
+// SPATIAL SORT
+
+enum class curve
+{
+	morton,
+	hilbert
+};
+
+namespace detail
+{
+template <typename T> void permute (T* data, std::uint32_t const* order, std::size_t count)
+{
+	std::vector<T> sorted;
+	sorted.reserve (count);
+	for (std::size_t i = 0; i < count; i++)
+		sorted.push_back (std::move (data[order[i]]));
+	std::move (sorted.begin (), sorted.end (), data);
+}
+} // namespace detail
+
+// Reorders points, and every payload array alongside, along a space filling
+// curve through bounds. Uses 30 bit keys, 1024 cells per axis.
+template <typename... Payload>
+void spatial_sort (vec3<float>* points,
+    std::size_t count,
+    aabb<float> const& bounds,
+    curve kind = curve::morton,
+    unsigned threads = 1,
+    Payload*... payload)
+{
+	std::vector<std::uint32_t> keys (count);
+	if (kind == curve::morton)
+		morton_encode30 (points, keys.data (), count, bounds);
+	else
+		hilbert_encode30 (points, keys.data (), count, bounds);
+
+	std::vector<std::uint32_t> order (count);
+	radix_sort (keys.data (), order.data (), count, threads);
+	detail::permute (points, order.data (), count);
+	(detail::permute (payload, order.data (), count), ...);
+}
+
+} // namespace cml
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "mat3.h"
+#include "parallel.h"
+#include "vec3.h"
+
+/*
+Principal axes and oriented bounding boxes of point sets.
+
+eigen_symmetric diagonalizes a symmetric mat3 with cyclic Jacobi rotations, which
+converges in a handful of sweeps for 3x3 and stays accurate for repeated
+eigenvalues.
+
+Mean and covariance are accumulated in one pass with Welford's update. The
+points are dealt round robin to 8 lanes whose accumulators update in lockstep,
+so the update vectorizes, and lanes and threads are merged at the end with
+Chan's pairwise formula.
+*/
+
+namespace cml
+{
+
+// EIGEN SOLVER
+
+// Eigen decomposition of a symmetric matrix. values are sorted largest first and the
+// matching unit eigenvectors are the columns of vectors.
+template <typename T> void eigen_symmetric (mat3<T> const& m, vec3<T>& values, mat3<T>& vectors)
+{
+	T a[3][3], v[3][3];
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+		{
+			a[r][c] = m.data[c * 3 + r];
+			v[r][c] = r == c ? static_cast<T> (1) : static_cast<T> (0);
+		}
+
+	int const pairs[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+	for (int sweep = 0; sweep < 32; sweep++)
+	{
+		T off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+		T diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+		if (off <= std::numeric_limits<T>::epsilon () * std::numeric_limits<T>::epsilon () * diag) break;
+
+		for (auto const& pair : pairs)
+		{
+			int const p = pair[0], q = pair[1];
+			if (a[p][q] == 0) continue;
+			// rotation angle which zeroes a[p][q]
+			T theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+			T t = static_cast<T> (1) / (std::abs (theta) + std::sqrt (theta * theta + 1));
+			if (theta < 0) t = -t;
+			T c = static_cast<T> (1) / std::sqrt (t * t + 1);
+			T s = t * c;
+			for (int k = 0; k < 3; k++)
+			{
+				T kp = a[k][p], kq = a[k][q];
+				a[k][p] = c * kp - s * kq;
+				a[k][q] = s * kp + c * kq;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				T pk = a[p][k], qk = a[q][k];
+				a[p][k] = c * pk - s * qk;
+				a[q][k] = s * pk + c * qk;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				T kp = v[k][p], kq = v[k][q];
+				v[k][p] = c * kp - s * kq;
+				v[k][q] = s * kp + c * kq;
+			}
+		}
+	}
+
+	int order[3] = { 0, 1, 2 };
+	for (int i = 0; i < 2; i++)
+		for (int j = i + 1; j < 3; j++)
+			if (a[order[j]][order[j]] > a[order[i]][order[i]]) std::swap (order[i], order[j]);
+
+	values = vec3<T> (a[order[0]][order[0]], a[order[1]][order[1]], a[order[2]][order[2]]);
+	for (int c = 0; c < 3; c++)
+		for (int r = 0; r < 3; r++)
+			vectors.data[c * 3 + r] = v[r][order[c]];
+}
+
+// MOMENTS
+
+// Running count, mean and sum of squared deviations of a point set
+template <typename T = float> struct moments
+{
+	std::size_t count = 0;
+	vec3<T> mean;
+	T xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+
+	void add (vec3<T> const& p)
+	{
+		count++;
+		vec3<T> delta = p - mean;
+		mean += delta / static_cast<T> (count);
+		vec3<T> delta2 = p - mean;
+		xx += delta.x * delta2.x, xy += delta.x * delta2.y, xz += delta.x * delta2.z;
+		yy += delta.y * delta2.y, yz += delta.y * delta2.z, zz += delta.z * delta2.z;
+	}
+
+	// Combines with the moments of another set of points
+	void merge (moments const& o)
+	{
+		if (o.count == 0) return;
+		if (count == 0)
+		{
+			*this = o;
+			return;
+		}
+		T const n = static_cast<T> (count + o.count);
+		T const w = static_cast<T> (count) * static_cast<T> (o.count) / n;
+		vec3<T> delta = o.mean - mean;
+		mean += delta * (static_cast<T> (o.count) / n);
+		xx += o.xx + delta.x * delta.x * w, xy += o.xy + delta.x * delta.y * w, xz += o.xz + delta.x * delta.z * w;
+		yy += o.yy + delta.y * delta.y * w, yz += o.yz + delta.y * delta.z * w, zz += o.zz + delta.z * delta.z * w;
+		count += o.count;
+	}
+
+	// Population covariance
+	mat3<T> covariance () const
+	{
+		T inv = count > 0 ? static_cast<T> (1) / static_cast<T> (count) : static_cast<T> (0);
+		return mat3<T> (xx * inv, xy * inv, xz * inv, xy * inv, yy * inv, yz * inv, xz * inv, yz * inv, zz * inv);
+	}
+};
+
+namespace detail
+{
+// Welford over 8 lanes in lockstep, lane l takes points l, l + 8, l + 16 ...
+template <typename T> moments<T> lane_moments (vec3<T> const* points, std::size_t count)
+{
+	constexpr std::size_t W = 8;
+	T mx[W] = {}, my[W] = {}, mz[W] = {};
+	T sxx[W] = {}, sxy[W] = {}, sxz[W] = {}, syy[W] = {}, syz[W] = {}, szz[W] = {};
+	std::size_t const blocks = count / W;
+	for (std::size_t b = 0; b < blocks; b++)
+	{
+		T const inv_n = static_cast<T> (1) / static_cast<T> (b + 1);
+		vec3<T> const* block = points + b * W;
+		for (std::size_t l = 0; l < W; l++)
+		{
+			T dx = block[l].x - mx[l], dy = block[l].y - my[l], dz = block[l].z - mz[l];
+			mx[l] += dx * inv_n, my[l] += dy * inv_n, mz[l] += dz * inv_n;
+			T ex = block[l].x - mx[l], ey = block[l].y - my[l], ez = block[l].z - mz[l];
+			sxx[l] += dx * ex, sxy[l] += dx * ey, sxz[l] += dx * ez;
+			syy[l] += dy * ey, syz[l] += dy * ez, szz[l] += dz * ez;
+		}
+	}
+
+	moments<T> out;
+	for (std::size_t l = 0; l < W && blocks > 0; l++)
+	{
+		moments<T> lane;
+		lane.count = blocks;
+		lane.mean = vec3<T> (mx[l], my[l], mz[l]);
+		lane.xx = sxx[l], lane.xy = sxy[l], lane.xz = sxz[l];
+		lane.yy = syy[l], lane.yz = syz[l], lane.zz = szz[l];
+		out.merge (lane);
+	}
+	for (std::size_t i = blocks * W; i < count; i++)
+		out.add (points[i]);
+	return out;
+}
+} // namespace detail
+
+// Mean and covariance of count points in one pass, split over threads
+template <typename T> moments<T> compute_moments (vec3<T> const* points, std::size_t count, unsigned threads = 1)
+{
+	std::size_t const grain = 16384;
+	std::size_t chunks = threads == 0 ? 1 : threads;
+	std::size_t per_chunk = (count + chunks - 1) / chunks;
+	per_chunk = per_chunk < grain ? grain : per_chunk;
+	chunks = count == 0 ? 0 : (count + per_chunk - 1) / per_chunk;
+
+	std::vector<moments<T>> partial (chunks);
+	parallel_for (
+	    chunks,
+	    1,
+	    [&] (std::size_t first, std::size_t last) {
+		    for (std::size_t c = first; c < last; c++)
+		    {
+			    std::size_t begin = c * per_chunk;
+			    std::size_t n = count - begin < per_chunk ? count - begin : per_chunk;
+			    partial[c] = detail::lane_moments (points + begin, n);
+		    }
+	    },
+	    threads);
+
+	moments<T> out;
+	for (auto const& p : partial)
+		out.merge (p);
+	return out;
+}
+
+// OBB
+
+// Box with center, orthonormal axes as the columns of a rotation and half extents along them
+template <typename T = float> struct obb
+{
+	vec3<T> center;
+	mat3<T> axes;
+	vec3<T> half_extent;
+
+	vec3<T> axis (int i) const
+	{
+		return vec3<T> (axes.data[i * 3], axes.data[i * 3 + 1], axes.data[i * 3 + 2]);
+	}
+
+	bool contains (vec3<T> const& p, T tolerance = 0) const
+	{
+		vec3<T> d = p - center;
+		return std::abs (dot (d, axis (0))) <= half_extent.x + tolerance &&
+		       std::abs (dot (d, axis (1))) <= half_extent.y + tolerance &&
+		       std::abs (dot (d, axis (2))) <= half_extent.z + tolerance;
+	}
+
+	T volume () const { return 8 * half_extent.x * half_extent.y * half_extent.z; }
+};
+
+// Box aligned with the principal axes of the points, tight along each axis
+template <typename T> obb<T> fit_obb (vec3<T> const* points, std::size_t count, unsigned threads = 1)
+{
+	obb<T> out;
+	if (count == 0) return out;
+
+	vec3<T> values;
+	eigen_symmetric (compute_moments (points, count, threads).covariance (), values, out.axes);
+	// keep the axes right handed
+	vec3<T> a0 = out.axis (0), a1 = out.axis (1), a2 = cross (a0, a1);
+	out.axes.data[6] = a2.x, out.axes.data[7] = a2.y, out.axes.data[8] = a2.z;
+
+	vec3<T> lo (std::numeric_limits<T>::max ()), hi (std::numeric_limits<T>::lowest ());
+	for (std::size_t i = 0; i < count; i++)
+	{
+		vec3<T> p (dot (points[i], a0), dot (points[i], a1), dot (points[i], a2));
+		lo = min (lo, p);
+		hi = max (hi, p);
+	}
+	vec3<T> mid = (lo + hi) * static_cast<T> (0.5);
+	out.center = a0 * mid.x + a1 * mid.y + a2 * mid.z;
+	out.half_extent = (hi - lo) * static_cast<T> (0.5);
+	return out;
+}
+
+} // namespace cml
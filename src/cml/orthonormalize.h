@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#include "common.h"
+
+#if defined(CML_SSE2)
+#include <emmintrin.h>
+#endif
+
+#include "mat3.h"
+#include "mat4.h"
+#include "quat.h"
+#include "vec3.h"
+
+/*
+Repairs rotations that drifted away from orthonormal or unit length after long
+chains of multiplications.
+
+polar_rotation finds the closest orthogonal matrix with Higham's scaled Newton
+iteration X = (g X + X^-T / g) / 2. A matrix that only drifted a little converges
+in one or two steps. orthonormalize is the cheaper Gram-Schmidt alternative which
+keeps the first column fixed.
+
+renormalize rescales arrays of quaternions by 1 / sqrt (|q|^2). Values already
+close to unit length take one Newton step from 1, which is within a few float
+ulps, others refine the SSE reciprocal square root estimate the same way.
+*/
+
+namespace cml
+{
+
+// GRAM-SCHMIDT
+
+// Orthonormal basis with the direction of the first column, the second column in the
+// plane of the first two and a right handed third column.
+template <typename T> mat3<T> orthonormalize (mat3<T> const& m)
+{
+	vec3<T> x = normalize (m.get_col (0));
+	vec3<T> y = m.get_col (1);
+	y = normalize (y - x * dot (x, y));
+	mat3<T> out;
+	out.set_column (0, x);
+	out.set_column (1, y);
+	out.set_column (2, cross (x, y));
+	return out;
+}
+
+// Orthonormalizes the upper 3x3 of a transform, keeping its translation and last row
+template <typename T> mat4<T> orthonormalize (mat4<T> const& m)
+{
+	vec3<T> x = normalize (vec3<T> (m.data[0], m.data[1], m.data[2]));
+	vec3<T> y (m.data[4], m.data[5], m.data[6]);
+	y = normalize (y - x * dot (x, y));
+	vec3<T> z = cross (x, y);
+	mat4<T> out = m;
+	out.set_col (0, x);
+	out.set_col (1, y);
+	out.set_col (2, z);
+	return out;
+}
+
+// POLAR DECOMPOSITION
+
+namespace detail
+{
+// One scaled Newton step of the polar iteration on a column major 3x3, returns the
+// squared Frobenius norm of the change, or a negative value for a singular matrix
+template <typename T> T polar_step (T* x)
+{
+	T c[9];
+	c[0] = x[4] * x[8] - x[7] * x[5];
+	c[3] = x[7] * x[2] - x[1] * x[8];
+	c[6] = x[1] * x[5] - x[4] * x[2];
+	c[1] = x[6] * x[5] - x[3] * x[8];
+	c[4] = x[0] * x[8] - x[6] * x[2];
+	c[7] = x[3] * x[2] - x[0] * x[5];
+	c[2] = x[3] * x[7] - x[6] * x[4];
+	c[5] = x[6] * x[1] - x[0] * x[7];
+	c[8] = x[0] * x[4] - x[3] * x[1];
+	T det = x[0] * c[0] + x[3] * c[3] + x[6] * c[6];
+	if (det == 0) return static_cast<T> (-1);
+
+	// X^-T = C / det, and g = sqrt (|X^-1| / |X|) in Frobenius norms
+	T x2 = 0, c2 = 0;
+	for (int k = 0; k < 9; k++)
+		x2 += x[k] * x[k], c2 += c[k] * c[k];
+	T g = std::sqrt (std::sqrt (c2 / (det * det * x2)));
+	T a = g * static_cast<T> (0.5), b = static_cast<T> (0.5) / (g * det);
+
+	T change = 0;
+	for (int k = 0; k < 9; k++)
+	{
+		T next = a * x[k] + b * c[k];
+		change += (next - x[k]) * (next - x[k]);
+		x[k] = next;
+	}
+	return change;
+}
+} // namespace detail
+
+// Orthogonal factor R of m = R S with S symmetric positive semi definite, the closest
+// orthogonal matrix to m. R is a reflection when det (m) < 0. Singular matrices fall
+// back to Gram-Schmidt.
+template <typename T> mat3<T> polar_rotation (mat3<T> const& m, int max_iterations = 16)
+{
+	T const tolerance = std::numeric_limits<T>::epsilon () * std::numeric_limits<T>::epsilon () * 64;
+	mat3<T> x = m;
+	for (int i = 0; i < max_iterations; i++)
+	{
+		T change = detail::polar_step (x.data);
+		if (change < 0) return orthonormalize (m);
+		if (change <= tolerance * 9) break;
+	}
+	return x;
+}
+
+// m = rotation * stretch
+template <typename T>
+void polar_decomposition (mat3<T> const& m, mat3<T>& rotation, mat3<T>& stretch, int max_iterations = 16)
+{
+	rotation = polar_rotation (m, max_iterations);
+	mat3<T> s = rotation.transpose () * m;
+	stretch = (s + s.transpose ()) * static_cast<T> (0.5);
+}
+
+// Batched polar_rotation. Works on blocks of 8 matrices with every entry in its own lane
+// array, iterating until every matrix of the block converged.
+template <typename T>
+void polar_rotation (mat3<T> const* in, mat3<T>* out, std::size_t count, int max_iterations = 16)
+{
+	constexpr std::size_t W = 8;
+	T const tolerance = std::numeric_limits<T>::epsilon () * std::numeric_limits<T>::epsilon () * 64 * 9;
+	for (std::size_t first = 0; first < count; first += W)
+	{
+		std::size_t const n = count - first < W ? count - first : W;
+		// unused lanes hold the identity, which is already converged
+		T x[9][W];
+		for (std::size_t l = 0; l < W; l++)
+			for (int k = 0; k < 9; k++)
+				x[k][l] = l < n ? in[first + l].data[k] : static_cast<T> (k % 4 == 0 ? 1 : 0);
+
+		for (int i = 0; i < max_iterations; i++)
+		{
+			T c[9][W], a[W], b[W], change[W];
+			for (std::size_t l = 0; l < W; l++)
+			{
+				c[0][l] = x[4][l] * x[8][l] - x[7][l] * x[5][l];
+				c[3][l] = x[7][l] * x[2][l] - x[1][l] * x[8][l];
+				c[6][l] = x[1][l] * x[5][l] - x[4][l] * x[2][l];
+				c[1][l] = x[6][l] * x[5][l] - x[3][l] * x[8][l];
+				c[4][l] = x[0][l] * x[8][l] - x[6][l] * x[2][l];
+				c[7][l] = x[3][l] * x[2][l] - x[0][l] * x[5][l];
+				c[2][l] = x[3][l] * x[7][l] - x[6][l] * x[4][l];
+				c[5][l] = x[6][l] * x[1][l] - x[0][l] * x[7][l];
+				c[8][l] = x[0][l] * x[4][l] - x[3][l] * x[1][l];
+			}
+			for (std::size_t l = 0; l < W; l++)
+			{
+				T det = x[0][l] * c[0][l] + x[3][l] * c[3][l] + x[6][l] * c[6][l];
+				T x2 = 0, c2 = 0;
+				for (int k = 0; k < 9; k++)
+					x2 += x[k][l] * x[k][l], c2 += c[k][l] * c[k][l];
+				// singular lanes are left untouched and repaired below
+				bool singular = det == 0;
+				det = singular ? static_cast<T> (1) : det;
+				T g = singular ? static_cast<T> (1) : std::sqrt (std::sqrt (c2 / (det * det * x2)));
+				a[l] = singular ? static_cast<T> (1) : g * static_cast<T> (0.5);
+				b[l] = singular ? static_cast<T> (0) : static_cast<T> (0.5) / (g * det);
+			}
+			for (std::size_t l = 0; l < W; l++)
+				change[l] = 0;
+			for (int k = 0; k < 9; k++)
+				for (std::size_t l = 0; l < W; l++)
+				{
+					T next = a[l] * x[k][l] + b[l] * c[k][l];
+					change[l] += (next - x[k][l]) * (next - x[k][l]);
+					x[k][l] = next;
+				}
+
+			T largest = 0;
+			for (std::size_t l = 0; l < W; l++)
+				largest = change[l] > largest ? change[l] : largest;
+			if (largest <= tolerance) break;
+		}
+
+		for (std::size_t l = 0; l < n; l++)
+		{
+			for (int k = 0; k < 9; k++)
+				out[first + l].data[k] = x[k][l];
+			if (in[first + l].det () == 0) out[first + l] = orthonormalize (in[first + l]);
+		}
+	}
+}
+
+// QUATERNION RENORMALIZATION
+
+// q[i] = q[i] / |q[i]|
+template <typename T> void renormalize (quat<T>* q, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		q[i] = q[i] * (static_cast<T> (1) / std::sqrt (q[i].magSqrd ()));
+}
+
+// q[i] = q[i] / |q[i]| using reciprocal square root estimates, to float precision
+inline void renormalize (quat<float>* q, std::size_t count)
+{
+	constexpr std::size_t W = 4;
+	// from y = 1 one Newton step leaves a relative error of about 3/8 (|q|^2 - 1)^2
+	constexpr float near_unit = 1.f / 1024.f;
+	for (std::size_t first = 0; first < count; first += W)
+	{
+		std::size_t const n = count - first < W ? count - first : W;
+		alignas (16) float m2[W] = { 1.f, 1.f, 1.f, 1.f };
+		alignas (16) float s[W];
+		for (std::size_t l = 0; l < n; l++)
+			m2[l] = q[first + l].magSqrd ();
+#if defined(CML_SSE2)
+		__m128 x = _mm_load_ps (m2);
+		__m128 dist = _mm_sub_ps (x, _mm_set1_ps (1.f));
+		dist = _mm_max_ps (dist, _mm_sub_ps (_mm_setzero_ps (), dist));
+		__m128 near = _mm_cmplt_ps (dist, _mm_set1_ps (near_unit));
+		__m128 y = _mm_or_ps (_mm_and_ps (near, _mm_set1_ps (1.f)), _mm_andnot_ps (near, _mm_rsqrt_ps (x)));
+		// y = y (3 - x y^2) / 2
+		__m128 xyy = _mm_mul_ps (x, _mm_mul_ps (y, y));
+		y = _mm_mul_ps (_mm_mul_ps (_mm_set1_ps (0.5f), y), _mm_sub_ps (_mm_set1_ps (3.f), xyy));
+		_mm_store_ps (s, y);
+#else
+		for (std::size_t l = 0; l < W; l++)
+		{
+			float d = m2[l] - 1.f;
+			s[l] = (d < near_unit && -d < near_unit) ? 1.5f - 0.5f * m2[l] : 1.f / std::sqrt (m2[l]);
+		}
+#endif
+		for (std::size_t l = 0; l < n; l++)
+			q[first + l] = q[first + l] * s[l];
+	}
+}
+
+} // namespace cml
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/*
+Minimal fork join helpers for the batched kernels.
+
+Work is split into contiguous chunks of at least grain elements, one per
+hardware thread, and the calling thread takes the first chunk. Pass threads = 1
+to run inline, for example when the caller already runs inside its own job system.
+*/
+
+namespace cml
+{
+
+inline unsigned hardware_threads ()
+{
+	unsigned n = std::thread::hardware_concurrency ();
+	return n == 0 ? 1 : n;
+}
+
+// Calls f (begin, end) over disjoint chunks covering [0, count)
+template <typename F>
+void parallel_for (std::size_t count, std::size_t grain, F&& f, unsigned threads = hardware_threads ())
+{
+	if (count == 0) return;
+	grain = grain == 0 ? 1 : grain;
+	std::size_t chunks = std::min<std::size_t> (threads == 0 ? 1 : threads, (count + grain - 1) / grain);
+	if (chunks <= 1)
+	{
+		f (std::size_t (0), count);
+		return;
+	}
+
+	std::size_t per_chunk = (count + chunks - 1) / chunks;
+	std::vector<std::thread> workers;
+	workers.reserve (chunks - 1);
+	for (std::size_t begin = per_chunk; begin < count; begin += per_chunk)
+	{
+		std::size_t end = std::min (count, begin + per_chunk);
+		workers.emplace_back ([&f, begin, end] { f (begin, end); });
+	}
+	f (std::size_t (0), std::min (count, per_chunk));
+	for (auto& worker : workers)
+		worker.join ();
+}
+
+} // namespace cml
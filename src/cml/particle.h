@@ -0,0 +1,338 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "common.h"
+
+#if defined(CML_AVX)
+#include <immintrin.h>
+#elif defined(CML_SSE2)
+#include <emmintrin.h>
+#endif
+
+#include "allocator.h"
+#include "vec3.h"
+#include "vec4.h"
+
+/*
+Particle simulation kernels over structure of arrays storage.
+
+Particles are memory bound, so update does everything in one pass: gravity,
+drag, a curl flow field, aging, and dropping dead particles. Survivors are
+written back to the front of the same arrays at the write cursor, which never
+passes the read cursor. With AVX2 eight particles are updated per register and
+packed with a shuffle picked by the alive mask. Otherwise the packing is
+branchless, every particle is stored and the cursor moves by one only if it
+survived.
+
+The flow field is the curl of the potential (f (y + a z), f (z + b x), f (x + c y))
+for a periodic f whose derivative is a parabolic sine. Being a curl it has no
+divergence, so particles swirl without bunching up. It is a cheap stand in for
+curl noise, not gradient noise.
+
+write_vertices fills a vertex buffer with position, size and color, sizes and
+colors interpolated over each particle's life with lerp and clamp. With SSE2 it
+uses non temporal stores so the buffer, which only the GPU reads next, does not
+evict the particle arrays from the cache.
+*/
+
+namespace cml
+{
+
+// 32 bytes, position and size then color
+struct particle_vertex
+{
+	float x, y, z, size;
+	float r, g, b, a;
+};
+
+struct particle_params
+{
+	vec3<float> gravity = vec3<float> (0.f, -9.81f, 0.f);
+	float drag = 0.f; // velocity is divided by 1 + drag dt every step
+	float curl_strength = 0.f; // acceleration of the flow field
+	float curl_frequency = 1.f; // periods of the flow field per unit
+	vec4<float> start_color = vec4<float> (1.f, 1.f, 1.f, 1.f);
+	vec4<float> end_color = vec4<float> (1.f, 1.f, 1.f, 0.f);
+	float start_size = 1.f;
+	float end_size = 1.f;
+};
+
+class particle_system
+{
+	public:
+	std::size_t size () const { return px.size (); }
+	bool empty () const { return px.empty (); }
+
+	void reserve (std::size_t count)
+	{
+		for (auto* stream : streams ())
+			stream->reserve (count);
+	}
+
+	void clear ()
+	{
+		for (auto* stream : streams ())
+			stream->clear ();
+	}
+
+	void emit (vec3<float> const& position, vec3<float> const& velocity, float lifetime)
+	{
+		assert (lifetime > 0.f);
+		px.push_back (position.x), py.push_back (position.y), pz.push_back (position.z);
+		vx.push_back (velocity.x), vy.push_back (velocity.y), vz.push_back (velocity.z);
+		age.push_back (0.f);
+		inv_life.push_back (1.f / lifetime);
+	}
+
+	vec3<float> position (std::size_t i) const { return vec3<float> (px[i], py[i], pz[i]); }
+	vec3<float> velocity (std::size_t i) const { return vec3<float> (vx[i], vy[i], vz[i]); }
+
+	// Fraction of its life the particle has lived, in [0, 1)
+	float life_fraction (std::size_t i) const { return age[i] * inv_life[i]; }
+
+	aligned_vector<float> px, py, pz;
+	aligned_vector<float> vx, vy, vz;
+	aligned_vector<float> age, inv_life;
+
+	std::array<aligned_vector<float>*, 8> streams ()
+	{
+		return { &px, &py, &pz, &vx, &vy, &vz, &age, &inv_life };
+	}
+};
+
+namespace detail
+{
+// irrational mixing factors of the flow field potential, so its periods never line up
+constexpr float curl_a = 0.7548777f, curl_b = 0.5698403f, curl_c = 1.3247180f;
+
+// Periodic sine approximation with period 1, sin (2 pi u) to within 6 percent
+inline float curl_wave (float u)
+{
+	float t = u - std::floor (u + 0.5f);
+	return 8.f * t - 16.f * t * std::fabs (t);
+}
+
+inline vec3<float> curl_field (vec3<float> const& p)
+{
+	float const a = curl_wave (p.x + curl_c * p.y);
+	float const b = curl_wave (p.z + curl_b * p.x);
+	float const c = curl_wave (p.y + curl_a * p.z);
+	return vec3<float> (curl_c * a - b, curl_a * c - a, curl_b * b - c);
+}
+
+// Integrates particle i and stores it at w, returns whether it is still alive
+inline bool update_particle (particle_system& s,
+    particle_params const& params,
+    float dt,
+    float damp,
+    std::size_t i,
+    std::size_t w)
+{
+	float const age = s.age[i] + dt;
+	vec3<float> p = s.position (i);
+	vec3<float> v = s.velocity (i);
+	vec3<float> f = params.gravity + curl_field (p * params.curl_frequency) * params.curl_strength;
+	v = (v + f * dt) * damp;
+	p = p + v * dt;
+	s.px[w] = p.x, s.py[w] = p.y, s.pz[w] = p.z;
+	s.vx[w] = v.x, s.vy[w] = v.y, s.vz[w] = v.z;
+	s.age[w] = age;
+	s.inv_life[w] = s.inv_life[i];
+	return age * s.inv_life[i] < 1.f;
+}
+
+#if defined(CML_AVX)
+inline __m256 curl_wave (__m256 u)
+{
+	__m256 t = _mm256_sub_ps (u, _mm256_floor_ps (_mm256_add_ps (u, _mm256_set1_ps (0.5f))));
+	__m256 abs_t = _mm256_andnot_ps (_mm256_set1_ps (-0.f), t);
+	__m256 poly = _mm256_sub_ps (
+	    _mm256_set1_ps (8.f), _mm256_mul_ps (_mm256_set1_ps (16.f), abs_t));
+	return _mm256_mul_ps (t, poly);
+}
+
+#if defined(CML_AVX2)
+// Lane permutations moving the lanes set in an 8 bit mask to the front
+struct compress_table
+{
+	alignas (32) std::int32_t index[256][8];
+
+	compress_table ()
+	{
+		for (int m = 0; m < 256; m++)
+		{
+			int n = 0;
+			for (int l = 0; l < 8; l++)
+				if (m & (1 << l)) index[m][n++] = l;
+			for (; n < 8; n++)
+				index[m][n] = 0;
+		}
+	}
+};
+
+inline compress_table const& compress_lanes ()
+{
+	static compress_table const table;
+	return table;
+}
+#endif
+
+// Updates particles [i, i + 8) and packs the survivors at w, returns how many survived
+inline std::size_t update8 (particle_system& s,
+    particle_params const& params,
+    float dt,
+    float damp,
+    std::size_t i,
+    std::size_t w)
+{
+	__m256 const t = _mm256_set1_ps (dt);
+	__m256 const freq = _mm256_set1_ps (params.curl_frequency);
+	__m256 const strength = _mm256_set1_ps (params.curl_strength);
+	__m256 const ca = _mm256_set1_ps (curl_a);
+	__m256 const cb = _mm256_set1_ps (curl_b);
+	__m256 const cc = _mm256_set1_ps (curl_c);
+
+	__m256 px = _mm256_loadu_ps (&s.px[i]);
+	__m256 py = _mm256_loadu_ps (&s.py[i]);
+	__m256 pz = _mm256_loadu_ps (&s.pz[i]);
+	__m256 vx = _mm256_loadu_ps (&s.vx[i]);
+	__m256 vy = _mm256_loadu_ps (&s.vy[i]);
+	__m256 vz = _mm256_loadu_ps (&s.vz[i]);
+	__m256 const age = _mm256_add_ps (_mm256_loadu_ps (&s.age[i]), t);
+	__m256 const inv_life = _mm256_loadu_ps (&s.inv_life[i]);
+
+	__m256 const fx = _mm256_mul_ps (px, freq);
+	__m256 const fy = _mm256_mul_ps (py, freq);
+	__m256 const fz = _mm256_mul_ps (pz, freq);
+	__m256 const a = curl_wave (_mm256_add_ps (fx, _mm256_mul_ps (cc, fy)));
+	__m256 const b = curl_wave (_mm256_add_ps (fz, _mm256_mul_ps (cb, fx)));
+	__m256 const c = curl_wave (_mm256_add_ps (fy, _mm256_mul_ps (ca, fz)));
+	__m256 const cx = _mm256_sub_ps (_mm256_mul_ps (cc, a), b);
+	__m256 const cy = _mm256_sub_ps (_mm256_mul_ps (ca, c), a);
+	__m256 const cz = _mm256_sub_ps (_mm256_mul_ps (cb, b), c);
+	vec3<float> const g = params.gravity;
+	__m256 const ax = _mm256_add_ps (_mm256_set1_ps (g.x), _mm256_mul_ps (strength, cx));
+	__m256 const ay = _mm256_add_ps (_mm256_set1_ps (g.y), _mm256_mul_ps (strength, cy));
+	__m256 const az = _mm256_add_ps (_mm256_set1_ps (g.z), _mm256_mul_ps (strength, cz));
+
+	__m256 const d = _mm256_set1_ps (damp);
+	vx = _mm256_mul_ps (_mm256_add_ps (vx, _mm256_mul_ps (ax, t)), d);
+	vy = _mm256_mul_ps (_mm256_add_ps (vy, _mm256_mul_ps (ay, t)), d);
+	vz = _mm256_mul_ps (_mm256_add_ps (vz, _mm256_mul_ps (az, t)), d);
+	px = _mm256_add_ps (px, _mm256_mul_ps (vx, t));
+	py = _mm256_add_ps (py, _mm256_mul_ps (vy, t));
+	pz = _mm256_add_ps (pz, _mm256_mul_ps (vz, t));
+
+	__m256 const life = _mm256_mul_ps (age, inv_life);
+	__m256 const alive = _mm256_cmp_ps (life, _mm256_set1_ps (1.f), _CMP_LT_OQ);
+	int const mask = _mm256_movemask_ps (alive);
+	__m256 const lanes[8] = { px, py, pz, vx, vy, vz, age, inv_life };
+	auto const& streams = s.streams ();
+#if defined(CML_AVX2)
+	// the full register is stored, lanes past the survivors land on particles already read
+	std::int32_t const* index = compress_lanes ().index[mask];
+	__m256i const perm = _mm256_load_si256 (reinterpret_cast<__m256i const*> (index));
+	for (int k = 0; k < 8; k++)
+		_mm256_storeu_ps (streams[k]->data () + w, _mm256_permutevar8x32_ps (lanes[k], perm));
+#else
+	alignas (32) float out[8][8];
+	for (int k = 0; k < 8; k++)
+		_mm256_store_ps (out[k], lanes[k]);
+	std::size_t n = 0;
+	for (int l = 0; l < 8; l++)
+	{
+		for (int k = 0; k < 8; k++)
+			(*streams[k])[w + n] = out[k][l];
+		n += (mask >> l) & 1;
+	}
+#endif
+	unsigned bits = static_cast<unsigned> (mask);
+	bits = bits - ((bits >> 1) & 0x55u);
+	bits = (bits & 0x33u) + ((bits >> 2) & 0x33u);
+	return (bits + (bits >> 4)) & 0x0fu;
+}
+#endif
+} // namespace detail
+
+// Advances every particle by dt and removes the ones past their lifetime. The order of the
+// survivors is kept.
+inline void update (particle_system& s, particle_params const& params, float dt)
+{
+	float const damp = 1.f / (1.f + params.drag * dt);
+	std::size_t const count = s.size ();
+	std::size_t i = 0, w = 0;
+#if defined(CML_AVX)
+	for (; i + 8 <= count; i += 8)
+		w += detail::update8 (s, params, dt, damp, i, w);
+#endif
+	for (; i < count; i++)
+		w += detail::update_particle (s, params, dt, damp, i, w) ? 1 : 0;
+	for (auto* stream : s.streams ())
+		stream->resize (w);
+}
+
+// Writes a vertex per particle to out, which must be 16 byte aligned and hold s.size ()
+// vertices, returns the number written
+inline std::size_t write_vertices (
+    particle_system const& s, particle_params const& params, particle_vertex* out)
+{
+	assert (reinterpret_cast<std::uintptr_t> (out) % 16 == 0);
+	std::size_t const count = s.size ();
+	std::size_t i = 0;
+#if defined(CML_SSE2)
+	__m128 const one = _mm_set1_ps (1.f);
+	__m128 const c0[4] = { _mm_set1_ps (params.start_color.x), _mm_set1_ps (params.start_color.y),
+		_mm_set1_ps (params.start_color.z), _mm_set1_ps (params.start_color.w) };
+	vec4<float> const color_step = params.end_color - params.start_color;
+	__m128 const dc[4] = { _mm_set1_ps (color_step.x), _mm_set1_ps (color_step.y),
+		_mm_set1_ps (color_step.z), _mm_set1_ps (color_step.w) };
+	__m128 const s0 = _mm_set1_ps (params.start_size);
+	__m128 const ds = _mm_set1_ps (params.end_size - params.start_size);
+	float* dst = &out[0].x;
+	for (; i + 4 <= count; i += 4, dst += 32)
+	{
+		__m128 t = _mm_mul_ps (_mm_loadu_ps (&s.age[i]), _mm_loadu_ps (&s.inv_life[i]));
+		t = _mm_min_ps (_mm_max_ps (t, _mm_setzero_ps ()), one);
+		__m128 x = _mm_loadu_ps (&s.px[i]);
+		__m128 y = _mm_loadu_ps (&s.py[i]);
+		__m128 z = _mm_loadu_ps (&s.pz[i]);
+		__m128 size = _mm_add_ps (s0, _mm_mul_ps (ds, t));
+		__m128 r = _mm_add_ps (c0[0], _mm_mul_ps (dc[0], t));
+		__m128 g = _mm_add_ps (c0[1], _mm_mul_ps (dc[1], t));
+		__m128 b = _mm_add_ps (c0[2], _mm_mul_ps (dc[2], t));
+		__m128 a = _mm_add_ps (c0[3], _mm_mul_ps (dc[3], t));
+		r = _mm_min_ps (_mm_max_ps (r, _mm_setzero_ps ()), one);
+		g = _mm_min_ps (_mm_max_ps (g, _mm_setzero_ps ()), one);
+		b = _mm_min_ps (_mm_max_ps (b, _mm_setzero_ps ()), one);
+		a = _mm_min_ps (_mm_max_ps (a, _mm_setzero_ps ()), one);
+		_MM_TRANSPOSE4_PS (x, y, z, size);
+		_MM_TRANSPOSE4_PS (r, g, b, a);
+		_mm_stream_ps (dst, x);
+		_mm_stream_ps (dst + 4, r);
+		_mm_stream_ps (dst + 8, y);
+		_mm_stream_ps (dst + 12, g);
+		_mm_stream_ps (dst + 16, z);
+		_mm_stream_ps (dst + 20, b);
+		_mm_stream_ps (dst + 24, size);
+		_mm_stream_ps (dst + 28, a);
+	}
+	_mm_sfence ();
+#endif
+	for (; i < count; i++)
+	{
+		float const t = min (max (s.life_fraction (i), 0.f), 1.f);
+		vec4<float> const c = lerp (params.start_color, params.end_color, t);
+		vec4<float> const color = clamp (vec4<float> (0.f), vec4<float> (1.f), c);
+		float const size = params.start_size + (params.end_size - params.start_size) * t;
+		out[i] = particle_vertex{ s.px[i], s.py[i], s.pz[i], size, color.x, color.y, color.z,
+			color.w };
+	}
+	return count;
+}
+
+} // namespace cml
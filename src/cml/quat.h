@@ -7,7 +7,7 @@ return euler angle representation (vec3)
 
 look rotation - Creates a rotation with the specified forward and upwards directions.
 #euler - Returns a rotation that rotates z degrees around the z axis, x degrees around the x axis,
-and y degrees around the y axis (in that order). slerp - Spherically interpolates between a and b by
+and y degrees around the y axis (in that order). #slerp - Spherically interpolates between a and b by
 t. The parameter t is clamped to the range [0, 1]. fromToRotation - Creates a rotation which rotates
 from fromDirection to toDirection. #identity - static var #other constant ones
 
@@ -95,14 +95,14 @@ template <typename T = float> class alignas (4 * alignof (T)) quat
 	}
 
 	// Scalar Multiplication
-	quat<T> operator* (const T val) const { return quat<T> (imag * val.imag, real * val.real); }
+	quat<T> operator* (const T val) const { return quat<T> (imag * val, real * val); }
 
 	// Quaternion multiplication
 	quat<T> operator* (const quat<T> val) const
 	{
 
 		return quat<T> (
-		    real * val.imag.x - imag.x * val.real + imag.y * val.imag.z - imag.z * val.imag.y,
+		    real * val.imag.x + imag.x * val.real + imag.y * val.imag.z - imag.z * val.imag.y,
 		    real * val.imag.y - imag.x * val.imag.z + imag.y * val.real + imag.z * val.imag.x,
 		    real * val.imag.z + imag.x * val.imag.y - imag.y * val.imag.x + imag.z * val.real,
 		    real * val.real - imag.x * val.imag.x - imag.y * val.imag.y - imag.z * val.imag.z);
@@ -120,7 +120,7 @@ template <typename T = float> class alignas (4 * alignof (T)) quat
 	quat<T> operator~ () const { return quat<T> (-imag, real); }
 
 	// MAGNITUDE
-	T mag () const { return (T)std::sqrt (imag.mag_sqrt () + real * real); }
+	T mag () const { return sqrt (imag.mag_sqrt () + real * real); }
 
 	T magSqrd (void) const { return (imag.mag_sqrt () + real * real); }
 
@@ -163,9 +163,9 @@ template <typename T = float> class alignas (4 * alignof (T)) quat
 	// axisangles - Creates a rotation which rotates angle degrees around axis.
 	static quat<T> axisAngles (vec3<T> axis, T degrees)
 	{
-		double angleRad = radians (degrees);
-		double sin_anlge_div2 = std::sin (angleRad / 2);
-		double cos_anlge_div2 = std::cos (angleRad / 2);
+		T angleRad = radians (degrees);
+		T sin_anlge_div2 = sin (angleRad / 2);
+		T cos_anlge_div2 = cos (angleRad / 2);
 		return quat<T> (axis * sin_anlge_div2, cos_anlge_div2);
 	}
 
@@ -189,17 +189,50 @@ template <typename T = float> class alignas (4 * alignof (T)) quat
 		return vec3<T> (x.x * tmp2, x.y * tmp2, x.z * tmp2);
 	}
 
-	// Lerp TODO
-	// quat<T> lerp(T factor, const quat<T>& val) const
-	//{
-	//	return quat<T>((*this).getImag().lerp(factor,val), (1 - factor) * w + factor * val.w);
-	//}
-
 	static const quat<T> identity;
 };
 
 template <typename T> const quat<T> quat<T>::identity = { 0, 0, 0, 1 };
 
+// INTERPOLATION
+
+template <typename T> T dot (quat<T> const& a, quat<T> const& b)
+{
+	return dot (a.getImag (), b.getImag ()) + a.getReal () * b.getReal ();
+}
+
+// Normalized linear interpolation along the shorter arc. Not constant speed, but cheap and
+// close to slerp for the small angles between neighbouring keys.
+template <typename T> quat<T> nlerp (quat<T> const& a, quat<T> const& b, T const fact)
+{
+	T sign = dot (a, b) < 0 ? static_cast<T> (-1) : static_cast<T> (1);
+	quat<T> q (lerp (a.getImag (), b.getImag () * sign, fact),
+	    (1 - fact) * a.getReal () + fact * sign * b.getReal ());
+	q.norm ();
+	return q;
+}
+
+// Spherical linear interpolation along the shorter arc, fact is clamped to [0, 1]
+template <typename T> quat<T> slerp (quat<T> const& a, quat<T> const& b, T fact)
+{
+	fact = fact < 0 ? static_cast<T> (0) : (fact > 1 ? static_cast<T> (1) : fact);
+	T cos_theta = dot (a, b);
+	T sign = static_cast<T> (1);
+	if (cos_theta < 0)
+	{
+		cos_theta = -cos_theta;
+		sign = static_cast<T> (-1);
+	}
+	// nearly parallel, the sine below loses precision
+	if (cos_theta > static_cast<T> (0.9995)) return nlerp (a, b, fact);
+
+	T theta = acos (cos_theta);
+	T inv_sin = static_cast<T> (1) / sin (theta);
+	T wa = sin ((1 - fact) * theta) * inv_sin;
+	T wb = sin (fact * theta) * inv_sin * sign;
+	return quat<T> (a.getImag () * wa + b.getImag () * wb, a.getReal () * wa + b.getReal () * wb);
+}
+
 using quatf = quat<float>;
 using quatd = quat<double>;
 
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "aabb.h"
+#include "allocator.h"
+#include "vec3.h"
+
+/*
+Rays and ray intersection kernels.
+
+The scalar tests work on ray<T> directly. The packet tests trace W rays at once
+(4 or 8, the SSE and AVX widths) against one box or a batch of triangles stored as
+structure of arrays. Each lane is written as plain straight line float code over
+fixed size arrays, so the compiler maps a packet onto one SIMD register per
+component. Results come back as a bit mask of lanes that hit, plus per lane
+distances.
+*/
+
+namespace cml
+{
+
+template <typename T = float> class ray
+{
+	public:
+	vec3<T> origin;
+	vec3<T> direction;
+
+	constexpr ray () noexcept {}
+
+	constexpr ray (vec3<T> const& origin, vec3<T> const& direction) noexcept
+	: origin (origin), direction (direction)
+	{
+	}
+
+	constexpr vec3<T> at (T const t) const { return origin + direction * t; }
+
+	vec3<T> inv_direction () const { return static_cast<T> (1) / direction; }
+};
+
+using rayf = ray<float>;
+using rayd = ray<double>;
+
+// SCALAR TESTS
+
+// Slab test, t_near is where the ray enters the box (negative if it starts inside)
+template <typename T> bool intersect (ray<T> const& r, aabb<T> const& box, T const t_max, T& t_near)
+{
+	vec3<T> inv = r.inv_direction ();
+	vec3<T> t1 = (box.min - r.origin) * inv;
+	vec3<T> t2 = (box.max - r.origin) * inv;
+	vec3<T> lo = min (t1, t2);
+	vec3<T> hi = max (t1, t2);
+	t_near = max (max (lo.x, lo.y), lo.z);
+	T t_far = min (min (hi.x, hi.y), hi.z);
+	return t_near <= t_far && t_far >= 0 && t_near < t_max;
+}
+
+namespace detail
+{
+// Below this the ray runs parallel to the triangle plane, the scalar and packet tests share it so
+// both reject the same grazing rays
+template <typename T> constexpr T parallel_det = std::numeric_limits<T>::epsilon ();
+} // namespace detail
+
+// Moller-Trumbore, u and v are the barycentric coordinates of the hit along v1 - v0 and v2 - v0
+template <typename T>
+bool intersect (ray<T> const& r,
+    vec3<T> const& v0,
+    vec3<T> const& v1,
+    vec3<T> const& v2,
+    T const t_max,
+    T& t,
+    T& u,
+    T& v)
+{
+	vec3<T> e1 = v1 - v0;
+	vec3<T> e2 = v2 - v0;
+	vec3<T> p = cross (r.direction, e2);
+	T det = dot (e1, p);
+	if (det > -detail::parallel_det<T> && det < detail::parallel_det<T>) return false;
+	T inv_det = static_cast<T> (1) / det;
+	vec3<T> s = r.origin - v0;
+	u = dot (s, p) * inv_det;
+	if (u < 0 || u > 1) return false;
+	vec3<T> q = cross (s, e1);
+	v = dot (r.direction, q) * inv_det;
+	if (v < 0 || u + v > 1) return false;
+	t = dot (e2, q) * inv_det;
+	return t > 0 && t < t_max;
+}
+
+// TRIANGLE BATCH
+
+// Triangles as structure of arrays, one vertex and two edges each
+class triangle_soa
+{
+	public:
+	void add (vec3<float> const& v0, vec3<float> const& v1, vec3<float> const& v2)
+	{
+		vec3<float> e1 = v1 - v0;
+		vec3<float> e2 = v2 - v0;
+		v0x.push_back (v0.x), v0y.push_back (v0.y), v0z.push_back (v0.z);
+		e1x.push_back (e1.x), e1y.push_back (e1.y), e1z.push_back (e1.z);
+		e2x.push_back (e2.x), e2y.push_back (e2.y), e2z.push_back (e2.z);
+	}
+
+	void reserve (std::size_t count)
+	{
+		for (auto* stream : streams ())
+			stream->reserve (count);
+	}
+
+	void clear ()
+	{
+		for (auto* stream : streams ())
+			stream->clear ();
+	}
+
+	std::size_t size () const { return v0x.size (); }
+
+	vec3<float> vertex (std::size_t i, int corner) const
+	{
+		vec3<float> v0 (v0x[i], v0y[i], v0z[i]);
+		if (corner == 1) return v0 + vec3<float> (e1x[i], e1y[i], e1z[i]);
+		if (corner == 2) return v0 + vec3<float> (e2x[i], e2y[i], e2z[i]);
+		return v0;
+	}
+
+	aligned_vector<float> v0x, v0y, v0z;
+	aligned_vector<float> e1x, e1y, e1z;
+	aligned_vector<float> e2x, e2y, e2z;
+
+	private:
+	std::array<aligned_vector<float>*, 9> streams ()
+	{
+		return { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z };
+	}
+};
+
+struct ray_hit
+{
+	float t = std::numeric_limits<float>::max ();
+	float u = 0;
+	float v = 0;
+	int prim = -1; // index of the triangle hit, -1 for a miss
+};
+
+// PACKETS
+
+constexpr int packet_width = 8;
+
+template <int W = packet_width> struct alignas (W * sizeof (float)) ray_packet
+{
+	static_assert (W == 4 || W == 8 || W == 16, "packets are 4, 8 or 16 rays wide");
+
+	float ox[W], oy[W], oz[W];
+	float dx[W], dy[W], dz[W];
+	float ix[W], iy[W], iz[W]; // inverse direction
+	float t_max[W];
+
+	// Lanes which are not set never hit anything
+	ray_packet ()
+	{
+		for (int l = 0; l < W; l++)
+		{
+			ox[l] = oy[l] = oz[l] = 0;
+			dx[l] = dy[l] = dz[l] = 1;
+			ix[l] = iy[l] = iz[l] = 1;
+			t_max[l] = 0;
+		}
+	}
+
+	void set (int lane, ray<float> const& r, float max_distance)
+	{
+		assert (lane >= 0 && lane < W);
+		ox[lane] = r.origin.x, oy[lane] = r.origin.y, oz[lane] = r.origin.z;
+		dx[lane] = r.direction.x, dy[lane] = r.direction.y, dz[lane] = r.direction.z;
+		ix[lane] = 1.f / r.direction.x, iy[lane] = 1.f / r.direction.y, iz[lane] = 1.f / r.direction.z;
+		t_max[lane] = max_distance;
+	}
+};
+
+template <int W = packet_width> struct alignas (W * sizeof (float)) packet_hit
+{
+	float t[W], u[W], v[W];
+	int prim[W];
+
+	packet_hit ()
+	{
+		for (int l = 0; l < W; l++)
+		{
+			t[l] = std::numeric_limits<float>::max ();
+			u[l] = v[l] = 0;
+			prim[l] = -1;
+		}
+	}
+
+	ray_hit get (int lane) const { return ray_hit{ t[lane], u[lane], v[lane], prim[lane] }; }
+};
+
+// Slab test of every ray in the packet against one box
+template <int W> std::uint32_t intersect (ray_packet<W> const& p, aabb<float> const& box, float (&t_near)[W])
+{
+	std::int32_t hit[W];
+	for (int l = 0; l < W; l++)
+	{
+		float tx1 = (box.min.x - p.ox[l]) * p.ix[l], tx2 = (box.max.x - p.ox[l]) * p.ix[l];
+		float ty1 = (box.min.y - p.oy[l]) * p.iy[l], ty2 = (box.max.y - p.oy[l]) * p.iy[l];
+		float tz1 = (box.min.z - p.oz[l]) * p.iz[l], tz2 = (box.max.z - p.oz[l]) * p.iz[l];
+		float lo = max (max (min (tx1, tx2), min (ty1, ty2)), min (tz1, tz2));
+		float hi = min (min (max (tx1, tx2), max (ty1, ty2)), max (tz1, tz2));
+		t_near[l] = lo;
+		hit[l] = (lo <= hi) & (hi >= 0.f) & (lo < p.t_max[l]);
+	}
+	std::uint32_t mask = 0;
+	for (int l = 0; l < W; l++)
+		mask |= static_cast<std::uint32_t> (hit[l] != 0) << l;
+	return mask;
+}
+
+namespace detail
+{
+// Moller-Trumbore for one triangle against all lanes, keeps the nearest hit per lane
+template <int W>
+std::uint32_t intersect_triangle (ray_packet<W> const& p, triangle_soa const& tris, std::size_t i, packet_hit<W>& hit)
+{
+	float const v0x = tris.v0x[i], v0y = tris.v0y[i], v0z = tris.v0z[i];
+	float const e1x = tris.e1x[i], e1y = tris.e1y[i], e1z = tris.e1z[i];
+	float const e2x = tris.e2x[i], e2y = tris.e2y[i], e2z = tris.e2z[i];
+
+	std::int32_t lane_hit[W];
+	for (int l = 0; l < W; l++)
+	{
+		float px = p.dy[l] * e2z - p.dz[l] * e2y;
+		float py = p.dz[l] * e2x - p.dx[l] * e2z;
+		float pz = p.dx[l] * e2y - p.dy[l] * e2x;
+		float det = e1x * px + e1y * py + e1z * pz;
+		float inv_det = 1.f / det;
+		float sx = p.ox[l] - v0x, sy = p.oy[l] - v0y, sz = p.oz[l] - v0z;
+		float u = (sx * px + sy * py + sz * pz) * inv_det;
+		float qx = sy * e1z - sz * e1y;
+		float qy = sz * e1x - sx * e1z;
+		float qz = sx * e1y - sy * e1x;
+		float v = (p.dx[l] * qx + p.dy[l] * qy + p.dz[l] * qz) * inv_det;
+		float t = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+
+		// non short circuit operators keep the lane code branch free
+		float t_best = hit.t[l];
+		bool h = ((det >= parallel_det<float>) | (det <= -parallel_det<float>)) & (u >= 0.f) & (v >= 0.f) &
+		         (u + v <= 1.f) & (t > 0.f) & (t < p.t_max[l]) & (t < t_best);
+		hit.t[l] = h ? t : t_best;
+		hit.u[l] = h ? u : hit.u[l];
+		hit.v[l] = h ? v : hit.v[l];
+		hit.prim[l] = h ? static_cast<int> (i) : hit.prim[l];
+		lane_hit[l] = h;
+	}
+	std::uint32_t mask = 0;
+	for (int l = 0; l < W; l++)
+		mask |= static_cast<std::uint32_t> (lane_hit[l] != 0) << l;
+	return mask;
+}
+} // namespace detail
+
+// Nearest hit of every ray in the packet over a range of triangles, returns the lanes that hit
+template <int W>
+std::uint32_t intersect (ray_packet<W> const& p,
+    triangle_soa const& tris,
+    packet_hit<W>& hit,
+    std::size_t first = 0,
+    std::size_t count = std::numeric_limits<std::size_t>::max ())
+{
+	assert (first <= tris.size ());
+	first = first < tris.size () ? first : tris.size ();
+	std::size_t last = count > tris.size () - first ? tris.size () : first + count;
+	std::uint32_t mask = 0;
+	for (std::size_t i = first; i < last; i++)
+		mask |= detail::intersect_triangle (p, tris, i, hit);
+	return mask;
+}
+
+// Any hit test, stops as soon as every active lane is blocked. Returns the blocked lanes.
+template <int W> std::uint32_t occluded (ray_packet<W> const& p, triangle_soa const& tris)
+{
+	std::uint32_t active = 0;
+	for (int l = 0; l < W; l++)
+		active |= static_cast<std::uint32_t> (p.t_max[l] > 0.f) << l;
+
+	packet_hit<W> hit;
+	std::uint32_t blocked = 0;
+	for (std::size_t i = 0; i < tris.size () && blocked != active; i++)
+		blocked |= detail::intersect_triangle (p, tris, i, hit);
+	return blocked & active;
+}
+
+// Nearest hit for each of many rays, traced as packets of packet_width
+inline void intersect (ray<float> const* rays, std::size_t count, float t_max, triangle_soa const& tris, ray_hit* out)
+{
+	for (std::size_t first = 0; first < count; first += packet_width)
+	{
+		std::size_t lanes = count - first < packet_width ? count - first : packet_width;
+		ray_packet<packet_width> p;
+		for (std::size_t l = 0; l < lanes; l++)
+			p.set (static_cast<int> (l), rays[first + l], t_max);
+
+		packet_hit<packet_width> hit;
+		intersect (p, tris, hit);
+		for (std::size_t l = 0; l < lanes; l++)
+			out[first + l] = hit.get (static_cast<int> (l));
+	}
+}
+
+} // namespace cml
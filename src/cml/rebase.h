@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include "common.h"
+
+#if defined(CML_SSE2)
+#include <emmintrin.h>
+#endif
+
+#include "mat4.h"
+#include "quat.h"
+#include "transform.h"
+#include "vec3.h"
+
+/*
+Camera relative rendering for worlds larger than float precision allows.
+
+World positions are kept as vec3<double>. Every frame they are rebased against a
+double precision origin (usually the camera position) and only the small
+difference is converted to float, so the float data sent to the GPU keeps full
+precision near the camera.
+
+Model matrices are built straight from double translation, float rotation and
+float scale without an intermediate mat4<double>.
+*/
+
+namespace cml
+{
+
+// Snaps a position to a grid, so the origin only moves in steps of cell_size.
+// Keeps rebased values stable while the camera moves inside a cell.
+inline vec3<double> snap_origin (vec3<double> const& position, double cell_size)
+{
+	return vec3<double> (std::floor (position.x / cell_size) * cell_size,
+	    std::floor (position.y / cell_size) * cell_size,
+	    std::floor (position.z / cell_size) * cell_size);
+}
+
+inline vec3<float> rebase (vec3<double> const& position, vec3<double> const& origin)
+{
+	return vec3<float> (static_cast<float> (position.x - origin.x),
+	    static_cast<float> (position.y - origin.y),
+	    static_cast<float> (position.z - origin.z));
+}
+
+// out[i] = in[i] - origin, converted to float
+inline void rebase (vec3<double> const* in, vec3<float>* out, std::size_t count, vec3<double> const& origin)
+{
+#if defined(CML_SSE2)
+	// vec3<double> is 32 byte aligned and vec3<float> 16 byte aligned, so both
+	// can be moved with aligned loads and stores. The fourth float lane is padding.
+	__m128d const origin_xy = _mm_set_pd (origin.y, origin.x);
+	__m128d const origin_z = _mm_set_sd (origin.z);
+	for (std::size_t i = 0; i < count; i++)
+	{
+		__m128d xy = _mm_sub_pd (_mm_load_pd (&in[i].x), origin_xy);
+		__m128d z = _mm_sub_sd (_mm_load_sd (&in[i].z), origin_z);
+		__m128 xyz = _mm_movelh_ps (_mm_cvtpd_ps (xy), _mm_cvtpd_ps (z));
+		_mm_store_ps (&out[i].x, xyz);
+	}
+#else
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = rebase (in[i], origin);
+#endif
+}
+
+// Model matrix relative to origin, from world space translation, rotation and scale
+inline mat4<float> camera_relative_model (vec3<double> const& translation,
+    quat<float> const& rotation,
+    vec3<float> const& scale,
+    vec3<double> const& origin)
+{
+	vec3<float> const relative (static_cast<float> (translation.x - origin.x),
+	    static_cast<float> (translation.y - origin.y),
+	    static_cast<float> (translation.z - origin.z));
+	return compose_trs (relative, rotation, scale);
+}
+
+// out[i] = camera_relative_model (translations[i], rotations[i], scales[i], origin)
+inline void camera_relative_models (vec3<double> const* translations,
+    quat<float> const* rotations,
+    vec3<float> const* scales,
+    mat4<float>* out,
+    std::size_t count,
+    vec3<double> const& origin)
+{
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = camera_relative_model (translations[i], rotations[i], scales[i], origin);
+}
+
+} // namespace cml
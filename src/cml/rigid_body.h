@@ -0,0 +1,371 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "allocator.h"
+#include "common.h"
+#include "mat3.h"
+#include "parallel.h"
+#include "quat.h"
+#include "transform.h"
+#include "vec3.h"
+
+#if defined(CML_SSE2)
+#include <emmintrin.h>
+#endif
+
+/*
+Rigid body state and time integration for many bodies at once.
+
+Positions, velocities, orientations, angular velocities and the force and
+torque accumulators live in one array per component. With SSE2 a step handles
+four bodies per register in a single pass, from applying the torque to the new
+world inertia tensors, so each body is loaded and stored once per step. The
+tensors are kept as one mat3 per body, the torque goes through the mat3
+product and the new tensors R diag (1 / I) R^T are written from the six
+distinct terms.
+
+Orientations are advanced with dq = (w, 0) q / 2 for the world angular velocity
+w and renormalized in the same pass. A step changes |q|^2 by about (w dt / 2)^2,
+so two Newton steps for 1 / sqrt starting from 1 are exact to float precision
+while a body turns less than about a quarter radian per step. Faster bodies
+take a square root instead.
+
+The gyroscopic term w x I w is not integrated.
+*/
+
+namespace cml
+{
+
+// Bodies in structure of arrays layout. A body with zero mass is static, it ignores
+// forces and gravity but keeps moving with the velocity it was given.
+class rigid_bodies
+{
+	public:
+	std::size_t size () const { return px.size (); }
+
+	void reserve (std::size_t count)
+	{
+		for (auto* stream : streams ())
+			stream->reserve (count);
+		inv_inertia.reserve (count);
+	}
+
+	void clear ()
+	{
+		for (auto* stream : streams ())
+			stream->clear ();
+		inv_inertia.clear ();
+	}
+
+	// inertia holds the principal moments of the body in its local frame, returns the index
+	// of the new body
+	std::size_t add (vec3<float> const& position,
+	    quat<float> const& orientation,
+	    float mass,
+	    vec3<float> const& inertia,
+	    vec3<float> const& velocity = vec3<float> (0.f),
+	    vec3<float> const& angular_velocity = vec3<float> (0.f))
+	{
+		assert (mass >= 0.f);
+		vec3<float> const im = orientation.getImag ();
+		px.push_back (position.x), py.push_back (position.y), pz.push_back (position.z);
+		vx.push_back (velocity.x), vy.push_back (velocity.y), vz.push_back (velocity.z);
+		qx.push_back (im.x), qy.push_back (im.y), qz.push_back (im.z), qw.push_back (orientation.getReal ());
+		wx.push_back (angular_velocity.x), wy.push_back (angular_velocity.y), wz.push_back (angular_velocity.z);
+		fx.push_back (0.f), fy.push_back (0.f), fz.push_back (0.f);
+		tx.push_back (0.f), ty.push_back (0.f), tz.push_back (0.f);
+		inv_mass.push_back (mass > 0.f ? 1.f / mass : 0.f);
+		ix.push_back (mass > 0.f && inertia.x > 0.f ? 1.f / inertia.x : 0.f);
+		iy.push_back (mass > 0.f && inertia.y > 0.f ? 1.f / inertia.y : 0.f);
+		iz.push_back (mass > 0.f && inertia.z > 0.f ? 1.f / inertia.z : 0.f);
+		inv_inertia.emplace_back ();
+		update_inertia (size () - 1);
+		return size () - 1;
+	}
+
+	vec3<float> position (std::size_t i) const { return vec3<float> (px[i], py[i], pz[i]); }
+	vec3<float> velocity (std::size_t i) const { return vec3<float> (vx[i], vy[i], vz[i]); }
+	vec3<float> angular_velocity (std::size_t i) const { return vec3<float> (wx[i], wy[i], wz[i]); }
+	quat<float> orientation (std::size_t i) const { return quat<float> (qx[i], qy[i], qz[i], qw[i]); }
+
+	void set_velocity (std::size_t i, vec3<float> const& v, vec3<float> const& w)
+	{
+		vx[i] = v.x, vy[i] = v.y, vz[i] = v.z;
+		wx[i] = w.x, wy[i] = w.y, wz[i] = w.z;
+	}
+
+	// Forces and torques add up until the next integration step, which clears them
+	void add_force (std::size_t i, vec3<float> const& f) { fx[i] += f.x, fy[i] += f.y, fz[i] += f.z; }
+	void add_torque (std::size_t i, vec3<float> const& t) { tx[i] += t.x, ty[i] += t.y, tz[i] += t.z; }
+
+	// Force applied at a world space point, which also adds a torque around the body origin
+	void add_force_at (std::size_t i, vec3<float> const& f, vec3<float> const& point)
+	{
+		add_force (i, f);
+		add_torque (i, cross (point - position (i), f));
+	}
+
+	// inv_inertia[i] = R diag (1 / inertia) R^T for the current orientation R
+	void update_inertia (std::size_t i)
+	{
+		mat3<float> r = rotation_matrix (orientation (i));
+		mat3<float> scaled = r;
+		float const d[3] = { ix[i], iy[i], iz[i] };
+		for (int c = 0; c < 3; c++)
+			for (int k = 0; k < 3; k++)
+				scaled.data[3 * c + k] *= d[c];
+		inv_inertia[i] = scaled * r.transpose ();
+	}
+
+	aligned_vector<float> px, py, pz;
+	aligned_vector<float> vx, vy, vz;
+	aligned_vector<float> qx, qy, qz, qw;
+	aligned_vector<float> wx, wy, wz; // world space angular velocity
+	aligned_vector<float> fx, fy, fz;
+	aligned_vector<float> tx, ty, tz;
+	aligned_vector<float> inv_mass;
+	aligned_vector<float> ix, iy, iz; // inverse principal moments of inertia
+	std::vector<mat3<float>> inv_inertia; // world space inverse inertia tensor
+
+	private:
+	std::array<aligned_vector<float>*, 23> streams ()
+	{
+		return { &px, &py, &pz, &vx, &vy, &vz, &qx, &qy, &qz, &qw, &wx, &wy, &wz, &fx, &fy, &fz, &tx, &ty,
+			&tz, &inv_mass, &ix, &iy, &iz };
+	}
+};
+
+enum class integrator
+{
+	semi_implicit_euler, // velocities first, then positions and orientations with the new velocities
+	rk2 // midpoint rule, exact for constant accelerations
+};
+
+namespace detail
+{
+// after two Newton steps for 1 / sqrt (m) from 1 the relative error is about
+// 27 / 128 (m - 1)^4, below float precision for |m - 1| < 1 / 64
+constexpr float near_unit = 1.f / 64.f;
+
+// One step of body i
+inline void integrate (
+    rigid_bodies& b, float dt, vec3<float> const& gravity, integrator method, std::size_t i)
+{
+	vec3<float> const dw = b.inv_inertia[i] * vec3<float> (b.tx[i], b.ty[i], b.tz[i]) * dt;
+	float const im = b.inv_mass[i];
+	vec3<float> const a = gravity * (im > 0.f ? 1.f : 0.f) + vec3<float> (b.fx[i], b.fy[i], b.fz[i]) * im;
+	vec3<float> const v (b.vx[i], b.vy[i], b.vz[i]);
+	// semi implicit Euler moves with v + a dt, the midpoint rule with v + a dt / 2
+	float const half = method == integrator::rk2 ? 0.5f * dt : dt;
+	vec3<float> const p = vec3<float> (b.px[i], b.py[i], b.pz[i]) + (v + a * half) * dt;
+	vec3<float> const v1 = v + a * dt;
+	b.px[i] = p.x, b.py[i] = p.y, b.pz[i] = p.z;
+	b.vx[i] = v1.x, b.vy[i] = v1.y, b.vz[i] = v1.z;
+
+	// q' = q + s (w, 0) q
+	auto advance = [] (float const* q, float wx, float wy, float wz, float s, float* o) {
+		float const x = q[0], y = q[1], z = q[2], w = q[3];
+		o[0] = x + s * (w * wx + wy * z - wz * y);
+		o[1] = y + s * (w * wy + wz * x - wx * z);
+		o[2] = z + s * (w * wz + wx * y - wy * x);
+		o[3] = w - s * (wx * x + wy * y + wz * z);
+	};
+	float const q[4] = { b.qx[i], b.qy[i], b.qz[i], b.qw[i] };
+	float wx = b.wx[i], wy = b.wy[i], wz = b.wz[i];
+	float o[4];
+	if (method == integrator::rk2)
+	{
+		// q (t + dt / 2) from w (t), then q (t + dt) from the slope there with w (t + dt / 2)
+		float m[4];
+		advance (q, wx, wy, wz, 0.25f * dt, m);
+		float const mx = wx + 0.5f * dw.x, my = wy + 0.5f * dw.y, mz = wz + 0.5f * dw.z;
+		float const s = 0.5f * dt;
+		o[0] = q[0] + s * (m[3] * mx + my * m[2] - mz * m[1]);
+		o[1] = q[1] + s * (m[3] * my + mz * m[0] - mx * m[2]);
+		o[2] = q[2] + s * (m[3] * mz + mx * m[1] - my * m[0]);
+		o[3] = q[3] - s * (mx * m[0] + my * m[1] + mz * m[2]);
+		wx += dw.x, wy += dw.y, wz += dw.z;
+	}
+	else
+	{
+		wx += dw.x, wy += dw.y, wz += dw.z;
+		advance (q, wx, wy, wz, 0.5f * dt, o);
+	}
+	float const m2 = o[0] * o[0] + o[1] * o[1] + o[2] * o[2] + o[3] * o[3];
+	float const d = m2 - 1.f;
+	float r = 1.5f - 0.5f * m2;
+	r = r * (1.5f - 0.5f * m2 * r * r);
+	if (!(d < near_unit && -d < near_unit)) r = 1.f / std::sqrt (m2);
+	b.qx[i] = o[0] * r, b.qy[i] = o[1] * r, b.qz[i] = o[2] * r, b.qw[i] = o[3] * r;
+	b.wx[i] = wx, b.wy[i] = wy, b.wz[i] = wz;
+
+	b.fx[i] = b.fy[i] = b.fz[i] = 0.f;
+	b.tx[i] = b.ty[i] = b.tz[i] = 0.f;
+	b.update_inertia (i);
+}
+
+#if defined(CML_SSE2)
+// One step of bodies i to i + 3, the same math as above with a body per lane
+inline void integrate4 (
+    rigid_bodies& b, float dt, vec3<float> const& gravity, integrator method, std::size_t i)
+{
+	// torque becomes the angular velocity change, the only step which needs the tensors
+	alignas (16) float dwx[4], dwy[4], dwz[4];
+	for (std::size_t l = 0; l < 4; l++)
+	{
+		vec3<float> const dw = b.inv_inertia[i + l] * vec3<float> (b.tx[i + l], b.ty[i + l], b.tz[i + l]);
+		dwx[l] = dw.x, dwy[l] = dw.y, dwz[l] = dw.z;
+	}
+	__m128 const t = _mm_set1_ps (dt);
+	__m128 const zero = _mm_setzero_ps ();
+
+	// linear motion, static bodies ignore gravity
+	__m128 const im = _mm_loadu_ps (&b.inv_mass[i]);
+	__m128 const dynamic = _mm_cmpgt_ps (im, zero);
+	__m128 const half = _mm_set1_ps (method == integrator::rk2 ? 0.5f * dt : dt);
+	float const g[3] = { gravity.x, gravity.y, gravity.z };
+	aligned_vector<float>* pos[3] = { &b.px, &b.py, &b.pz };
+	aligned_vector<float>* vel[3] = { &b.vx, &b.vy, &b.vz };
+	aligned_vector<float>* force[3] = { &b.fx, &b.fy, &b.fz };
+	for (int c = 0; c < 3; c++)
+	{
+		float* f = force[c]->data () + i;
+		float* v = vel[c]->data () + i;
+		float* p = pos[c]->data () + i;
+		__m128 a = _mm_add_ps (_mm_and_ps (dynamic, _mm_set1_ps (g[c])), _mm_mul_ps (_mm_loadu_ps (f), im));
+		__m128 vc = _mm_loadu_ps (v);
+		__m128 const step = _mm_mul_ps (_mm_add_ps (vc, _mm_mul_ps (a, half)), t);
+		_mm_storeu_ps (p, _mm_add_ps (_mm_loadu_ps (p), step));
+		_mm_storeu_ps (v, _mm_add_ps (vc, _mm_mul_ps (a, t)));
+		_mm_storeu_ps (f, zero);
+	}
+
+	// angular motion
+	__m128 const x = _mm_loadu_ps (&b.qx[i]), y = _mm_loadu_ps (&b.qy[i]);
+	__m128 const z = _mm_loadu_ps (&b.qz[i]), w = _mm_loadu_ps (&b.qw[i]);
+	__m128 wx = _mm_loadu_ps (&b.wx[i]), wy = _mm_loadu_ps (&b.wy[i]), wz = _mm_loadu_ps (&b.wz[i]);
+	__m128 const ax = _mm_mul_ps (_mm_load_ps (dwx), t), ay = _mm_mul_ps (_mm_load_ps (dwy), t);
+	__m128 const az = _mm_mul_ps (_mm_load_ps (dwz), t);
+	// o = q + s (u, 0) q for the quaternion m and angular velocity u
+	auto advance = [&] (__m128 const* m, __m128 ux, __m128 uy, __m128 uz, __m128 s, __m128* o) {
+		// m.w u + u x m.xyz, and u . m.xyz
+		auto term = [&] (__m128 a, __m128 b, __m128 c, __m128 d, __m128 e) {
+			return _mm_sub_ps (_mm_add_ps (_mm_mul_ps (m[3], a), _mm_mul_ps (b, c)), _mm_mul_ps (d, e));
+		};
+		o[0] = _mm_add_ps (x, _mm_mul_ps (s, term (ux, uy, m[2], uz, m[1])));
+		o[1] = _mm_add_ps (y, _mm_mul_ps (s, term (uy, uz, m[0], ux, m[2])));
+		o[2] = _mm_add_ps (z, _mm_mul_ps (s, term (uz, ux, m[1], uy, m[0])));
+		__m128 dot = _mm_add_ps (_mm_mul_ps (ux, m[0]), _mm_mul_ps (uy, m[1]));
+		o[3] = _mm_sub_ps (w, _mm_mul_ps (s, _mm_add_ps (dot, _mm_mul_ps (uz, m[2]))));
+	};
+	__m128 const q[4] = { x, y, z, w };
+	__m128 o[4];
+	__m128 const h = _mm_set1_ps (0.5f);
+	if (method == integrator::rk2)
+	{
+		__m128 m[4];
+		advance (q, wx, wy, wz, _mm_set1_ps (0.25f * dt), m);
+		__m128 const mx = _mm_add_ps (wx, _mm_mul_ps (h, ax)), my = _mm_add_ps (wy, _mm_mul_ps (h, ay));
+		__m128 const mz = _mm_add_ps (wz, _mm_mul_ps (h, az));
+		advance (m, mx, my, mz, _mm_set1_ps (0.5f * dt), o);
+	}
+	else
+	{
+		__m128 const s = _mm_set1_ps (0.5f * dt);
+		advance (q, _mm_add_ps (wx, ax), _mm_add_ps (wy, ay), _mm_add_ps (wz, az), s, o);
+	}
+	wx = _mm_add_ps (wx, ax), wy = _mm_add_ps (wy, ay), wz = _mm_add_ps (wz, az);
+
+	// renormalize, two Newton steps from 1 and the exact value for lanes too far from unit length
+	__m128 const one = _mm_set1_ps (1.f), three_halves = _mm_set1_ps (1.5f);
+	__m128 const m2 = _mm_add_ps (_mm_add_ps (_mm_mul_ps (o[0], o[0]), _mm_mul_ps (o[1], o[1])),
+	    _mm_add_ps (_mm_mul_ps (o[2], o[2]), _mm_mul_ps (o[3], o[3])));
+	__m128 const hm2 = _mm_mul_ps (h, m2);
+	__m128 r = _mm_sub_ps (three_halves, hm2);
+	r = _mm_mul_ps (r, _mm_sub_ps (three_halves, _mm_mul_ps (hm2, _mm_mul_ps (r, r))));
+	__m128 d = _mm_sub_ps (m2, one);
+	d = _mm_max_ps (d, _mm_sub_ps (zero, d));
+	__m128 const far = _mm_cmpge_ps (d, _mm_set1_ps (near_unit));
+	if (_mm_movemask_ps (far) != 0)
+	{
+		__m128 const exact = _mm_div_ps (one, _mm_sqrt_ps (m2));
+		r = _mm_or_ps (_mm_and_ps (far, exact), _mm_andnot_ps (far, r));
+	}
+	__m128 const nx = _mm_mul_ps (o[0], r), ny = _mm_mul_ps (o[1], r);
+	__m128 const nz = _mm_mul_ps (o[2], r), nw = _mm_mul_ps (o[3], r);
+	_mm_storeu_ps (&b.qx[i], nx);
+	_mm_storeu_ps (&b.qy[i], ny);
+	_mm_storeu_ps (&b.qz[i], nz);
+	_mm_storeu_ps (&b.qw[i], nw);
+	_mm_storeu_ps (&b.wx[i], wx);
+	_mm_storeu_ps (&b.wy[i], wy);
+	_mm_storeu_ps (&b.wz[i], wz);
+	_mm_storeu_ps (&b.tx[i], zero);
+	_mm_storeu_ps (&b.ty[i], zero);
+	_mm_storeu_ps (&b.tz[i], zero);
+
+	// world inverse inertia R diag (d) R^T, the sum over k of d[k] times the outer product
+	// of column k of R with itself
+	__m128 const two = _mm_set1_ps (2.f);
+	__m128 const xx = _mm_mul_ps (nx, nx), yy = _mm_mul_ps (ny, ny), zz = _mm_mul_ps (nz, nz);
+	__m128 const xy = _mm_mul_ps (nx, ny), xz = _mm_mul_ps (nx, nz), yz = _mm_mul_ps (ny, nz);
+	__m128 const wxq = _mm_mul_ps (nw, nx), wyq = _mm_mul_ps (nw, ny), wzq = _mm_mul_ps (nw, nz);
+	__m128 const r00 = _mm_sub_ps (one, _mm_mul_ps (two, _mm_add_ps (yy, zz)));
+	__m128 const r11 = _mm_sub_ps (one, _mm_mul_ps (two, _mm_add_ps (xx, zz)));
+	__m128 const r22 = _mm_sub_ps (one, _mm_mul_ps (two, _mm_add_ps (xx, yy)));
+	__m128 const r01 = _mm_mul_ps (two, _mm_sub_ps (xy, wzq)), r10 = _mm_mul_ps (two, _mm_add_ps (xy, wzq));
+	__m128 const r02 = _mm_mul_ps (two, _mm_add_ps (xz, wyq)), r20 = _mm_mul_ps (two, _mm_sub_ps (xz, wyq));
+	__m128 const r12 = _mm_mul_ps (two, _mm_sub_ps (yz, wxq)), r21 = _mm_mul_ps (two, _mm_add_ps (yz, wxq));
+	__m128 const d0 = _mm_loadu_ps (&b.ix[i]), d1 = _mm_loadu_ps (&b.iy[i]), d2 = _mm_loadu_ps (&b.iz[i]);
+	auto entry = [&] (__m128 a0, __m128 a1, __m128 a2, __m128 b0, __m128 b1, __m128 b2) {
+		__m128 sum = _mm_add_ps (_mm_mul_ps (d0, _mm_mul_ps (a0, b0)), _mm_mul_ps (d1, _mm_mul_ps (a1, b1)));
+		return _mm_add_ps (sum, _mm_mul_ps (d2, _mm_mul_ps (a2, b2)));
+	};
+	alignas (16) float e[6][4];
+	_mm_store_ps (e[0], entry (r00, r01, r02, r00, r01, r02));
+	_mm_store_ps (e[1], entry (r00, r01, r02, r10, r11, r12));
+	_mm_store_ps (e[2], entry (r00, r01, r02, r20, r21, r22));
+	_mm_store_ps (e[3], entry (r10, r11, r12, r10, r11, r12));
+	_mm_store_ps (e[4], entry (r10, r11, r12, r20, r21, r22));
+	_mm_store_ps (e[5], entry (r20, r21, r22, r20, r21, r22));
+	for (std::size_t l = 0; l < 4; l++)
+	{
+		float* m = b.inv_inertia[i + l].data;
+		m[0] = e[0][l], m[1] = e[1][l], m[2] = e[2][l];
+		m[3] = e[1][l], m[4] = e[3][l], m[5] = e[4][l];
+		m[6] = e[2][l], m[7] = e[4][l], m[8] = e[5][l];
+	}
+}
+#endif
+} // namespace detail
+
+// Advances every body by dt, then clears the force and torque accumulators and updates
+// the world inertia tensors to the new orientations
+inline void integrate (rigid_bodies& bodies,
+    float dt,
+    vec3<float> const& gravity,
+    integrator method = integrator::semi_implicit_euler,
+    unsigned threads = 1)
+{
+	parallel_for (
+	    bodies.size (),
+	    4096,
+	    [&] (std::size_t first, std::size_t last) {
+		    std::size_t i = first;
+#if defined(CML_SSE2)
+		    for (; i + 4 <= last; i += 4)
+			    detail::integrate4 (bodies, dt, gravity, method, i);
+#endif
+		    for (; i < last; i++)
+			    detail::integrate (bodies, dt, gravity, method, i);
+	    },
+	    threads);
+}
+
+} // namespace cml
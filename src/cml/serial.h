@@ -1,6 +1,7 @@
 #pragma once
 
 #include "cml.h"
+#include "fixed.h"
 
 #include <ostream>
 #include <string>
@@ -10,33 +11,21 @@ namespace cml
 
 using namespace std::string_literals;
 
-template <typename T> std::string to_string (vec2<T> const& v)
+template <std::size_t N, typename T> std::string to_string (vec<N, T> const& v)
 {
-	return "["s + v.x + ", " + v.y + "]";
+	std::string out = "[";
+	for (std::size_t i = 0; i < N; i++)
+		out += (i == 0 ? ""s : ", "s) + v[i];
+	return out + "]";
 }
 
-template <typename T> std::string to_string (vec3<T> const& v)
+template <std::size_t R, std::size_t C, typename T> std::string to_string (mat<R, C, T> const& m)
 {
-	return "["s + v.x + ", " + v.y + ", " + v.z + "]";
-}
-
-template <typename T> std::string to_string (vec4<T> const& v)
-{
-	return "["s + v.x + ", " + v.y + ", " + v.z + ", " + v.w + "]";
-}
-
-template <typename T> std::string to_string (mat3<T> const& m)
-{
-	return "["s + m.get (0) + ", " + m.get (3) + ", " + m.get (6) + ", " + m.get (1) + ", " +
-	       m.get (4) + ", " + m.get (7) + ", " + m.get (2) + ", " + m.get (5) + ", " + m.get (8) + "]";
-}
-
-template <typename T> std::string to_string (mat4<T> const& m)
-{
-	return "["s + m.get (0) + ", " + m.get (4) + ", " + m.get (8) + ", " + m.get (12) + ", " +
-	       m.get (1) + ", " + m.get (5) + ", " + m.get (9) + ", " + m.get (13) + ", " + m.get (2) +
-	       ", " + m.get (6) + ", " + m.get (10) + ", " + m.get (14) + ", " + m.get (3) + ", " +
-	       m.get (7) + ", " + m.get (11) + ", " + m.get (15) + "]";
+	std::string out = "[";
+	for (std::size_t r = 0; r < R; r++)
+		for (std::size_t c = 0; c < C; c++)
+			out += (r == 0 && c == 0 ? ""s : ", "s) + m.at (r, c);
+	return out + "]";
 }
 
 template <typename T> std::string to_string (quat<T> const& v)
@@ -45,36 +34,27 @@ template <typename T> std::string to_string (quat<T> const& v)
 }
 
 
-template <typename T> std::ostream& operator<< (std::ostream& strm, vec2<T> const& v)
-{
-	return strm << "[" << v.x << ", " << v.y << "]";
-}
-
-template <typename T> std::ostream& operator<< (std::ostream& strm, vec3<T> const& v)
-{
-	return strm << "[" << v.x << ", " << v.y << ", " << v.z << "]";
-}
-
-template <typename T> std::ostream& operator<< (std::ostream& strm, vec4<T> const& v)
+template <int B, int F> std::ostream& operator<< (std::ostream& strm, fixed<B, F> const& v)
 {
-	return strm << "[" << v.x << ", " << v.y << ", " << v.z << ", " << v.w << "]";
+	return strm << static_cast<double> (v);
 }
 
-template <typename T> std::ostream& operator<< (std::ostream& strm, mat3<T> const& m)
+template <std::size_t N, typename T> std::ostream& operator<< (std::ostream& strm, vec<N, T> const& v)
 {
-	strm << "[" << m.get (0) << ", " << m.get (3) << ", " << m.get (6) << ", " << m.get (1) << ", "
-	     << m.get (4) << ", " << m.get (7) << ", " << m.get (2) << ", " << m.get (5) << ", "
-	     << m.get (8) << "]";
-	return strm;
+	strm << "[";
+	for (std::size_t i = 0; i < N; i++)
+		strm << (i == 0 ? "" : ", ") << v[i];
+	return strm << "]";
 }
 
-template <typename T> std::ostream& operator<< (std::ostream& strm, mat4<T> const& m)
+template <std::size_t R, std::size_t C, typename T>
+std::ostream& operator<< (std::ostream& strm, mat<R, C, T> const& m)
 {
-	strm << "[" << m.get (0) << ", " << m.get (4) << ", " << m.get (8) << ", " << m.get (12) << ", "
-	     << m.get (1) << ", " << m.get (5) << ", " << m.get (9) << ", " << m.get (13) << ", "
-	     << m.get (2) << ", " << m.get (6) << ", " << m.get (10) << ", " << m.get (14) << ", "
-	     << m.get (3) << ", " << m.get (7) << ", " << m.get (11) << ", " << m.get (15) << "]";
-	return strm;
+	strm << "[";
+	for (std::size_t r = 0; r < R; r++)
+		for (std::size_t c = 0; c < C; c++)
+			strm << (r == 0 && c == 0 ? "" : ", ") << m.at (r, c);
+	return strm << "]";
 }
 
 template <typename T> std::ostream& operator<< (std::ostream& strm, quat<T> const& v)
@@ -0,0 +1,647 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+/*
+Swizzles for vec2, vec3 and vec4.
+
+v.xzy (), v.xy () and v.swizzle<2, 0, 1> () return a new vector made from the
+selected components. Every vector has the two, three and four component
+shorthands of its own component names, so a vec2 has v.xxyy () and a vec3 has
+v.xyzz () as in shader code. The result is built straight from the source components, for
+the over aligned float vectors this compiles down to a single shuffle.
+
+v.masked<0, 2> () = vec2 (...) writes through to only the selected components.
+
+For component streams stored as separate arrays (structure of arrays) a swizzle is
+only a reordering of the stream pointers, swizzle_soa does that without touching
+the data.
+*/
+
+namespace cml
+{
+
+template <std::size_t N, typename T> class vec;
+template <typename T = float> class vec2;
+template <typename T = float> class vec3;
+template <typename T = float> class vec4;
+
+namespace detail
+{
+// The named class for vectors of two to four components, vec<N, T> for the others
+template <typename T, std::size_t N> struct vec_of
+{
+	using type = vec<N, T>;
+};
+template <typename T> struct vec_of<T, 2>
+{
+	using type = vec2<T>;
+};
+template <typename T> struct vec_of<T, 3>
+{
+	using type = vec3<T>;
+};
+template <typename T> struct vec_of<T, 4>
+{
+	using type = vec4<T>;
+};
+
+template <std::size_t N, typename T> using named_vec = typename vec_of<T, N>::type;
+
+// Vectors of two to four components name them x, y, z and w, the others use data
+constexpr bool has_named_components (std::size_t count) { return count >= 2 && count <= 4; }
+
+template <int I, typename V> constexpr auto& component (V& v)
+{
+	if constexpr (!has_named_components (std::remove_const_t<V>::size))
+		return v.data[I];
+	else if constexpr (I == 0)
+		return v.x;
+	else if constexpr (I == 1)
+		return v.y;
+	else if constexpr (I == 2)
+		return v.z;
+	else
+		return v.w;
+}
+
+template <int... I> constexpr bool distinct ()
+{
+	int const idx[] = { I... };
+	for (std::size_t i = 0; i < sizeof...(I); i++)
+		for (std::size_t j = i + 1; j < sizeof...(I); j++)
+			if (idx[i] == idx[j]) return false;
+	return true;
+}
+} // namespace detail
+
+// Writes through to the selected components of a vector
+template <typename V, typename T, int... I> class swizzle_ref
+{
+	static_assert (detail::distinct<I...> (), "a component can only be written once");
+
+	public:
+	using vec_type = typename detail::vec_of<T, sizeof...(I)>::type;
+
+	constexpr explicit swizzle_ref (V& v) : v (v) {}
+
+	constexpr swizzle_ref& operator= (vec_type const& val)
+	{
+		int n = 0;
+		((detail::component<I> (v) = val.get (n++)), ...);
+		return *this;
+	}
+
+	constexpr void operator+= (vec_type const& val) { *this = value () + val; }
+	constexpr void operator-= (vec_type const& val) { *this = value () - val; }
+	constexpr void operator*= (T const val) { *this = value () * val; }
+
+	constexpr vec_type value () const { return vec_type (detail::component<I> (v)...); }
+
+	constexpr operator vec_type () const { return value (); }
+
+	private:
+	V& v;
+};
+
+template <typename V, typename T, int N> class swizzle_base
+{
+	public:
+	// Vector made of the selected components, in order
+	template <int... I> constexpr typename detail::vec_of<T, sizeof...(I)>::type swizzle () const
+	{
+		static_assert (((I >= 0 && I < N) && ...), "swizzle component out of range");
+		V const& v = static_cast<V const&> (*this);
+		return typename detail::vec_of<T, sizeof...(I)>::type (detail::component<I> (v)...);
+	}
+
+	// Writable view of the selected components
+	template <int... I> constexpr swizzle_ref<V, T, I...> masked ()
+	{
+		static_assert (((I >= 0 && I < N) && ...), "swizzle component out of range");
+		return swizzle_ref<V, T, I...> (static_cast<V&> (*this));
+	}
+};
+
+// Only vectors with named components have swizzle shorthands
+template <typename V, typename T, int N> class swizzles : public swizzle_base<V, T, N>
+{
+};
+
+template <typename V, typename T> class swizzles<V, T, 2> : public swizzle_base<V, T, 2>
+{
+	public:
+	constexpr vec2<T> xx () const { return this->template swizzle<0, 0> (); }
+	constexpr vec2<T> xy () const { return this->template swizzle<0, 1> (); }
+	constexpr vec2<T> yx () const { return this->template swizzle<1, 0> (); }
+	constexpr vec2<T> yy () const { return this->template swizzle<1, 1> (); }
+	constexpr vec3<T> xxx () const { return this->template swizzle<0, 0, 0> (); }
+	constexpr vec3<T> xxy () const { return this->template swizzle<0, 0, 1> (); }
+	constexpr vec3<T> xyx () const { return this->template swizzle<0, 1, 0> (); }
+	constexpr vec3<T> xyy () const { return this->template swizzle<0, 1, 1> (); }
+	constexpr vec3<T> yxx () const { return this->template swizzle<1, 0, 0> (); }
+	constexpr vec3<T> yxy () const { return this->template swizzle<1, 0, 1> (); }
+	constexpr vec3<T> yyx () const { return this->template swizzle<1, 1, 0> (); }
+	constexpr vec3<T> yyy () const { return this->template swizzle<1, 1, 1> (); }
+	constexpr vec4<T> xxxx () const { return this->template swizzle<0, 0, 0, 0> (); }
+	constexpr vec4<T> xxxy () const { return this->template swizzle<0, 0, 0, 1> (); }
+	constexpr vec4<T> xxyx () const { return this->template swizzle<0, 0, 1, 0> (); }
+	constexpr vec4<T> xxyy () const { return this->template swizzle<0, 0, 1, 1> (); }
+	constexpr vec4<T> xyxx () const { return this->template swizzle<0, 1, 0, 0> (); }
+	constexpr vec4<T> xyxy () const { return this->template swizzle<0, 1, 0, 1> (); }
+	constexpr vec4<T> xyyx () const { return this->template swizzle<0, 1, 1, 0> (); }
+	constexpr vec4<T> xyyy () const { return this->template swizzle<0, 1, 1, 1> (); }
+	constexpr vec4<T> yxxx () const { return this->template swizzle<1, 0, 0, 0> (); }
+	constexpr vec4<T> yxxy () const { return this->template swizzle<1, 0, 0, 1> (); }
+	constexpr vec4<T> yxyx () const { return this->template swizzle<1, 0, 1, 0> (); }
+	constexpr vec4<T> yxyy () const { return this->template swizzle<1, 0, 1, 1> (); }
+	constexpr vec4<T> yyxx () const { return this->template swizzle<1, 1, 0, 0> (); }
+	constexpr vec4<T> yyxy () const { return this->template swizzle<1, 1, 0, 1> (); }
+	constexpr vec4<T> yyyx () const { return this->template swizzle<1, 1, 1, 0> (); }
+	constexpr vec4<T> yyyy () const { return this->template swizzle<1, 1, 1, 1> (); }
+};
+
+template <typename V, typename T> class swizzles<V, T, 3> : public swizzle_base<V, T, 3>
+{
+	public:
+	constexpr vec2<T> xx () const { return this->template swizzle<0, 0> (); }
+	constexpr vec2<T> xy () const { return this->template swizzle<0, 1> (); }
+	constexpr vec2<T> xz () const { return this->template swizzle<0, 2> (); }
+	constexpr vec2<T> yx () const { return this->template swizzle<1, 0> (); }
+	constexpr vec2<T> yy () const { return this->template swizzle<1, 1> (); }
+	constexpr vec2<T> yz () const { return this->template swizzle<1, 2> (); }
+	constexpr vec2<T> zx () const { return this->template swizzle<2, 0> (); }
+	constexpr vec2<T> zy () const { return this->template swizzle<2, 1> (); }
+	constexpr vec2<T> zz () const { return this->template swizzle<2, 2> (); }
+	constexpr vec3<T> xxx () const { return this->template swizzle<0, 0, 0> (); }
+	constexpr vec3<T> xxy () const { return this->template swizzle<0, 0, 1> (); }
+	constexpr vec3<T> xxz () const { return this->template swizzle<0, 0, 2> (); }
+	constexpr vec3<T> xyx () const { return this->template swizzle<0, 1, 0> (); }
+	constexpr vec3<T> xyy () const { return this->template swizzle<0, 1, 1> (); }
+	constexpr vec3<T> xyz () const { return this->template swizzle<0, 1, 2> (); }
+	constexpr vec3<T> xzx () const { return this->template swizzle<0, 2, 0> (); }
+	constexpr vec3<T> xzy () const { return this->template swizzle<0, 2, 1> (); }
+	constexpr vec3<T> xzz () const { return this->template swizzle<0, 2, 2> (); }
+	constexpr vec3<T> yxx () const { return this->template swizzle<1, 0, 0> (); }
+	constexpr vec3<T> yxy () const { return this->template swizzle<1, 0, 1> (); }
+	constexpr vec3<T> yxz () const { return this->template swizzle<1, 0, 2> (); }
+	constexpr vec3<T> yyx () const { return this->template swizzle<1, 1, 0> (); }
+	constexpr vec3<T> yyy () const { return this->template swizzle<1, 1, 1> (); }
+	constexpr vec3<T> yyz () const { return this->template swizzle<1, 1, 2> (); }
+	constexpr vec3<T> yzx () const { return this->template swizzle<1, 2, 0> (); }
+	constexpr vec3<T> yzy () const { return this->template swizzle<1, 2, 1> (); }
+	constexpr vec3<T> yzz () const { return this->template swizzle<1, 2, 2> (); }
+	constexpr vec3<T> zxx () const { return this->template swizzle<2, 0, 0> (); }
+	constexpr vec3<T> zxy () const { return this->template swizzle<2, 0, 1> (); }
+	constexpr vec3<T> zxz () const { return this->template swizzle<2, 0, 2> (); }
+	constexpr vec3<T> zyx () const { return this->template swizzle<2, 1, 0> (); }
+	constexpr vec3<T> zyy () const { return this->template swizzle<2, 1, 1> (); }
+	constexpr vec3<T> zyz () const { return this->template swizzle<2, 1, 2> (); }
+	constexpr vec3<T> zzx () const { return this->template swizzle<2, 2, 0> (); }
+	constexpr vec3<T> zzy () const { return this->template swizzle<2, 2, 1> (); }
+	constexpr vec3<T> zzz () const { return this->template swizzle<2, 2, 2> (); }
+	constexpr vec4<T> xxxx () const { return this->template swizzle<0, 0, 0, 0> (); }
+	constexpr vec4<T> xxxy () const { return this->template swizzle<0, 0, 0, 1> (); }
+	constexpr vec4<T> xxxz () const { return this->template swizzle<0, 0, 0, 2> (); }
+	constexpr vec4<T> xxyx () const { return this->template swizzle<0, 0, 1, 0> (); }
+	constexpr vec4<T> xxyy () const { return this->template swizzle<0, 0, 1, 1> (); }
+	constexpr vec4<T> xxyz () const { return this->template swizzle<0, 0, 1, 2> (); }
+	constexpr vec4<T> xxzx () const { return this->template swizzle<0, 0, 2, 0> (); }
+	constexpr vec4<T> xxzy () const { return this->template swizzle<0, 0, 2, 1> (); }
+	constexpr vec4<T> xxzz () const { return this->template swizzle<0, 0, 2, 2> (); }
+	constexpr vec4<T> xyxx () const { return this->template swizzle<0, 1, 0, 0> (); }
+	constexpr vec4<T> xyxy () const { return this->template swizzle<0, 1, 0, 1> (); }
+	constexpr vec4<T> xyxz () const { return this->template swizzle<0, 1, 0, 2> (); }
+	constexpr vec4<T> xyyx () const { return this->template swizzle<0, 1, 1, 0> (); }
+	constexpr vec4<T> xyyy () const { return this->template swizzle<0, 1, 1, 1> (); }
+	constexpr vec4<T> xyyz () const { return this->template swizzle<0, 1, 1, 2> (); }
+	constexpr vec4<T> xyzx () const { return this->template swizzle<0, 1, 2, 0> (); }
+	constexpr vec4<T> xyzy () const { return this->template swizzle<0, 1, 2, 1> (); }
+	constexpr vec4<T> xyzz () const { return this->template swizzle<0, 1, 2, 2> (); }
+	constexpr vec4<T> xzxx () const { return this->template swizzle<0, 2, 0, 0> (); }
+	constexpr vec4<T> xzxy () const { return this->template swizzle<0, 2, 0, 1> (); }
+	constexpr vec4<T> xzxz () const { return this->template swizzle<0, 2, 0, 2> (); }
+	constexpr vec4<T> xzyx () const { return this->template swizzle<0, 2, 1, 0> (); }
+	constexpr vec4<T> xzyy () const { return this->template swizzle<0, 2, 1, 1> (); }
+	constexpr vec4<T> xzyz () const { return this->template swizzle<0, 2, 1, 2> (); }
+	constexpr vec4<T> xzzx () const { return this->template swizzle<0, 2, 2, 0> (); }
+	constexpr vec4<T> xzzy () const { return this->template swizzle<0, 2, 2, 1> (); }
+	constexpr vec4<T> xzzz () const { return this->template swizzle<0, 2, 2, 2> (); }
+	constexpr vec4<T> yxxx () const { return this->template swizzle<1, 0, 0, 0> (); }
+	constexpr vec4<T> yxxy () const { return this->template swizzle<1, 0, 0, 1> (); }
+	constexpr vec4<T> yxxz () const { return this->template swizzle<1, 0, 0, 2> (); }
+	constexpr vec4<T> yxyx () const { return this->template swizzle<1, 0, 1, 0> (); }
+	constexpr vec4<T> yxyy () const { return this->template swizzle<1, 0, 1, 1> (); }
+	constexpr vec4<T> yxyz () const { return this->template swizzle<1, 0, 1, 2> (); }
+	constexpr vec4<T> yxzx () const { return this->template swizzle<1, 0, 2, 0> (); }
+	constexpr vec4<T> yxzy () const { return this->template swizzle<1, 0, 2, 1> (); }
+	constexpr vec4<T> yxzz () const { return this->template swizzle<1, 0, 2, 2> (); }
+	constexpr vec4<T> yyxx () const { return this->template swizzle<1, 1, 0, 0> (); }
+	constexpr vec4<T> yyxy () const { return this->template swizzle<1, 1, 0, 1> (); }
+	constexpr vec4<T> yyxz () const { return this->template swizzle<1, 1, 0, 2> (); }
+	constexpr vec4<T> yyyx () const { return this->template swizzle<1, 1, 1, 0> (); }
+	constexpr vec4<T> yyyy () const { return this->template swizzle<1, 1, 1, 1> (); }
+	constexpr vec4<T> yyyz () const { return this->template swizzle<1, 1, 1, 2> (); }
+	constexpr vec4<T> yyzx () const { return this->template swizzle<1, 1, 2, 0> (); }
+	constexpr vec4<T> yyzy () const { return this->template swizzle<1, 1, 2, 1> (); }
+	constexpr vec4<T> yyzz () const { return this->template swizzle<1, 1, 2, 2> (); }
+	constexpr vec4<T> yzxx () const { return this->template swizzle<1, 2, 0, 0> (); }
+	constexpr vec4<T> yzxy () const { return this->template swizzle<1, 2, 0, 1> (); }
+	constexpr vec4<T> yzxz () const { return this->template swizzle<1, 2, 0, 2> (); }
+	constexpr vec4<T> yzyx () const { return this->template swizzle<1, 2, 1, 0> (); }
+	constexpr vec4<T> yzyy () const { return this->template swizzle<1, 2, 1, 1> (); }
+	constexpr vec4<T> yzyz () const { return this->template swizzle<1, 2, 1, 2> (); }
+	constexpr vec4<T> yzzx () const { return this->template swizzle<1, 2, 2, 0> (); }
+	constexpr vec4<T> yzzy () const { return this->template swizzle<1, 2, 2, 1> (); }
+	constexpr vec4<T> yzzz () const { return this->template swizzle<1, 2, 2, 2> (); }
+	constexpr vec4<T> zxxx () const { return this->template swizzle<2, 0, 0, 0> (); }
+	constexpr vec4<T> zxxy () const { return this->template swizzle<2, 0, 0, 1> (); }
+	constexpr vec4<T> zxxz () const { return this->template swizzle<2, 0, 0, 2> (); }
+	constexpr vec4<T> zxyx () const { return this->template swizzle<2, 0, 1, 0> (); }
+	constexpr vec4<T> zxyy () const { return this->template swizzle<2, 0, 1, 1> (); }
+	constexpr vec4<T> zxyz () const { return this->template swizzle<2, 0, 1, 2> (); }
+	constexpr vec4<T> zxzx () const { return this->template swizzle<2, 0, 2, 0> (); }
+	constexpr vec4<T> zxzy () const { return this->template swizzle<2, 0, 2, 1> (); }
+	constexpr vec4<T> zxzz () const { return this->template swizzle<2, 0, 2, 2> (); }
+	constexpr vec4<T> zyxx () const { return this->template swizzle<2, 1, 0, 0> (); }
+	constexpr vec4<T> zyxy () const { return this->template swizzle<2, 1, 0, 1> (); }
+	constexpr vec4<T> zyxz () const { return this->template swizzle<2, 1, 0, 2> (); }
+	constexpr vec4<T> zyyx () const { return this->template swizzle<2, 1, 1, 0> (); }
+	constexpr vec4<T> zyyy () const { return this->template swizzle<2, 1, 1, 1> (); }
+	constexpr vec4<T> zyyz () const { return this->template swizzle<2, 1, 1, 2> (); }
+	constexpr vec4<T> zyzx () const { return this->template swizzle<2, 1, 2, 0> (); }
+	constexpr vec4<T> zyzy () const { return this->template swizzle<2, 1, 2, 1> (); }
+	constexpr vec4<T> zyzz () const { return this->template swizzle<2, 1, 2, 2> (); }
+	constexpr vec4<T> zzxx () const { return this->template swizzle<2, 2, 0, 0> (); }
+	constexpr vec4<T> zzxy () const { return this->template swizzle<2, 2, 0, 1> (); }
+	constexpr vec4<T> zzxz () const { return this->template swizzle<2, 2, 0, 2> (); }
+	constexpr vec4<T> zzyx () const { return this->template swizzle<2, 2, 1, 0> (); }
+	constexpr vec4<T> zzyy () const { return this->template swizzle<2, 2, 1, 1> (); }
+	constexpr vec4<T> zzyz () const { return this->template swizzle<2, 2, 1, 2> (); }
+	constexpr vec4<T> zzzx () const { return this->template swizzle<2, 2, 2, 0> (); }
+	constexpr vec4<T> zzzy () const { return this->template swizzle<2, 2, 2, 1> (); }
+	constexpr vec4<T> zzzz () const { return this->template swizzle<2, 2, 2, 2> (); }
+};
+
+template <typename V, typename T> class swizzles<V, T, 4> : public swizzle_base<V, T, 4>
+{
+	public:
+	constexpr vec2<T> xx () const { return this->template swizzle<0, 0> (); }
+	constexpr vec2<T> xy () const { return this->template swizzle<0, 1> (); }
+	constexpr vec2<T> xz () const { return this->template swizzle<0, 2> (); }
+	constexpr vec2<T> xw () const { return this->template swizzle<0, 3> (); }
+	constexpr vec2<T> yx () const { return this->template swizzle<1, 0> (); }
+	constexpr vec2<T> yy () const { return this->template swizzle<1, 1> (); }
+	constexpr vec2<T> yz () const { return this->template swizzle<1, 2> (); }
+	constexpr vec2<T> yw () const { return this->template swizzle<1, 3> (); }
+	constexpr vec2<T> zx () const { return this->template swizzle<2, 0> (); }
+	constexpr vec2<T> zy () const { return this->template swizzle<2, 1> (); }
+	constexpr vec2<T> zz () const { return this->template swizzle<2, 2> (); }
+	constexpr vec2<T> zw () const { return this->template swizzle<2, 3> (); }
+	constexpr vec2<T> wx () const { return this->template swizzle<3, 0> (); }
+	constexpr vec2<T> wy () const { return this->template swizzle<3, 1> (); }
+	constexpr vec2<T> wz () const { return this->template swizzle<3, 2> (); }
+	constexpr vec2<T> ww () const { return this->template swizzle<3, 3> (); }
+	constexpr vec3<T> xxx () const { return this->template swizzle<0, 0, 0> (); }
+	constexpr vec3<T> xxy () const { return this->template swizzle<0, 0, 1> (); }
+	constexpr vec3<T> xxz () const { return this->template swizzle<0, 0, 2> (); }
+	constexpr vec3<T> xxw () const { return this->template swizzle<0, 0, 3> (); }
+	constexpr vec3<T> xyx () const { return this->template swizzle<0, 1, 0> (); }
+	constexpr vec3<T> xyy () const { return this->template swizzle<0, 1, 1> (); }
+	constexpr vec3<T> xyz () const { return this->template swizzle<0, 1, 2> (); }
+	constexpr vec3<T> xyw () const { return this->template swizzle<0, 1, 3> (); }
+	constexpr vec3<T> xzx () const { return this->template swizzle<0, 2, 0> (); }
+	constexpr vec3<T> xzy () const { return this->template swizzle<0, 2, 1> (); }
+	constexpr vec3<T> xzz () const { return this->template swizzle<0, 2, 2> (); }
+	constexpr vec3<T> xzw () const { return this->template swizzle<0, 2, 3> (); }
+	constexpr vec3<T> xwx () const { return this->template swizzle<0, 3, 0> (); }
+	constexpr vec3<T> xwy () const { return this->template swizzle<0, 3, 1> (); }
+	constexpr vec3<T> xwz () const { return this->template swizzle<0, 3, 2> (); }
+	constexpr vec3<T> xww () const { return this->template swizzle<0, 3, 3> (); }
+	constexpr vec3<T> yxx () const { return this->template swizzle<1, 0, 0> (); }
+	constexpr vec3<T> yxy () const { return this->template swizzle<1, 0, 1> (); }
+	constexpr vec3<T> yxz () const { return this->template swizzle<1, 0, 2> (); }
+	constexpr vec3<T> yxw () const { return this->template swizzle<1, 0, 3> (); }
+	constexpr vec3<T> yyx () const { return this->template swizzle<1, 1, 0> (); }
+	constexpr vec3<T> yyy () const { return this->template swizzle<1, 1, 1> (); }
+	constexpr vec3<T> yyz () const { return this->template swizzle<1, 1, 2> (); }
+	constexpr vec3<T> yyw () const { return this->template swizzle<1, 1, 3> (); }
+	constexpr vec3<T> yzx () const { return this->template swizzle<1, 2, 0> (); }
+	constexpr vec3<T> yzy () const { return this->template swizzle<1, 2, 1> (); }
+	constexpr vec3<T> yzz () const { return this->template swizzle<1, 2, 2> (); }
+	constexpr vec3<T> yzw () const { return this->template swizzle<1, 2, 3> (); }
+	constexpr vec3<T> ywx () const { return this->template swizzle<1, 3, 0> (); }
+	constexpr vec3<T> ywy () const { return this->template swizzle<1, 3, 1> (); }
+	constexpr vec3<T> ywz () const { return this->template swizzle<1, 3, 2> (); }
+	constexpr vec3<T> yww () const { return this->template swizzle<1, 3, 3> (); }
+	constexpr vec3<T> zxx () const { return this->template swizzle<2, 0, 0> (); }
+	constexpr vec3<T> zxy () const { return this->template swizzle<2, 0, 1> (); }
+	constexpr vec3<T> zxz () const { return this->template swizzle<2, 0, 2> (); }
+	constexpr vec3<T> zxw () const { return this->template swizzle<2, 0, 3> (); }
+	constexpr vec3<T> zyx () const { return this->template swizzle<2, 1, 0> (); }
+	constexpr vec3<T> zyy () const { return this->template swizzle<2, 1, 1> (); }
+	constexpr vec3<T> zyz () const { return this->template swizzle<2, 1, 2> (); }
+	constexpr vec3<T> zyw () const { return this->template swizzle<2, 1, 3> (); }
+	constexpr vec3<T> zzx () const { return this->template swizzle<2, 2, 0> (); }
+	constexpr vec3<T> zzy () const { return this->template swizzle<2, 2, 1> (); }
+	constexpr vec3<T> zzz () const { return this->template swizzle<2, 2, 2> (); }
+	constexpr vec3<T> zzw () const { return this->template swizzle<2, 2, 3> (); }
+	constexpr vec3<T> zwx () const { return this->template swizzle<2, 3, 0> (); }
+	constexpr vec3<T> zwy () const { return this->template swizzle<2, 3, 1> (); }
+	constexpr vec3<T> zwz () const { return this->template swizzle<2, 3, 2> (); }
+	constexpr vec3<T> zww () const { return this->template swizzle<2, 3, 3> (); }
+	constexpr vec3<T> wxx () const { return this->template swizzle<3, 0, 0> (); }
+	constexpr vec3<T> wxy () const { return this->template swizzle<3, 0, 1> (); }
+	constexpr vec3<T> wxz () const { return this->template swizzle<3, 0, 2> (); }
+	constexpr vec3<T> wxw () const { return this->template swizzle<3, 0, 3> (); }
+	constexpr vec3<T> wyx () const { return this->template swizzle<3, 1, 0> (); }
+	constexpr vec3<T> wyy () const { return this->template swizzle<3, 1, 1> (); }
+	constexpr vec3<T> wyz () const { return this->template swizzle<3, 1, 2> (); }
+	constexpr vec3<T> wyw () const { return this->template swizzle<3, 1, 3> (); }
+	constexpr vec3<T> wzx () const { return this->template swizzle<3, 2, 0> (); }
+	constexpr vec3<T> wzy () const { return this->template swizzle<3, 2, 1> (); }
+	constexpr vec3<T> wzz () const { return this->template swizzle<3, 2, 2> (); }
+	constexpr vec3<T> wzw () const { return this->template swizzle<3, 2, 3> (); }
+	constexpr vec3<T> wwx () const { return this->template swizzle<3, 3, 0> (); }
+	constexpr vec3<T> wwy () const { return this->template swizzle<3, 3, 1> (); }
+	constexpr vec3<T> wwz () const { return this->template swizzle<3, 3, 2> (); }
+	constexpr vec3<T> www () const { return this->template swizzle<3, 3, 3> (); }
+	constexpr vec4<T> xxxx () const { return this->template swizzle<0, 0, 0, 0> (); }
+	constexpr vec4<T> xxxy () const { return this->template swizzle<0, 0, 0, 1> (); }
+	constexpr vec4<T> xxxz () const { return this->template swizzle<0, 0, 0, 2> (); }
+	constexpr vec4<T> xxxw () const { return this->template swizzle<0, 0, 0, 3> (); }
+	constexpr vec4<T> xxyx () const { return this->template swizzle<0, 0, 1, 0> (); }
+	constexpr vec4<T> xxyy () const { return this->template swizzle<0, 0, 1, 1> (); }
+	constexpr vec4<T> xxyz () const { return this->template swizzle<0, 0, 1, 2> (); }
+	constexpr vec4<T> xxyw () const { return this->template swizzle<0, 0, 1, 3> (); }
+	constexpr vec4<T> xxzx () const { return this->template swizzle<0, 0, 2, 0> (); }
+	constexpr vec4<T> xxzy () const { return this->template swizzle<0, 0, 2, 1> (); }
+	constexpr vec4<T> xxzz () const { return this->template swizzle<0, 0, 2, 2> (); }
+	constexpr vec4<T> xxzw () const { return this->template swizzle<0, 0, 2, 3> (); }
+	constexpr vec4<T> xxwx () const { return this->template swizzle<0, 0, 3, 0> (); }
+	constexpr vec4<T> xxwy () const { return this->template swizzle<0, 0, 3, 1> (); }
+	constexpr vec4<T> xxwz () const { return this->template swizzle<0, 0, 3, 2> (); }
+	constexpr vec4<T> xxww () const { return this->template swizzle<0, 0, 3, 3> (); }
+	constexpr vec4<T> xyxx () const { return this->template swizzle<0, 1, 0, 0> (); }
+	constexpr vec4<T> xyxy () const { return this->template swizzle<0, 1, 0, 1> (); }
+	constexpr vec4<T> xyxz () const { return this->template swizzle<0, 1, 0, 2> (); }
+	constexpr vec4<T> xyxw () const { return this->template swizzle<0, 1, 0, 3> (); }
+	constexpr vec4<T> xyyx () const { return this->template swizzle<0, 1, 1, 0> (); }
+	constexpr vec4<T> xyyy () const { return this->template swizzle<0, 1, 1, 1> (); }
+	constexpr vec4<T> xyyz () const { return this->template swizzle<0, 1, 1, 2> (); }
+	constexpr vec4<T> xyyw () const { return this->template swizzle<0, 1, 1, 3> (); }
+	constexpr vec4<T> xyzx () const { return this->template swizzle<0, 1, 2, 0> (); }
+	constexpr vec4<T> xyzy () const { return this->template swizzle<0, 1, 2, 1> (); }
+	constexpr vec4<T> xyzz () const { return this->template swizzle<0, 1, 2, 2> (); }
+	constexpr vec4<T> xyzw () const { return this->template swizzle<0, 1, 2, 3> (); }
+	constexpr vec4<T> xywx () const { return this->template swizzle<0, 1, 3, 0> (); }
+	constexpr vec4<T> xywy () const { return this->template swizzle<0, 1, 3, 1> (); }
+	constexpr vec4<T> xywz () const { return this->template swizzle<0, 1, 3, 2> (); }
+	constexpr vec4<T> xyww () const { return this->template swizzle<0, 1, 3, 3> (); }
+	constexpr vec4<T> xzxx () const { return this->template swizzle<0, 2, 0, 0> (); }
+	constexpr vec4<T> xzxy () const { return this->template swizzle<0, 2, 0, 1> (); }
+	constexpr vec4<T> xzxz () const { return this->template swizzle<0, 2, 0, 2> (); }
+	constexpr vec4<T> xzxw () const { return this->template swizzle<0, 2, 0, 3> (); }
+	constexpr vec4<T> xzyx () const { return this->template swizzle<0, 2, 1, 0> (); }
+	constexpr vec4<T> xzyy () const { return this->template swizzle<0, 2, 1, 1> (); }
+	constexpr vec4<T> xzyz () const { return this->template swizzle<0, 2, 1, 2> (); }
+	constexpr vec4<T> xzyw () const { return this->template swizzle<0, 2, 1, 3> (); }
+	constexpr vec4<T> xzzx () const { return this->template swizzle<0, 2, 2, 0> (); }
+	constexpr vec4<T> xzzy () const { return this->template swizzle<0, 2, 2, 1> (); }
+	constexpr vec4<T> xzzz () const { return this->template swizzle<0, 2, 2, 2> (); }
+	constexpr vec4<T> xzzw () const { return this->template swizzle<0, 2, 2, 3> (); }
+	constexpr vec4<T> xzwx () const { return this->template swizzle<0, 2, 3, 0> (); }
+	constexpr vec4<T> xzwy () const { return this->template swizzle<0, 2, 3, 1> (); }
+	constexpr vec4<T> xzwz () const { return this->template swizzle<0, 2, 3, 2> (); }
+	constexpr vec4<T> xzww () const { return this->template swizzle<0, 2, 3, 3> (); }
+	constexpr vec4<T> xwxx () const { return this->template swizzle<0, 3, 0, 0> (); }
+	constexpr vec4<T> xwxy () const { return this->template swizzle<0, 3, 0, 1> (); }
+	constexpr vec4<T> xwxz () const { return this->template swizzle<0, 3, 0, 2> (); }
+	constexpr vec4<T> xwxw () const { return this->template swizzle<0, 3, 0, 3> (); }
+	constexpr vec4<T> xwyx () const { return this->template swizzle<0, 3, 1, 0> (); }
+	constexpr vec4<T> xwyy () const { return this->template swizzle<0, 3, 1, 1> (); }
+	constexpr vec4<T> xwyz () const { return this->template swizzle<0, 3, 1, 2> (); }
+	constexpr vec4<T> xwyw () const { return this->template swizzle<0, 3, 1, 3> (); }
+	constexpr vec4<T> xwzx () const { return this->template swizzle<0, 3, 2, 0> (); }
+	constexpr vec4<T> xwzy () const { return this->template swizzle<0, 3, 2, 1> (); }
+	constexpr vec4<T> xwzz () const { return this->template swizzle<0, 3, 2, 2> (); }
+	constexpr vec4<T> xwzw () const { return this->template swizzle<0, 3, 2, 3> (); }
+	constexpr vec4<T> xwwx () const { return this->template swizzle<0, 3, 3, 0> (); }
+	constexpr vec4<T> xwwy () const { return this->template swizzle<0, 3, 3, 1> (); }
+	constexpr vec4<T> xwwz () const { return this->template swizzle<0, 3, 3, 2> (); }
+	constexpr vec4<T> xwww () const { return this->template swizzle<0, 3, 3, 3> (); }
+	constexpr vec4<T> yxxx () const { return this->template swizzle<1, 0, 0, 0> (); }
+	constexpr vec4<T> yxxy () const { return this->template swizzle<1, 0, 0, 1> (); }
+	constexpr vec4<T> yxxz () const { return this->template swizzle<1, 0, 0, 2> (); }
+	constexpr vec4<T> yxxw () const { return this->template swizzle<1, 0, 0, 3> (); }
+	constexpr vec4<T> yxyx () const { return this->template swizzle<1, 0, 1, 0> (); }
+	constexpr vec4<T> yxyy () const { return this->template swizzle<1, 0, 1, 1> (); }
+	constexpr vec4<T> yxyz () const { return this->template swizzle<1, 0, 1, 2> (); }
+	constexpr vec4<T> yxyw () const { return this->template swizzle<1, 0, 1, 3> (); }
+	constexpr vec4<T> yxzx () const { return this->template swizzle<1, 0, 2, 0> (); }
+	constexpr vec4<T> yxzy () const { return this->template swizzle<1, 0, 2, 1> (); }
+	constexpr vec4<T> yxzz () const { return this->template swizzle<1, 0, 2, 2> (); }
+	constexpr vec4<T> yxzw () const { return this->template swizzle<1, 0, 2, 3> (); }
+	constexpr vec4<T> yxwx () const { return this->template swizzle<1, 0, 3, 0> (); }
+	constexpr vec4<T> yxwy () const { return this->template swizzle<1, 0, 3, 1> (); }
+	constexpr vec4<T> yxwz () const { return this->template swizzle<1, 0, 3, 2> (); }
+	constexpr vec4<T> yxww () const { return this->template swizzle<1, 0, 3, 3> (); }
+	constexpr vec4<T> yyxx () const { return this->template swizzle<1, 1, 0, 0> (); }
+	constexpr vec4<T> yyxy () const { return this->template swizzle<1, 1, 0, 1> (); }
+	constexpr vec4<T> yyxz () const { return this->template swizzle<1, 1, 0, 2> (); }
+	constexpr vec4<T> yyxw () const { return this->template swizzle<1, 1, 0, 3> (); }
+	constexpr vec4<T> yyyx () const { return this->template swizzle<1, 1, 1, 0> (); }
+	constexpr vec4<T> yyyy () const { return this->template swizzle<1, 1, 1, 1> (); }
+	constexpr vec4<T> yyyz () const { return this->template swizzle<1, 1, 1, 2> (); }
+	constexpr vec4<T> yyyw () const { return this->template swizzle<1, 1, 1, 3> (); }
+	constexpr vec4<T> yyzx () const { return this->template swizzle<1, 1, 2, 0> (); }
+	constexpr vec4<T> yyzy () const { return this->template swizzle<1, 1, 2, 1> (); }
+	constexpr vec4<T> yyzz () const { return this->template swizzle<1, 1, 2, 2> (); }
+	constexpr vec4<T> yyzw () const { return this->template swizzle<1, 1, 2, 3> (); }
+	constexpr vec4<T> yywx () const { return this->template swizzle<1, 1, 3, 0> (); }
+	constexpr vec4<T> yywy () const { return this->template swizzle<1, 1, 3, 1> (); }
+	constexpr vec4<T> yywz () const { return this->template swizzle<1, 1, 3, 2> (); }
+	constexpr vec4<T> yyww () const { return this->template swizzle<1, 1, 3, 3> (); }
+	constexpr vec4<T> yzxx () const { return this->template swizzle<1, 2, 0, 0> (); }
+	constexpr vec4<T> yzxy () const { return this->template swizzle<1, 2, 0, 1> (); }
+	constexpr vec4<T> yzxz () const { return this->template swizzle<1, 2, 0, 2> (); }
+	constexpr vec4<T> yzxw () const { return this->template swizzle<1, 2, 0, 3> (); }
+	constexpr vec4<T> yzyx () const { return this->template swizzle<1, 2, 1, 0> (); }
+	constexpr vec4<T> yzyy () const { return this->template swizzle<1, 2, 1, 1> (); }
+	constexpr vec4<T> yzyz () const { return this->template swizzle<1, 2, 1, 2> (); }
+	constexpr vec4<T> yzyw () const { return this->template swizzle<1, 2, 1, 3> (); }
+	constexpr vec4<T> yzzx () const { return this->template swizzle<1, 2, 2, 0> (); }
+	constexpr vec4<T> yzzy () const { return this->template swizzle<1, 2, 2, 1> (); }
+	constexpr vec4<T> yzzz () const { return this->template swizzle<1, 2, 2, 2> (); }
+	constexpr vec4<T> yzzw () const { return this->template swizzle<1, 2, 2, 3> (); }
+	constexpr vec4<T> yzwx () const { return this->template swizzle<1, 2, 3, 0> (); }
+	constexpr vec4<T> yzwy () const { return this->template swizzle<1, 2, 3, 1> (); }
+	constexpr vec4<T> yzwz () const { return this->template swizzle<1, 2, 3, 2> (); }
+	constexpr vec4<T> yzww () const { return this->template swizzle<1, 2, 3, 3> (); }
+	constexpr vec4<T> ywxx () const { return this->template swizzle<1, 3, 0, 0> (); }
+	constexpr vec4<T> ywxy () const { return this->template swizzle<1, 3, 0, 1> (); }
+	constexpr vec4<T> ywxz () const { return this->template swizzle<1, 3, 0, 2> (); }
+	constexpr vec4<T> ywxw () const { return this->template swizzle<1, 3, 0, 3> (); }
+	constexpr vec4<T> ywyx () const { return this->template swizzle<1, 3, 1, 0> (); }
+	constexpr vec4<T> ywyy () const { return this->template swizzle<1, 3, 1, 1> (); }
+	constexpr vec4<T> ywyz () const { return this->template swizzle<1, 3, 1, 2> (); }
+	constexpr vec4<T> ywyw () const { return this->template swizzle<1, 3, 1, 3> (); }
+	constexpr vec4<T> ywzx () const { return this->template swizzle<1, 3, 2, 0> (); }
+	constexpr vec4<T> ywzy () const { return this->template swizzle<1, 3, 2, 1> (); }
+	constexpr vec4<T> ywzz () const { return this->template swizzle<1, 3, 2, 2> (); }
+	constexpr vec4<T> ywzw () const { return this->template swizzle<1, 3, 2, 3> (); }
+	constexpr vec4<T> ywwx () const { return this->template swizzle<1, 3, 3, 0> (); }
+	constexpr vec4<T> ywwy () const { return this->template swizzle<1, 3, 3, 1> (); }
+	constexpr vec4<T> ywwz () const { return this->template swizzle<1, 3, 3, 2> (); }
+	constexpr vec4<T> ywww () const { return this->template swizzle<1, 3, 3, 3> (); }
+	constexpr vec4<T> zxxx () const { return this->template swizzle<2, 0, 0, 0> (); }
+	constexpr vec4<T> zxxy () const { return this->template swizzle<2, 0, 0, 1> (); }
+	constexpr vec4<T> zxxz () const { return this->template swizzle<2, 0, 0, 2> (); }
+	constexpr vec4<T> zxxw () const { return this->template swizzle<2, 0, 0, 3> (); }
+	constexpr vec4<T> zxyx () const { return this->template swizzle<2, 0, 1, 0> (); }
+	constexpr vec4<T> zxyy () const { return this->template swizzle<2, 0, 1, 1> (); }
+	constexpr vec4<T> zxyz () const { return this->template swizzle<2, 0, 1, 2> (); }
+	constexpr vec4<T> zxyw () const { return this->template swizzle<2, 0, 1, 3> (); }
+	constexpr vec4<T> zxzx () const { return this->template swizzle<2, 0, 2, 0> (); }
+	constexpr vec4<T> zxzy () const { return this->template swizzle<2, 0, 2, 1> (); }
+	constexpr vec4<T> zxzz () const { return this->template swizzle<2, 0, 2, 2> (); }
+	constexpr vec4<T> zxzw () const { return this->template swizzle<2, 0, 2, 3> (); }
+	constexpr vec4<T> zxwx () const { return this->template swizzle<2, 0, 3, 0> (); }
+	constexpr vec4<T> zxwy () const { return this->template swizzle<2, 0, 3, 1> (); }
+	constexpr vec4<T> zxwz () const { return this->template swizzle<2, 0, 3, 2> (); }
+	constexpr vec4<T> zxww () const { return this->template swizzle<2, 0, 3, 3> (); }
+	constexpr vec4<T> zyxx () const { return this->template swizzle<2, 1, 0, 0> (); }
+	constexpr vec4<T> zyxy () const { return this->template swizzle<2, 1, 0, 1> (); }
+	constexpr vec4<T> zyxz () const { return this->template swizzle<2, 1, 0, 2> (); }
+	constexpr vec4<T> zyxw () const { return this->template swizzle<2, 1, 0, 3> (); }
+	constexpr vec4<T> zyyx () const { return this->template swizzle<2, 1, 1, 0> (); }
+	constexpr vec4<T> zyyy () const { return this->template swizzle<2, 1, 1, 1> (); }
+	constexpr vec4<T> zyyz () const { return this->template swizzle<2, 1, 1, 2> (); }
+	constexpr vec4<T> zyyw () const { return this->template swizzle<2, 1, 1, 3> (); }
+	constexpr vec4<T> zyzx () const { return this->template swizzle<2, 1, 2, 0> (); }
+	constexpr vec4<T> zyzy () const { return this->template swizzle<2, 1, 2, 1> (); }
+	constexpr vec4<T> zyzz () const { return this->template swizzle<2, 1, 2, 2> (); }
+	constexpr vec4<T> zyzw () const { return this->template swizzle<2, 1, 2, 3> (); }
+	constexpr vec4<T> zywx () const { return this->template swizzle<2, 1, 3, 0> (); }
+	constexpr vec4<T> zywy () const { return this->template swizzle<2, 1, 3, 1> (); }
+	constexpr vec4<T> zywz () const { return this->template swizzle<2, 1, 3, 2> (); }
+	constexpr vec4<T> zyww () const { return this->template swizzle<2, 1, 3, 3> (); }
+	constexpr vec4<T> zzxx () const { return this->template swizzle<2, 2, 0, 0> (); }
+	constexpr vec4<T> zzxy () const { return this->template swizzle<2, 2, 0, 1> (); }
+	constexpr vec4<T> zzxz () const { return this->template swizzle<2, 2, 0, 2> (); }
+	constexpr vec4<T> zzxw () const { return this->template swizzle<2, 2, 0, 3> (); }
+	constexpr vec4<T> zzyx () const { return this->template swizzle<2, 2, 1, 0> (); }
+	constexpr vec4<T> zzyy () const { return this->template swizzle<2, 2, 1, 1> (); }
+	constexpr vec4<T> zzyz () const { return this->template swizzle<2, 2, 1, 2> (); }
+	constexpr vec4<T> zzyw () const { return this->template swizzle<2, 2, 1, 3> (); }
+	constexpr vec4<T> zzzx () const { return this->template swizzle<2, 2, 2, 0> (); }
+	constexpr vec4<T> zzzy () const { return this->template swizzle<2, 2, 2, 1> (); }
+	constexpr vec4<T> zzzz () const { return this->template swizzle<2, 2, 2, 2> (); }
+	constexpr vec4<T> zzzw () const { return this->template swizzle<2, 2, 2, 3> (); }
+	constexpr vec4<T> zzwx () const { return this->template swizzle<2, 2, 3, 0> (); }
+	constexpr vec4<T> zzwy () const { return this->template swizzle<2, 2, 3, 1> (); }
+	constexpr vec4<T> zzwz () const { return this->template swizzle<2, 2, 3, 2> (); }
+	constexpr vec4<T> zzww () const { return this->template swizzle<2, 2, 3, 3> (); }
+	constexpr vec4<T> zwxx () const { return this->template swizzle<2, 3, 0, 0> (); }
+	constexpr vec4<T> zwxy () const { return this->template swizzle<2, 3, 0, 1> (); }
+	constexpr vec4<T> zwxz () const { return this->template swizzle<2, 3, 0, 2> (); }
+	constexpr vec4<T> zwxw () const { return this->template swizzle<2, 3, 0, 3> (); }
+	constexpr vec4<T> zwyx () const { return this->template swizzle<2, 3, 1, 0> (); }
+	constexpr vec4<T> zwyy () const { return this->template swizzle<2, 3, 1, 1> (); }
+	constexpr vec4<T> zwyz () const { return this->template swizzle<2, 3, 1, 2> (); }
+	constexpr vec4<T> zwyw () const { return this->template swizzle<2, 3, 1, 3> (); }
+	constexpr vec4<T> zwzx () const { return this->template swizzle<2, 3, 2, 0> (); }
+	constexpr vec4<T> zwzy () const { return this->template swizzle<2, 3, 2, 1> (); }
+	constexpr vec4<T> zwzz () const { return this->template swizzle<2, 3, 2, 2> (); }
+	constexpr vec4<T> zwzw () const { return this->template swizzle<2, 3, 2, 3> (); }
+	constexpr vec4<T> zwwx () const { return this->template swizzle<2, 3, 3, 0> (); }
+	constexpr vec4<T> zwwy () const { return this->template swizzle<2, 3, 3, 1> (); }
+	constexpr vec4<T> zwwz () const { return this->template swizzle<2, 3, 3, 2> (); }
+	constexpr vec4<T> zwww () const { return this->template swizzle<2, 3, 3, 3> (); }
+	constexpr vec4<T> wxxx () const { return this->template swizzle<3, 0, 0, 0> (); }
+	constexpr vec4<T> wxxy () const { return this->template swizzle<3, 0, 0, 1> (); }
+	constexpr vec4<T> wxxz () const { return this->template swizzle<3, 0, 0, 2> (); }
+	constexpr vec4<T> wxxw () const { return this->template swizzle<3, 0, 0, 3> (); }
+	constexpr vec4<T> wxyx () const { return this->template swizzle<3, 0, 1, 0> (); }
+	constexpr vec4<T> wxyy () const { return this->template swizzle<3, 0, 1, 1> (); }
+	constexpr vec4<T> wxyz () const { return this->template swizzle<3, 0, 1, 2> (); }
+	constexpr vec4<T> wxyw () const { return this->template swizzle<3, 0, 1, 3> (); }
+	constexpr vec4<T> wxzx () const { return this->template swizzle<3, 0, 2, 0> (); }
+	constexpr vec4<T> wxzy () const { return this->template swizzle<3, 0, 2, 1> (); }
+	constexpr vec4<T> wxzz () const { return this->template swizzle<3, 0, 2, 2> (); }
+	constexpr vec4<T> wxzw () const { return this->template swizzle<3, 0, 2, 3> (); }
+	constexpr vec4<T> wxwx () const { return this->template swizzle<3, 0, 3, 0> (); }
+	constexpr vec4<T> wxwy () const { return this->template swizzle<3, 0, 3, 1> (); }
+	constexpr vec4<T> wxwz () const { return this->template swizzle<3, 0, 3, 2> (); }
+	constexpr vec4<T> wxww () const { return this->template swizzle<3, 0, 3, 3> (); }
+	constexpr vec4<T> wyxx () const { return this->template swizzle<3, 1, 0, 0> (); }
+	constexpr vec4<T> wyxy () const { return this->template swizzle<3, 1, 0, 1> (); }
+	constexpr vec4<T> wyxz () const { return this->template swizzle<3, 1, 0, 2> (); }
+	constexpr vec4<T> wyxw () const { return this->template swizzle<3, 1, 0, 3> (); }
+	constexpr vec4<T> wyyx () const { return this->template swizzle<3, 1, 1, 0> (); }
+	constexpr vec4<T> wyyy () const { return this->template swizzle<3, 1, 1, 1> (); }
+	constexpr vec4<T> wyyz () const { return this->template swizzle<3, 1, 1, 2> (); }
+	constexpr vec4<T> wyyw () const { return this->template swizzle<3, 1, 1, 3> (); }
+	constexpr vec4<T> wyzx () const { return this->template swizzle<3, 1, 2, 0> (); }
+	constexpr vec4<T> wyzy () const { return this->template swizzle<3, 1, 2, 1> (); }
+	constexpr vec4<T> wyzz () const { return this->template swizzle<3, 1, 2, 2> (); }
+	constexpr vec4<T> wyzw () const { return this->template swizzle<3, 1, 2, 3> (); }
+	constexpr vec4<T> wywx () const { return this->template swizzle<3, 1, 3, 0> (); }
+	constexpr vec4<T> wywy () const { return this->template swizzle<3, 1, 3, 1> (); }
+	constexpr vec4<T> wywz () const { return this->template swizzle<3, 1, 3, 2> (); }
+	constexpr vec4<T> wyww () const { return this->template swizzle<3, 1, 3, 3> (); }
+	constexpr vec4<T> wzxx () const { return this->template swizzle<3, 2, 0, 0> (); }
+	constexpr vec4<T> wzxy () const { return this->template swizzle<3, 2, 0, 1> (); }
+	constexpr vec4<T> wzxz () const { return this->template swizzle<3, 2, 0, 2> (); }
+	constexpr vec4<T> wzxw () const { return this->template swizzle<3, 2, 0, 3> (); }
+	constexpr vec4<T> wzyx () const { return this->template swizzle<3, 2, 1, 0> (); }
+	constexpr vec4<T> wzyy () const { return this->template swizzle<3, 2, 1, 1> (); }
+	constexpr vec4<T> wzyz () const { return this->template swizzle<3, 2, 1, 2> (); }
+	constexpr vec4<T> wzyw () const { return this->template swizzle<3, 2, 1, 3> (); }
+	constexpr vec4<T> wzzx () const { return this->template swizzle<3, 2, 2, 0> (); }
+	constexpr vec4<T> wzzy () const { return this->template swizzle<3, 2, 2, 1> (); }
+	constexpr vec4<T> wzzz () const { return this->template swizzle<3, 2, 2, 2> (); }
+	constexpr vec4<T> wzzw () const { return this->template swizzle<3, 2, 2, 3> (); }
+	constexpr vec4<T> wzwx () const { return this->template swizzle<3, 2, 3, 0> (); }
+	constexpr vec4<T> wzwy () const { return this->template swizzle<3, 2, 3, 1> (); }
+	constexpr vec4<T> wzwz () const { return this->template swizzle<3, 2, 3, 2> (); }
+	constexpr vec4<T> wzww () const { return this->template swizzle<3, 2, 3, 3> (); }
+	constexpr vec4<T> wwxx () const { return this->template swizzle<3, 3, 0, 0> (); }
+	constexpr vec4<T> wwxy () const { return this->template swizzle<3, 3, 0, 1> (); }
+	constexpr vec4<T> wwxz () const { return this->template swizzle<3, 3, 0, 2> (); }
+	constexpr vec4<T> wwxw () const { return this->template swizzle<3, 3, 0, 3> (); }
+	constexpr vec4<T> wwyx () const { return this->template swizzle<3, 3, 1, 0> (); }
+	constexpr vec4<T> wwyy () const { return this->template swizzle<3, 3, 1, 1> (); }
+	constexpr vec4<T> wwyz () const { return this->template swizzle<3, 3, 1, 2> (); }
+	constexpr vec4<T> wwyw () const { return this->template swizzle<3, 3, 1, 3> (); }
+	constexpr vec4<T> wwzx () const { return this->template swizzle<3, 3, 2, 0> (); }
+	constexpr vec4<T> wwzy () const { return this->template swizzle<3, 3, 2, 1> (); }
+	constexpr vec4<T> wwzz () const { return this->template swizzle<3, 3, 2, 2> (); }
+	constexpr vec4<T> wwzw () const { return this->template swizzle<3, 3, 2, 3> (); }
+	constexpr vec4<T> wwwx () const { return this->template swizzle<3, 3, 3, 0> (); }
+	constexpr vec4<T> wwwy () const { return this->template swizzle<3, 3, 3, 1> (); }
+	constexpr vec4<T> wwwz () const { return this->template swizzle<3, 3, 3, 2> (); }
+	constexpr vec4<T> wwww () const { return this->template swizzle<3, 3, 3, 3> (); }
+};
+
+// BATCHED
+
+// out[i] = in[i].swizzle<I...> ()
+template <int... I, typename V>
+void swizzle (V const* in, typename detail::vec_of<typename V::value_type, sizeof...(I)>::type* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = in[i].template swizzle<I...> ();
+}
+
+// Reorders the component streams of a structure of arrays, no data is copied
+template <int... I, typename T, std::size_t N>
+constexpr std::array<T*, sizeof...(I)> swizzle_soa (std::array<T*, N> const& streams)
+{
+	static_assert (((I >= 0 && I < static_cast<int> (N)) && ...), "swizzle component out of range");
+	return std::array<T*, sizeof...(I)>{ streams[I]... };
+}
+
+} // namespace cml
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstddef>
+
 #include "mat3.h"
 #include "mat4.h"
+#include "quat.h"
 
 
 namespace cml
@@ -121,5 +124,234 @@ template <typename T> mat4<T> ortho (T left, T right, T bottom, T top, T near, T
 	return out;
 }
 
+// TRS
+
+template <typename T> struct trs
+{
+	vec3<T> translation;
+	quat<T> rotation;
+	vec3<T> scale = vec3<T> (1);
+};
+
+// Translation * rotation * scale, written directly from the quaternion terms
+template <typename T> mat4<T> compose_trs (vec3<T> const& t, quat<T> const& r, vec3<T> const& s)
+{
+	vec3<T> const im = r.getImag ();
+	T const x = im.x, y = im.y, z = im.z, w = r.getReal ();
+	T const xx = x * x, yy = y * y, zz = z * z;
+	T const xy = x * y, xz = x * z, yz = y * z;
+	T const wx = w * x, wy = w * y, wz = w * z;
+
+	mat4<T> out;
+	T* d = out.data;
+	d[0] = (1 - 2 * (yy + zz)) * s.x;
+	d[1] = 2 * (xy + wz) * s.x;
+	d[2] = 2 * (xz - wy) * s.x;
+	d[4] = 2 * (xy - wz) * s.y;
+	d[5] = (1 - 2 * (xx + zz)) * s.y;
+	d[6] = 2 * (yz + wx) * s.y;
+	d[8] = 2 * (xz + wy) * s.z;
+	d[9] = 2 * (yz - wx) * s.z;
+	d[10] = (1 - 2 * (xx + yy)) * s.z;
+	d[12] = t.x;
+	d[13] = t.y;
+	d[14] = t.z;
+	return out;
+}
+
+template <typename T> mat4<T> compose_trs (trs<T> const& v) { return compose_trs (v.translation, v.rotation, v.scale); }
+
+// Rotation matrix of a unit quaternion
+template <typename T> mat3<T> rotation_matrix (quat<T> const& r)
+{
+	vec3<T> const im = r.getImag ();
+	T const x = im.x, y = im.y, z = im.z, w = r.getReal ();
+	T const xx = x * x, yy = y * y, zz = z * z;
+	T const xy = x * y, xz = x * z, yz = y * z;
+	T const wx = w * x, wy = w * y, wz = w * z;
+	return mat3<T> (1 - 2 * (yy + zz), 2 * (xy - wz), 2 * (xz + wy),
+	    2 * (xy + wz), 1 - 2 * (xx + zz), 2 * (yz - wx),
+	    2 * (xz - wy), 2 * (yz + wx), 1 - 2 * (xx + yy));
+}
+
+namespace detail
+{
+// Shepperd's method, picks the largest of w, x, y, z to divide by so it stays accurate for any rotation
+template <typename T>
+quat<T> quat_from_rotation (T m00, T m01, T m02, T m10, T m11, T m12, T m20, T m21, T m22)
+{
+	T const one = static_cast<T> (1), quarter = static_cast<T> (0.25);
+	T const trace = m00 + m11 + m22;
+	quat<T> q;
+	if (trace > 0)
+	{
+		T s = sqrt (trace + one) * 2;
+		q = quat<T> ((m21 - m12) / s, (m02 - m20) / s, (m10 - m01) / s, quarter * s);
+	}
+	else if (m00 > m11 && m00 > m22)
+	{
+		T s = sqrt (one + m00 - m11 - m22) * 2;
+		q = quat<T> (quarter * s, (m01 + m10) / s, (m02 + m20) / s, (m21 - m12) / s);
+	}
+	else if (m11 > m22)
+	{
+		T s = sqrt (one + m11 - m00 - m22) * 2;
+		q = quat<T> ((m01 + m10) / s, quarter * s, (m12 + m21) / s, (m02 - m20) / s);
+	}
+	else
+	{
+		T s = sqrt (one + m22 - m00 - m11) * 2;
+		q = quat<T> ((m02 + m20) / s, (m12 + m21) / s, quarter * s, (m10 - m01) / s);
+	}
+	q.norm ();
+	return q;
+}
+} // namespace detail
+
+// Rotation of an orthonormal matrix
+template <typename T> quat<T> quat_from_matrix (mat3<T> const& m)
+{
+	T const* d = m.data;
+	return detail::quat_from_rotation (d[0], d[3], d[6], d[1], d[4], d[7], d[2], d[5], d[8]);
+}
+
+// Rotation of the upper 3x3 of a matrix without scale
+template <typename T> quat<T> quat_from_matrix (mat4<T> const& m)
+{
+	T const* d = m.data;
+	return detail::quat_from_rotation (d[0], d[4], d[8], d[1], d[5], d[9], d[2], d[6], d[10]);
+}
+
+// Splits an affine matrix without shear into translation, rotation and scale. A mirroring
+// matrix gets a negative x scale.
+template <typename T> trs<T> decompose_trs (mat4<T> const& m)
+{
+	T const* d = m.data;
+	vec3<T> c0 (d[0], d[1], d[2]), c1 (d[4], d[5], d[6]), c2 (d[8], d[9], d[10]);
+	trs<T> out;
+	out.translation = vec3<T> (d[12], d[13], d[14]);
+	out.scale = vec3<T> (c0.length (), c1.length (), c2.length ());
+	if (dot (cross (c0, c1), c2) < 0) out.scale.x = -out.scale.x;
+
+	// zero scale axes leave the rotation undefined, keep them from dividing by zero
+	vec3<T> inv (out.scale.x != 0 ? 1 / out.scale.x : 0,
+	    out.scale.y != 0 ? 1 / out.scale.y : 0,
+	    out.scale.z != 0 ? 1 / out.scale.z : 0);
+	c0 *= inv.x, c1 *= inv.y, c2 *= inv.z;
+	out.rotation = detail::quat_from_rotation (c0.x, c1.x, c2.x, c0.y, c1.y, c2.y, c0.z, c1.z, c2.z);
+	return out;
+}
+
+// out[i] = compose_trs (t[i], r[i], s[i])
+template <typename T>
+void compose_trs (vec3<T> const* t, quat<T> const* r, vec3<T> const* s, mat4<T>* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = compose_trs (t[i], r[i], s[i]);
+}
+
+// out[i] = decompose_trs (in[i])
+template <typename T> void decompose_trs (mat4<T> const* in, trs<T>* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		out[i] = decompose_trs (in[i]);
+}
+
+// NORMAL MATRIX
+
+namespace detail
+{
+// Cofactor matrix of the upper 3x3 of column major d, written column major to out,
+// returns the determinant of the upper 3x3
+template <typename T> T upper_cofactors (T const* d, T* out)
+{
+	out[0] = d[5] * d[10] - d[9] * d[6];
+	out[3] = d[9] * d[2] - d[1] * d[10];
+	out[6] = d[1] * d[6] - d[5] * d[2];
+	out[1] = d[8] * d[6] - d[4] * d[10];
+	out[4] = d[0] * d[10] - d[8] * d[2];
+	out[7] = d[4] * d[2] - d[0] * d[6];
+	out[2] = d[4] * d[9] - d[8] * d[5];
+	out[5] = d[8] * d[1] - d[0] * d[9];
+	out[8] = d[0] * d[5] - d[4] * d[1];
+	return d[0] * out[0] + d[4] * out[3] + d[8] * out[6];
+}
+} // namespace detail
+
+// Inverse transpose of the upper 3x3, maps normals of a model matrix. Singular matrices
+// keep their cofactors instead of dividing by zero.
+template <typename T> mat3<T> normal_matrix (mat4<T> const& m)
+{
+	mat3<T> out;
+	T det = detail::upper_cofactors (m.data, out.data);
+	T inv_det = static_cast<T> (1) / (det == 0 ? static_cast<T> (1) : det);
+	for (T& v : out.data)
+		v *= inv_det;
+	return out;
+}
+
+// Cofactor matrix of the upper 3x3, the normal matrix times the determinant. Enough when
+// normals are renormalized afterwards, but it flips them for mirroring matrices.
+template <typename T> mat3<T> normal_direction_matrix (mat4<T> const& m)
+{
+	mat3<T> out;
+	detail::upper_cofactors (m.data, out.data);
+	return out;
+}
+
+// Normal matrix of a rotation with uniform scale s, which is the upper 3x3 over s^2
+template <typename T> mat3<T> uniform_normal_matrix (mat4<T> const& m)
+{
+	T const* d = m.data;
+	T inv_s2 = static_cast<T> (1) / (d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+	return mat3<T> (d[0] * inv_s2, d[4] * inv_s2, d[8] * inv_s2,
+	    d[1] * inv_s2, d[5] * inv_s2, d[9] * inv_s2,
+	    d[2] * inv_s2, d[6] * inv_s2, d[10] * inv_s2);
+}
+
+// out[i] = normal_matrix (in[i]), or normal_direction_matrix (in[i]) when divide is false.
+// Works on blocks of 8 matrices with every entry in its own lane array so the cofactor
+// math runs on full SIMD registers.
+template <typename T> void normal_matrix (mat4<T> const* in, mat3<T>* out, std::size_t count, bool divide = true)
+{
+	constexpr std::size_t W = 8;
+	constexpr int src[9] = { 0, 1, 2, 4, 5, 6, 8, 9, 10 };
+	for (std::size_t first = 0; first < count; first += W)
+	{
+		std::size_t const n = count - first < W ? count - first : W;
+		T a[9][W] = {};
+		for (std::size_t l = 0; l < n; l++)
+			for (int k = 0; k < 9; k++)
+				a[k][l] = in[first + l].data[src[k]];
+
+		T c[9][W];
+		for (std::size_t l = 0; l < W; l++)
+		{
+			c[0][l] = a[4][l] * a[8][l] - a[7][l] * a[5][l];
+			c[3][l] = a[7][l] * a[2][l] - a[1][l] * a[8][l];
+			c[6][l] = a[1][l] * a[5][l] - a[4][l] * a[2][l];
+			c[1][l] = a[6][l] * a[5][l] - a[3][l] * a[8][l];
+			c[4][l] = a[0][l] * a[8][l] - a[6][l] * a[2][l];
+			c[7][l] = a[3][l] * a[2][l] - a[0][l] * a[5][l];
+			c[2][l] = a[3][l] * a[7][l] - a[6][l] * a[4][l];
+			c[5][l] = a[6][l] * a[1][l] - a[0][l] * a[7][l];
+			c[8][l] = a[0][l] * a[4][l] - a[3][l] * a[1][l];
+		}
+		if (divide)
+		{
+			for (std::size_t l = 0; l < W; l++)
+			{
+				T det = a[0][l] * c[0][l] + a[3][l] * c[3][l] + a[6][l] * c[6][l];
+				T inv_det = static_cast<T> (1) / (det == 0 ? static_cast<T> (1) : det);
+				for (int k = 0; k < 9; k++)
+					c[k][l] *= inv_det;
+			}
+		}
+
+		for (std::size_t l = 0; l < n; l++)
+			for (int k = 0; k < 9; k++)
+				out[first + l].data[k] = c[k][l];
+	}
+}
 
-} // namespace cml
\ No newline at end of file
+} // namespace cml
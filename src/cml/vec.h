@@ -0,0 +1,503 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "common.h"
+#include "swizzle.h"
+
+/*
+N component vector, the one implementation behind vec2, vec3 and vec4.
+
+vec2<T>, vec3<T> and vec4<T> derive from vec<2, T>, vec<3, T> and vec<4, T> and
+add nothing but their constructors, so they keep class template argument
+deduction (vec2 a{ 2, 3 } is a vec2<int>). Every operation is written once here
+and returns the named class for those sizes. Two to four components are stored
+as named x, y, z and w members, every other size stores a data array. vec<3, T>
+is padded to four components so it can be loaded as a whole SIMD register.
+
+All component wise operations are expanded at compile time over an index
+sequence, so there are no loops for the optimizer to unroll.
+*/
+
+namespace cml
+{
+
+namespace detail
+{
+constexpr std::size_t vec_alignment (std::size_t count, std::size_t align)
+{
+	return count == 3 ? 4 * align : (count == 2 || count == 4) ? count * align : align;
+}
+
+// Component storage of vec
+template <std::size_t N, typename T> struct vec_storage
+{
+	T data[N] = {};
+};
+
+template <typename T> struct vec_storage<2, T>
+{
+	T x = 0;
+	T y = 0;
+};
+
+template <typename T> struct vec_storage<3, T>
+{
+	T x = 0;
+	T y = 0;
+	T z = 0;
+};
+
+template <typename T> struct vec_storage<4, T>
+{
+	T x = 0;
+	T y = 0;
+	T z = 0;
+	T w = 0;
+};
+} // namespace detail
+
+template <std::size_t N, typename T = float>
+class alignas (detail::vec_alignment (N, alignof (T))) vec
+: public detail::vec_storage<N, T>,
+  public swizzles<vec<N, T>, T, static_cast<int> (N)>,
+  public detail::vector_tag
+{
+	static_assert (N > 0, "vec needs at least one component");
+	using indices = std::make_index_sequence<N>;
+	using storage = detail::vec_storage<N, T>;
+	using named = detail::named_vec<N, T>;
+
+	public:
+	using value_type = T;
+	static constexpr std::size_t size = N;
+
+	constexpr vec () noexcept {}
+
+	constexpr vec (T fill) noexcept : vec ([fill] (std::size_t) { return fill; }, indices{}) {}
+
+	template <typename... Args,
+	    typename = std::enable_if_t<sizeof...(Args) == N && (N > 1) && (std::is_convertible_v<Args, T> && ...)>>
+	constexpr vec (Args... args) noexcept : storage{ static_cast<T> (args)... }
+	{
+	}
+
+	// Builds the vector from f(0) .. f(N-1)
+	template <typename F>
+	static constexpr named generate (F f) { return named (vec (f, indices{})); }
+
+	T const* ptr () const { return &(*this)[0]; }
+
+	static T const* ptr (vec<N, T> const& v) { return v.ptr (); }
+
+	T get (int i) const
+	{
+		assert (i >= 0 && i < static_cast<int> (N));
+		return (*this)[i];
+	}
+	void set (int i, T val)
+	{
+		assert (i >= 0 && i < static_cast<int> (N));
+		(*this)[i] = val;
+	}
+
+	constexpr T& operator[] (std::size_t i)
+	{
+		if constexpr (detail::has_named_components (N))
+			return (&this->x)[i];
+		else
+			return this->data[i];
+	}
+	constexpr T const& operator[] (std::size_t i) const
+	{
+		if constexpr (detail::has_named_components (N))
+			return (&this->x)[i];
+		else
+			return this->data[i];
+	}
+
+	// ADDITIONS
+
+	constexpr named operator+ (vec<N, T> const& val) const
+	{
+		return zip (val, [] (T a, T b) { return a + b; });
+	}
+	constexpr named operator+ (T const val) const
+	{
+		return map ([val] (T a) { return a + val; });
+	}
+	constexpr void operator+= (vec<N, T> const& val) { *this = *this + val; }
+	constexpr void operator+= (T const val) { *this = *this + val; }
+
+	// SUBTRACTIONS
+
+	constexpr named operator- (vec<N, T> const& val) const
+	{
+		return zip (val, [] (T a, T b) { return a - b; });
+	}
+	constexpr named operator- (T const val) const
+	{
+		return map ([val] (T a) { return a - val; });
+	}
+	constexpr void operator-= (vec<N, T> const& val) { *this = *this - val; }
+	constexpr void operator-= (T const val) { *this = *this - val; }
+
+	// MULTIPLICATION
+
+	constexpr named operator* (vec<N, T> const& val) const
+	{
+		return zip (val, [] (T a, T b) { return a * b; });
+	}
+	constexpr named operator* (T const val) const
+	{
+		return map ([val] (T a) { return a * val; });
+	}
+	constexpr void operator*= (vec<N, T> const& val) { *this = *this * val; }
+	constexpr void operator*= (T const val) { *this = *this * val; }
+
+	// DIVISION
+
+	constexpr named operator/ (vec<N, T> const& val) const
+	{
+		return zip (val, [] (T a, T b) { return a / b; });
+	}
+	constexpr named operator/ (T const val) const
+	{
+		return map ([val] (T a) { return a / val; });
+	}
+	constexpr void operator/= (vec<N, T> const& val) { *this = *this / val; }
+	constexpr void operator/= (T const val) { *this = *this / val; }
+
+	// NEGATION
+
+	constexpr named operator- () const
+	{
+		return map ([] (T a) { return -a; });
+	}
+
+	// EQUALITY
+
+	constexpr bool operator== (vec<N, T> const& val) const { return equal (val, indices{}); }
+
+	constexpr bool operator!= (vec<N, T> const& val) const { return !(*this == val); }
+
+	// LENGTH
+	T length () const { return sqrt (mag_sqrt ()); }
+
+	static T length (vec<N, T> const& v) { return v.length (); }
+
+	// Magnitude w/o sqrt
+	constexpr T mag_sqrt () const { return sum_of_products (*this, indices{}); }
+
+	static constexpr T mag_sqrt (vec<N, T> const& v) { return v.mag_sqrt (); }
+
+	// Sum of all components
+	constexpr T sum () const { return sum (indices{}); }
+
+	// NORMALIZE
+	named norm ()
+	{
+		*this /= length ();
+		return *this;
+	}
+
+	// Applies f to every component
+	template <typename F> constexpr named map (F f) const { return map (f, indices{}); }
+
+	// Applies f to every pair of components of this and val
+	template <typename F> constexpr named zip (vec<N, T> const& val, F f) const
+	{
+		return zip (val, f, indices{});
+	}
+
+	private:
+	template <typename F, std::size_t... I>
+	constexpr vec (F f, std::index_sequence<I...>) noexcept : storage{ static_cast<T> (f (I))... }
+	{
+	}
+
+	template <typename F, std::size_t... I>
+	constexpr named map (F f, std::index_sequence<I...>) const
+	{
+		named out;
+		((detail::component<I> (out) = f (detail::component<I> (*this))), ...);
+		return out;
+	}
+
+	template <typename F, std::size_t... I>
+	constexpr named zip (vec<N, T> const& val, F f, std::index_sequence<I...>) const
+	{
+		named out;
+		((detail::component<I> (out) = f (detail::component<I> (*this), detail::component<I> (val))), ...);
+		return out;
+	}
+
+	template <std::size_t... I>
+	constexpr bool equal (vec<N, T> const& val, std::index_sequence<I...>) const
+	{
+		return ((detail::component<I> (*this) == detail::component<I> (val)) && ...);
+	}
+
+	template <std::size_t... I>
+	constexpr T sum_of_products (vec<N, T> const& val, std::index_sequence<I...>) const
+	{
+		return ((detail::component<I> (*this) * detail::component<I> (val)) + ...);
+	}
+
+	template <std::size_t... I> constexpr T sum (std::index_sequence<I...>) const
+	{
+		return (detail::component<I> (*this) + ...);
+	}
+
+	template <std::size_t M, typename U>
+	friend constexpr U dot (vec<M, U> const&, vec<M, U> const&);
+};
+
+// vec b{ 2.f, 3.f, 4.f } deduces vec<3, float>
+template <typename T, typename... U> vec (T, U...) -> vec<1 + sizeof...(U), T>;
+
+template <std::size_t N, typename T>
+constexpr detail::named_vec<N, T> operator+ (T const& val, vec<N, T> const& v)
+{
+	return v.map ([&] (T a) { return val + a; });
+}
+template <std::size_t N, typename T>
+constexpr detail::named_vec<N, T> operator- (T const& val, vec<N, T> const& v)
+{
+	return v.map ([&] (T a) { return val - a; });
+}
+template <std::size_t N, typename T>
+constexpr detail::named_vec<N, T> operator* (T const& val, vec<N, T> const& v)
+{
+	return v.map ([&] (T a) { return val * a; });
+}
+template <std::size_t N, typename T>
+constexpr detail::named_vec<N, T> operator/ (T const& val, vec<N, T> const& v)
+{
+	return v.map ([&] (T a) { return val / a; });
+}
+
+// DOT PRODUCT
+
+template <std::size_t N, typename T> constexpr T dot (vec<N, T> const& a, vec<N, T> const& b)
+{
+	return a.sum_of_products (b, std::make_index_sequence<N>{});
+}
+
+// NORMALIZE
+
+template <std::size_t N, typename T> detail::named_vec<N, T> normalize (vec<N, T> const& val)
+{
+	return val / val.length ();
+}
+
+// LINEAR INTERPOLATION
+
+template <std::size_t N, typename T>
+constexpr detail::named_vec<N, T> lerp (
+    vec<N, T> const& a, vec<N, T> const& b, vec<N, T> const& fact)
+{
+	return (static_cast<T> (1.0) - fact) * a + fact * b;
+}
+
+template <std::size_t N, typename T>
+constexpr detail::named_vec<N, T> lerp (vec<N, T> const& a, vec<N, T> const& b, T const& fact)
+{
+	return a.zip (b, [&] (T x, T y) { return (static_cast<T> (1.0) - fact) * x + fact * y; });
+}
+
+// PROJECTION
+
+template <std::size_t N, typename T>
+constexpr detail::named_vec<N, T> proj (vec<N, T> const& p, vec<N, T> const& q)
+{
+	return (q * (dot (p, q) / q.mag_sqrt ()));
+}
+
+// PERPINDICULAR
+
+template <std::size_t N, typename T>
+constexpr detail::named_vec<N, T> perp (vec<N, T> const& p, vec<N, T> const& q)
+{
+	return (p - proj (p, q));
+}
+
+// CLAMP
+
+template <std::size_t N, typename T>
+detail::named_vec<N, T> clamp (vec<N, T> min, vec<N, T> max, vec<N, T> value)
+{
+	return vec<N, T>::generate ([&] (std::size_t i) {
+		return value[i] > min[i] ? (value[i] < max[i] ? value[i] : max[i]) : min[i];
+	});
+}
+template <std::size_t N, typename T>
+detail::named_vec<N, T> clamp (vec<N, T> min, vec<N, T> max, T value)
+{
+	return min.zip (max, [value] (T lo, T hi) { return value > lo ? (value < hi ? value : hi) : lo; });
+}
+
+// MIN/MAX
+
+template <std::size_t N, typename T>
+constexpr detail::named_vec<N, T> min (vec<N, T> const& a, vec<N, T> const& b)
+{
+	return a.zip (b, [] (T x, T y) { return min (x, y); });
+}
+
+template <std::size_t N, typename T>
+constexpr detail::named_vec<N, T> max (vec<N, T> const& a, vec<N, T> const& b)
+{
+	return a.zip (b, [] (T x, T y) { return max (x, y); });
+}
+
+// DISTANCE
+
+template <std::size_t N, typename T> T distance (vec<N, T> const& v1, vec<N, T> const& v2)
+{
+	return (v2 - v1).length ();
+}
+
+// POW
+
+// base raised to the exp power
+template <std::size_t N, typename T>
+detail::named_vec<N, T> pow (vec<N, T> const& base, vec<N, T> const& exp)
+{
+	return base.zip (exp, [] (T b, T e) { return std::pow (b, e); });
+}
+
+// e to the exp power
+template <std::size_t N, typename T> detail::named_vec<N, T> exp (vec<N, T> const& exp)
+{
+	return exp.map ([] (T e) { return std::exp (e); });
+}
+
+// 2 to the exp power
+template <std::size_t N, typename T> detail::named_vec<N, T> exp2 (vec<N, T> const& exp)
+{
+	return exp.map ([] (T e) { return std::exp2 (e); });
+}
+
+// LOG
+
+// natural log of base
+template <std::size_t N, typename T> detail::named_vec<N, T> log (vec<N, T> const& base)
+{
+	return base.map ([] (T b) { return std::log (b); });
+}
+
+// log2 of base
+template <std::size_t N, typename T> detail::named_vec<N, T> log2 (vec<N, T> const& base)
+{
+	return base.map ([] (T b) { return std::log2 (b); });
+}
+
+// log10 of base
+template <std::size_t N, typename T> detail::named_vec<N, T> log10 (vec<N, T> const& base)
+{
+	return base.map ([] (T b) { return std::log10 (b); });
+}
+
+// The named vectors, classes of their own so that vec3 v{ 1.f, 2.f, 3.f } deduces vec3<float>
+
+template <typename T> class vec2 : public vec<2, T>
+{
+	public:
+	using vec<2, T>::vec;
+
+	constexpr vec2 () noexcept {}
+
+	constexpr vec2 (vec<2, T> const& v) noexcept : vec<2, T> (v) {}
+
+	static const vec2<T> one;
+	static const vec2<T> zero;
+	static const vec2<T> right;
+	static const vec2<T> left;
+	static const vec2<T> up;
+	static const vec2<T> down;
+};
+
+template <typename T> vec2 (T) -> vec2<T>;
+template <typename T> vec2 (T, T) -> vec2<T>;
+
+template <typename T> class vec3 : public vec<3, T>
+{
+	public:
+	using vec<3, T>::vec;
+
+	constexpr vec3 () noexcept {}
+
+	constexpr vec3 (vec<3, T> const& v) noexcept : vec<3, T> (v) {}
+
+	static const vec3<T> one;
+	static const vec3<T> zero;
+	static const vec3<T> right;
+	static const vec3<T> left;
+	static const vec3<T> up;
+	static const vec3<T> down;
+	static const vec3<T> forward;
+	static const vec3<T> back;
+};
+
+template <typename T> vec3 (T) -> vec3<T>;
+template <typename T> vec3 (T, T, T) -> vec3<T>;
+
+template <typename T> class vec4 : public vec<4, T>
+{
+	public:
+	using vec<4, T>::vec;
+
+	constexpr vec4 () noexcept {}
+
+	constexpr vec4 (vec<4, T> const& v) noexcept : vec<4, T> (v) {}
+
+	static const vec4<T> one;
+	static const vec4<T> zero;
+	static const vec4<T> right;
+	static const vec4<T> left;
+	static const vec4<T> up;
+	static const vec4<T> down;
+	static const vec4<T> forward;
+	static const vec4<T> back;
+	static const vec4<T> w_positive;
+	static const vec4<T> w_negative;
+};
+
+template <typename T> vec4 (T) -> vec4<T>;
+template <typename T> vec4 (T, T, T, T) -> vec4<T>;
+
+template <typename T> vec2<T> const vec2<T>::one = { 1, 1 };
+template <typename T> vec2<T> const vec2<T>::zero = { 0, 0 };
+template <typename T> vec2<T> const vec2<T>::right = { 1, 0 };
+template <typename T> vec2<T> const vec2<T>::left = { -1, 0 };
+template <typename T> vec2<T> const vec2<T>::up = { 0, 1 };
+template <typename T> vec2<T> const vec2<T>::down = { 0, -1 };
+
+template <typename T> vec3<T> const vec3<T>::one = { 1, 1, 1 };
+template <typename T> vec3<T> const vec3<T>::zero = { 0, 0, 0 };
+template <typename T> vec3<T> const vec3<T>::right = { 1, 0, 0 };
+template <typename T> vec3<T> const vec3<T>::left = { -1, 0, 0 };
+template <typename T> vec3<T> const vec3<T>::up = { 0, 1, 0 };
+template <typename T> vec3<T> const vec3<T>::down = { 0, -1, 0 };
+template <typename T> vec3<T> const vec3<T>::forward = { 0, 0, 1 };
+template <typename T> vec3<T> const vec3<T>::back = { 0, 0, -1 };
+
+template <typename T> vec4<T> const vec4<T>::one = { 1, 1, 1, 1 };
+template <typename T> vec4<T> const vec4<T>::zero = { 0, 0, 0, 0 };
+template <typename T> vec4<T> const vec4<T>::right = { 1, 0, 0, 0 };
+template <typename T> vec4<T> const vec4<T>::left = { -1, 0, 0, 0 };
+template <typename T> vec4<T> const vec4<T>::up = { 0, 1, 0, 0 };
+template <typename T> vec4<T> const vec4<T>::down = { 0, -1, 0, 0 };
+template <typename T> vec4<T> const vec4<T>::forward = { 0, 0, 1, 0 };
+template <typename T> vec4<T> const vec4<T>::back = { 0, 0, -1, 0 };
+template <typename T> vec4<T> const vec4<T>::w_positive = { 0, 0, 0, 1 };
+template <typename T> vec4<T> const vec4<T>::w_negative = { 0, 0, 0, -1 };
+
+static_assert (sizeof (vec3<float>) == 4 * sizeof (float) && alignof (vec3<float>) == 16,
+    "vec3<float> is padded to a whole SIMD register");
+static_assert (sizeof (vec4<double>) == 4 * sizeof (double), "vec<4> holds no padding");
+
+} // namespace cml
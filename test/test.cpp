@@ -1,7 +1,28 @@
 
 #include "cml/cml.h"
 #include "cml/serial.h"
+#include "cml/allocator.h"
+#include "cml/cached_mat4.h"
+#include "cml/fixed.h"
+#include "cml/rebase.h"
+#include "cml/ray.h"
+#include "cml/bvh.h"
+#include "cml/hash_grid.h"
+#include "cml/morton.h"
+#include "cml/kd_tree.h"
+#include "cml/curve.h"
+#include "cml/animation.h"
+#include "cml/obb.h"
+#include "cml/orthonormalize.h"
+#include "cml/gjk.h"
+#include "cml/convex_hull.h"
+#include "cml/rigid_body.h"
+#include "cml/particle.h"
+#include "cml/ik.h"
+#include "cml/exp_log.h"
+#include "cml/color.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 #include <string>
@@ -86,6 +107,18 @@ void test_matrix ()
 	std::cout << " mat3 inverse\n";
 	std::cout << "expected out: " << inverse_expect << "\n";
 	std::cout << "inverse output: " << inverse_input.inverse () << "\n";
+	std::cout << "mat3 inverse product identity " << (inverse_input * inverse_input.inverse ()).isIdentity ()
+	          << " should equal 1\n";
+	std::cout << "mat3 transpose " << m3a.transpose () << " should equal "
+	          << cml::mat3f (10, 4, 2, 20, 5, 3, 10, 6, 5) << "\n";
+	std::cout << "mat3 * vec3 " << m3a * cml::vec3f (1, 2, 3) << " should equal [80, 32, 23]\n";
+
+	cml::mat3d m3da = { 10, 20, 10, 4, 5, 6, 2, 3, 5 };
+	cml::mat3d m3db = { 3, 2, 4, 3, 3, 9, 4, 4, 2 };
+	std::cout << "mat3d mul " << m3da * m3db << " should equal " << m3_m_expect << "\n";
+	std::cout << "mat3d * vec3d " << m3da * cml::vec3d (1, 2, 3) << " should equal [80, 32, 23]\n";
+	std::cout << "mat3i mul " << cml::mat3i (10, 20, 10, 4, 5, 6, 2, 3, 5) * cml::mat3i (3, 2, 4, 3, 3, 9, 4, 4, 2)
+	          << " should equal " << m3_m_expect << "\n";
 }
 
 void test_quaternion ()
@@ -204,6 +237,872 @@ void test_common ()
 	std::cout << "v clamp v:" << clv << "\n";
 }
 
+void test_allocator ()
+{
+	std::cout << "\n";
+	cml::aligned_vector<cml::mat4f> mats (100);
+	std::cout << "aligned_vector mat4 aligned to 64 == "
+	          << (reinterpret_cast<std::uintptr_t> (mats.data ()) % 64 == 0) << "\n";
+
+	cml::frame_arena arena (1 << 20);
+	cml::vec3f* points = arena.allocate<cml::vec3f> (1000);
+	for (int i = 0; i < 1000; i++)
+		points[i] = cml::vec3f (static_cast<float> (i));
+	cml::arena_vector<cml::mat4f> frame_mats{ cml::arena_allocator<cml::mat4f> (arena) };
+	frame_mats.resize (64);
+	std::cout << "arena used " << arena.used () << " of " << arena.capacity () << "\n";
+	arena.reset ();
+	std::cout << "arena used after reset " << arena.used () << " should equal 0\n";
+
+	cml::pool<cml::mat4f> mat_pool (4);
+	cml::mat4f* a = mat_pool.create ();
+	cml::mat4f* b = mat_pool.create (2.f);
+	mat_pool.destroy (a);
+	cml::mat4f* c = mat_pool.create ();
+	std::cout << "pool reuses freed slot == " << (a == c) << ", live " << mat_pool.size ()
+	          << " should equal 2\n";
+	mat_pool.destroy (b);
+	mat_pool.destroy (c);
+
+	cml::pool<cml::mat4f> moved_pool (std::move (mat_pool));
+	bool empty_throws = false;
+	try
+	{
+		mat_pool.allocate ();
+	}
+	catch (std::bad_alloc const&)
+	{
+		empty_throws = true;
+	}
+	std::cout << "moved pool capacity " << moved_pool.capacity () << " " << mat_pool.capacity ()
+	          << " " << empty_throws << " should equal 4 0 1\n";
+}
+
+void test_cached_mat4 ()
+{
+	std::cout << "\n";
+	cml::mat4f rot (cml::mat3f::createRotationMatrix (30, 45, 60), cml::vec3f (1, 2, 3));
+	rot.set_row (3, cml::vec4f (0, 0, 0, 1));
+
+	cml::cached_mat4f model (cml::mat3f::createRotationMatrix (30, 45, 60), cml::vec3f (1, 2, 3));
+	std::cout << "cached kind " << static_cast<int> (model.kind ()) << " should equal 2 (rigid)\n";
+	std::cout << "unknown rotation kind " << static_cast<int> (cml::cached_mat4f (rot).kind ())
+	          << " should equal 3 (affine)\n";
+	std::cout << "rigid inverse: " << model.inverse () << "\n";
+	std::cout << "full inverse:  " << rot.inverse () << "\n";
+
+	model.scale (cml::vec3f (2, 3, 4));
+	std::cout << "cached kind " << static_cast<int> (model.kind ()) << " should equal 3 (affine)\n";
+	std::cout << "affine inverse: " << model.inverse () << "\n";
+	std::cout << "full inverse:   " << model.get ().inverse () << "\n";
+	std::cout << "det " << model.det () << " should equal " << model.get ().det () << "\n";
+
+	cml::cached_mat4f ident;
+	cml::cached_mat4f moved = ident;
+	moved.translate (cml::vec3f (1, 2, 3));
+	std::cout << "translated kind " << static_cast<int> (moved.kind ()) << " should equal 1\n";
+	std::cout << "translation kind " << static_cast<int> (cml::cached_mat4f (cml::vec3f (1, 2, 3)).kind ())
+	          << " " << static_cast<int> (cml::cached_mat4f (cml::vec3f (0, 0, 0)).kind ())
+	          << " should equal 1 0\n";
+	std::cout << "translation inverse " << moved.inverse () << "\n";
+	std::cout << "affine product: " << (moved * model).get () << "\n";
+	std::cout << "full product:   " << moved.get () * model.get () << "\n";
+
+	cml::mat4f proj;
+	proj.set_row (0, cml::vec4f (1.5f, 0, 0, 0));
+	proj.set_row (1, cml::vec4f (0, 2, 0, 0));
+	proj.set_row (2, cml::vec4f (0, 0, -1.01f, -0.2f));
+	proj.set_row (3, cml::vec4f (0, 0, -1, 0));
+	cml::cached_mat4f projection (proj);
+	float const proj_det = projection.det ();
+	projection.translate (cml::vec3f (0, 0, 3));
+	std::cout << "projective det " << proj_det << " -> " << projection.det () << " should equal "
+	          << projection.get ().det () << "\n";
+}
+
+void test_generic ()
+{
+	std::cout << "\n";
+	cml::vec<3, float> a (1.f, 2.f, 3.f);
+	cml::vec<3, float> b = cml::vec3f (4, 5, 6);
+	std::cout << "generic dot " << cml::dot (a, b) << " should equal 32\n";
+	std::cout << "generic a + b * 2 " << a + b * 2.f << "\n";
+	std::cout << "generic lerp " << cml::lerp (a, b, 0.5f) << "\n";
+	cml::vec<5, int> five (1, 2, 3, 4, 5);
+	std::cout << "vec5 sum " << five.sum () << " should equal 15\n";
+
+	cml::mat3f m3a = { 10, 20, 10, 4, 5, 6, 2, 3, 5 };
+	cml::mat3f m3b = { 3, 2, 4, 3, 3, 9, 4, 4, 2 };
+	cml::detail::mat_base<3, 3, float> const& generic_a = m3a;
+	std::cout << "generic mat3 mul " << generic_a * m3b << "\n";
+	std::cout << "should equal     " << m3a * m3b << "\n";
+	std::cout << "generic mat3 det " << cml::det (m3a) << " should equal " << m3a.det () << "\n";
+
+	cml::mat2f m2 = cml::mat2f::generate ([] (std::size_t i) { return static_cast<float> (i + 1); });
+	std::cout << "mat2 " << m2 << " inverse " << cml::inverse (m2) << "\n";
+
+	cml::mat4x3f affine; // 4 columns, 3 rows
+	affine.set_col (3, cml::vec<3, float> (1.f, 2.f, 3.f));
+	std::cout << "mat4x3 * point " << affine * cml::vec<4, float> (1.f, 1.f, 1.f, 1.f)
+	          << " should equal [2, 3, 4]\n";
+	cml::mat3x4f tall = affine.transpose ();
+	std::cout << "mat4x3 * mat3x4 " << affine * tall << "\n";
+}
+
+void test_swizzle ()
+{
+	std::cout << "\n";
+	cml::vec4f v (1, 2, 3, 4);
+	std::cout << "v.xzy " << v.xzy () << " should equal [1, 3, 2]\n";
+	std::cout << "v.wzyx " << v.wzyx () << " should equal [4, 3, 2, 1]\n";
+	std::cout << "v.swizzle<1, 1> " << v.swizzle<1, 1> () << " should equal [2, 2]\n";
+	std::cout << "p.xyzz " << cml::vec3f (1, 2, 3).xyzz () << " uv.xxyy " << cml::vec2f (5, 6).xxyy ()
+	          << " should equal [1, 2, 3, 3] [5, 5, 6, 6]\n";
+
+	cml::vec3f p (1, 2, 3);
+	p.masked<2, 0> () = cml::vec2f (7, 9);
+	std::cout << "masked write " << p << " should equal [9, 2, 7]\n";
+	p.masked<0, 1> () += cml::vec2f (1, 1);
+	std::cout << "masked add " << p << " should equal [10, 3, 7]\n";
+
+	cml::vec4f in[3] = { { 1, 2, 3, 4 }, { 5, 6, 7, 8 }, { 9, 10, 11, 12 } };
+	cml::vec3f out[3];
+	cml::swizzle<2, 1, 0> (in, out, 3);
+	std::cout << "batched swizzle " << out[0] << out[1] << out[2] << "\n";
+
+	float xs[2] = { 1, 2 }, ys[2] = { 3, 4 }, zs[2] = { 5, 6 };
+	auto zyx = cml::swizzle_soa<2, 1, 0> (std::array<float*, 3>{ xs, ys, zs });
+	std::cout << "soa swizzle first stream " << zyx[0][0] << " should equal 5\n";
+}
+
+void test_fixed ()
+{
+	std::cout << "\n";
+	using fx = cml::fixed32;
+	std::cout << "fixed sqrt(2) " << cml::sqrt (fx (2)) << " should be near 1.41421\n";
+	std::cout << "fixed sin(1) " << cml::sin (fx (1)) << " should be near " << std::sin (1.0) << "\n";
+	std::cout << "fixed cos(4) " << cml::cos (fx (4)) << " should be near " << std::cos (4.0) << "\n";
+
+	cml::vec3<fx> v (fx (3), fx (4), fx (12));
+	std::cout << "fixed vec3 length " << v.length () << " should equal 13\n";
+	std::cout << "fixed vec3 normalize " << cml::normalize (v) << "\n";
+
+	cml::quat<fx> q = cml::quat<fx>::axisAngles (cml::vec3<fx> (fx (0), fx (0), fx (1)), fx (90));
+	std::cout << "fixed quat " << q << " mag " << q.mag () << "\n";
+
+	cml::mat4<fx> m (fx (2));
+	m.set_translation (cml::vec3<fx> (fx (1), fx (2), fx (3)));
+	std::cout << "fixed mat4 * vec4 " << m * cml::vec4<fx> (fx (1), fx (1), fx (1), fx (1))
+	          << " should equal [3, 4, 5, 2]\n";
+}
+
+void test_rebase ()
+{
+	std::cout << "\n";
+	cml::vec3d origin = cml::snap_origin (cml::vec3d (1.0e7 + 3.25, -2.0e7, 5.5), 1024.0);
+	cml::vec3d world[2] = { { 1.0e7 + 3.25, -2.0e7 + 0.125, 5.5 }, { 1.0e7 + 7.0, -2.0e7, 0.0 } };
+	cml::vec3f local[2];
+	cml::rebase (world, local, 2, origin);
+	std::cout << "origin " << origin << "\n";
+	std::cout << "rebased " << local[0] << local[1] << " should equal " << cml::rebase (world[0], origin)
+	          << cml::rebase (world[1], origin) << "\n";
+
+	cml::quatf rot = cml::quatf::axisAngles (cml::vec3f (0, 0, 1), 90);
+	cml::mat4f model = cml::camera_relative_model (world[0], rot, cml::vec3f (2, 2, 2), origin);
+	std::cout << "camera relative model " << model << "\n";
+	std::cout << "x axis maps to " << model * cml::vec4f (1, 0, 0, 0) << " should equal [0, 2, 0, 0]\n";
+}
+
+void test_ray ()
+{
+	std::cout << "\n";
+	cml::rayf r (cml::vec3f (0.25f, 0.25f, -5), cml::vec3f (0, 0, 1));
+	cml::aabbf box (cml::vec3f (-1), cml::vec3f (1));
+	float t_near = 0;
+	bool box_hit = cml::intersect (r, box, 100.f, t_near);
+	std::cout << "ray box hit " << box_hit << " at " << t_near << " should equal 4\n";
+
+	float t = 0, u = 0, v = 0;
+	bool tri_hit = cml::intersect (
+	    r, cml::vec3f (0, 0, 0), cml::vec3f (1, 0, 0), cml::vec3f (0, 1, 0), 100.f, t, u, v);
+	std::cout << "ray triangle hit " << tri_hit << " at " << t << " uv " << u << ", " << v << "\n";
+
+	cml::triangle_soa tris;
+	tris.add (cml::vec3f (0, 0, 0), cml::vec3f (1, 0, 0), cml::vec3f (0, 1, 0));
+	tris.add (cml::vec3f (0, 0, -2), cml::vec3f (1, 0, -2), cml::vec3f (0, 1, -2));
+
+	cml::rayf rays[3] = { r, cml::rayf (cml::vec3f (5, 5, -5), cml::vec3f (0, 0, 1)),
+		cml::rayf (cml::vec3f (0.1f, 0.1f, 5), cml::vec3f (0, 0, -1)) };
+	cml::ray_hit hits[3];
+	cml::intersect (rays, 3, 100.f, tris, hits);
+	for (auto const& h : hits)
+		std::cout << "batched hit prim " << h.prim << " t " << h.t << "\n";
+	std::cout << "should equal prims 1, -1, 0 at t 3, -, 5\n";
+
+	cml::ray_packet<4> packet;
+	for (int l = 0; l < 3; l++)
+		packet.set (l, rays[l], 100.f);
+	std::cout << "occluded lanes " << cml::occluded (packet, tris) << " should equal 5\n";
+	cml::packet_hit<4> past_end;
+	std::cout << "empty range lanes " << cml::intersect (packet, tris, past_end, tris.size (), 1)
+	          << " should equal 0\n";
+
+	// crosses the first triangle at t 0.2 with a determinant of about 5e-8
+	cml::rayf grazing (cml::vec3f (0.25f, 0.25f, -1e-8f), cml::vec3f (1, 0, 5e-8f));
+	bool graze_hit = cml::intersect (
+	    grazing, cml::vec3f (0, 0, 0), cml::vec3f (1, 0, 0), cml::vec3f (0, 1, 0), 100.f, t, u, v);
+	cml::ray_hit graze_batch;
+	cml::intersect (&grazing, 1, 100.f, tris, &graze_batch);
+	std::cout << "grazing hit " << graze_hit << " " << graze_batch.prim << " should equal 0 -1\n";
+}
+
+void test_bvh ()
+{
+	std::cout << "\n";
+	// grid of 16 x 16 quads in the z = 0 plane, two triangles each
+	cml::triangle_soa tris;
+	for (int y = 0; y < 16; y++)
+		for (int x = 0; x < 16; x++)
+		{
+			cml::vec3f p (static_cast<float> (x), static_cast<float> (y), 0);
+			tris.add (p, p + cml::vec3f (1, 0, 0), p + cml::vec3f (0, 1, 0));
+			tris.add (p + cml::vec3f (1, 0, 0), p + cml::vec3f (1, 1, 0), p + cml::vec3f (0, 1, 0));
+		}
+
+	cml::bvh4 tree;
+	tree.build (tris);
+	cml::rayf r (cml::vec3f (3.25f, 7.25f, -5), cml::vec3f (0, 0, 1));
+	cml::ray_hit hit = tree.intersect (r, tris, 100.f);
+	cml::ray_hit brute;
+	cml::intersect (&r, 1, 100.f, tris, &brute);
+	std::cout << "bvh hit prim " << hit.prim << " t " << hit.t << " should equal " << brute.prim << " t 5\n";
+	std::cout << "bvh occluded " << tree.occluded (r, tris, 100.f) << " " << tree.occluded (r, tris, 2.f)
+	          << " should equal 1 0\n";
+
+	// move the whole grid up by 2 and refit
+	cml::triangle_soa moved = tris;
+	for (auto& z : moved.v0z)
+		z += 2;
+	tree.refit (moved);
+	std::cout << "refit hit t " << tree.intersect (r, moved, 100.f).t << " should equal 7\n";
+
+	cml::bvh8 wide;
+	cml::bvh8::build_settings settings;
+	settings.max_leaf_size = 1;
+	wide.build (tris, settings);
+	cml::rayf miss (cml::vec3f (20, 20, -5), cml::vec3f (0, 0, 1));
+	std::cout << "bvh8 hit prim " << wide.intersect (r, tris, 100.f).prim << " miss "
+	          << wide.intersect (miss, tris, 100.f).prim << " should equal " << brute.prim << " -1\n";
+
+	// degenerate input: every triangle on the same centroid, and triangles halving in size
+	// towards the origin down to denormals, which skews the binned heuristic on every level
+	cml::triangle_soa same, shrinking;
+	for (int i = 0; i < 100; i++)
+		same.add (cml::vec3f (0, 0, 0), cml::vec3f (1, 0, 0), cml::vec3f (0, 1, 0));
+	for (float x = 1.f; x > 0.f; x *= 0.5f)
+		shrinking.add (cml::vec3f (x, 0, 0), cml::vec3f (2 * x, 0, 0), cml::vec3f (x, x, 0));
+	cml::bvh<2>::build_settings narrow;
+	narrow.max_leaf_size = 1;
+	cml::bvh<2> same_tree, shrinking_tree;
+	same_tree.build (same, narrow);
+	shrinking_tree.build (shrinking, narrow);
+	cml::rayf down (cml::vec3f (0.25f, 0.25f, -1), cml::vec3f (0, 0, 1));
+	cml::rayf corner (cml::vec3f (1.25f, 0.25f, -1), cml::vec3f (0, 0, 1));
+	cml::ray_hit same_hit = same_tree.intersect (down, same, 100.f);
+	std::cout << "coincident bvh hit t " << same_hit.t << " " << (same_hit.prim >= 0)
+	          << " should equal 1 1\n";
+	std::cout << "shrinking bvh hit prim " << shrinking_tree.intersect (corner, shrinking, 100.f).prim
+	          << " of " << shrinking.size () << " should equal 0 of 150\n";
+}
+
+void test_hash_grid ()
+{
+	std::cout << "\n";
+	std::vector<cml::vec3f> points;
+	for (int z = 0; z < 10; z++)
+		for (int y = 0; y < 10; y++)
+			for (int x = 0; x < 10; x++)
+				points.push_back (cml::vec3f (x * 0.5f, y * 0.5f, z * 0.5f));
+
+	cml::hash_grid grid (1.f);
+	grid.rebuild (points.data (), points.size ());
+	cml::vec3f center (2.1f, 2.1f, 2.1f);
+	int found = 0, expected = 0;
+	for (std::uint32_t i : grid.query_radius (center, 0.8f))
+		found += (points[i] - center).mag_sqrt () <= 0.64f;
+	for (auto const& p : points)
+		expected += (p - center).mag_sqrt () <= 0.64f;
+	std::cout << "hash grid radius query found " << found << " should equal " << expected << "\n";
+
+	// tiny table so most cells collide, results must not repeat
+	cml::hash_grid small (0.5f, 4);
+	small.rebuild (points.data (), points.size (), 4);
+	cml::aabbf box (cml::vec3f (0.9f), cml::vec3f (2.1f));
+	int in_box = 0;
+	for (auto it = small.query_box (box).begin (); it != small.query_box (box).end (); ++it)
+		in_box++;
+	std::cout << "hash grid box query found " << in_box << " should equal 27\n";
+
+	// enough points for the threaded histogram, every point lands in exactly one slot
+	std::vector<cml::vec3f> cloud;
+	for (int i = 0; i < 20000; i++)
+		cloud.push_back (cml::vec3f ((i % 97) * 0.31f, (i % 89) * 0.27f, (i % 83) * 0.23f));
+	cml::hash_grid threaded (1.f);
+	threaded.rebuild (cloud.data (), cloud.size (), 4);
+	std::vector<std::uint32_t> seen (threaded.indices);
+	std::sort (seen.begin (), seen.end ());
+	bool permutation = seen.size () == cloud.size ();
+	for (std::size_t i = 0; permutation && i < seen.size (); i++)
+		permutation = seen[i] == i;
+	int near = 0, near_expected = 0;
+	for (std::uint32_t i : threaded.query_radius (center, 1.5f))
+		near += (cloud[i] - center).mag_sqrt () <= 2.25f;
+	for (auto const& p : cloud)
+		near_expected += (p - center).mag_sqrt () <= 2.25f;
+	std::cout << "threaded rebuild " << permutation << " found " << near << " should equal 1 found "
+	          << near_expected << "\n";
+}
+
+void test_morton ()
+{
+	std::cout << "\n";
+	cml::vec3i c (5, 9, 1000);
+	std::cout << "morton " << cml::morton_encode30 (cml::vec3i (1, 0, 0)) << " "
+	          << cml::morton_encode30 (cml::vec3i (0, 1, 0)) << " " << cml::morton_encode30 (cml::vec3i (0, 0, 1))
+	          << " should equal 1 2 4\n";
+	std::cout << "morton round trip " << cml::morton_decode30 (cml::morton_encode30 (c)) << " "
+	          << cml::morton_decode63 (cml::morton_encode63 (cml::vec3i (1 << 20, 3, 7))) << "\n";
+
+	// consecutive hilbert keys are always neighbouring cells
+	int jumps = 0;
+	for (std::uint32_t k = 0; k < 4096; k++)
+	{
+		cml::vec3i a = cml::hilbert_decode30 (k), b = cml::hilbert_decode30 (k + 1);
+		jumps += std::abs (a.x - b.x) + std::abs (a.y - b.y) + std::abs (a.z - b.z) != 1;
+		jumps += cml::hilbert_encode30 (a) != k;
+	}
+	std::cout << "hilbert jumps " << jumps << " should equal 0\n";
+
+	std::vector<cml::vec3f> points;
+	std::vector<int> ids;
+	for (int i = 0; i < 64; i++)
+	{
+		points.push_back (cml::vec3f ((i * 37) % 64 / 64.f, (i * 11) % 64 / 64.f, (i * 5) % 64 / 64.f));
+		ids.push_back (i);
+	}
+	cml::aabbf bounds (cml::vec3f (0), cml::vec3f (1));
+	cml::spatial_sort (points.data (), points.size (), bounds, cml::curve::hilbert, 1, ids.data ());
+	bool sorted = true;
+	for (std::size_t i = 0; i < points.size (); i++)
+	{
+		int id = ids[i];
+		sorted &= points[i] == cml::vec3f ((id * 37) % 64 / 64.f, (id * 11) % 64 / 64.f, (id * 5) % 64 / 64.f);
+		if (i > 0) sorted &= cml::hilbert_encode30 (points[i - 1], bounds) <= cml::hilbert_encode30 (points[i], bounds);
+	}
+	std::cout << "spatial sort keeps payload and key order " << sorted << " should equal 1\n";
+}
+
+void test_kd_tree ()
+{
+	std::cout << "\n";
+	std::vector<cml::vec3f> points;
+	for (int i = 0; i < 1000; i++)
+		points.push_back (cml::vec3f ((i * 37) % 101 * 0.1f, (i * 53) % 103 * 0.1f, (i * 71) % 107 * 0.1f));
+
+	cml::kd_tree tree;
+	tree.build (points, 4);
+	cml::vec3f q (5.f, 5.f, 5.f);
+	std::uint32_t index[4];
+	float dist[4];
+	tree.nearest (q, 4, index, dist);
+
+	std::vector<float> brute;
+	for (auto const& p : points)
+		brute.push_back ((p - q).mag_sqrt ());
+	std::sort (brute.begin (), brute.end ());
+	std::cout << "kd tree 4 nearest " << dist[0] << " " << dist[1] << " " << dist[2] << " " << dist[3] << "\n";
+	std::cout << "should equal      " << brute[0] << " " << brute[1] << " " << brute[2] << " " << brute[3] << "\n";
+
+	std::vector<std::uint32_t> offsets, results;
+	cml::vec3f queries[2] = { q, cml::vec3f (0) };
+	tree.radius (queries, 2, 1.5f, offsets, results);
+	std::size_t expected = 0;
+	for (auto const& p : points)
+		expected += (p - q).mag_sqrt () <= 2.25f;
+	for (auto const& p : points)
+		expected += p.mag_sqrt () <= 2.25f;
+	std::cout << "kd tree radius results " << results.size () << " should equal " << expected << "\n";
+}
+
+void test_curve ()
+{
+	std::cout << "\n";
+	cml::vec3f p0 (0, 0, 0), p1 (1, 2, 0), p2 (3, 2, 0), p3 (4, 0, 0);
+	auto bez = cml::cubic<cml::vec3f>::bezier (p0, p1, p2, p3);
+	std::cout << "bezier ends " << bez (0) << " " << bez (1) << " should equal [0, 0, 0] [4, 0, 0]\n";
+	std::cout << "catmull rom at 0, 1 " << cml::catmull_rom (p0, p1, p2, p3, 0.f) << " "
+	          << cml::catmull_rom (p0, p1, p2, p3, 1.f) << " should equal " << p1 << " " << p2 << "\n";
+
+	cml::vec3f samples[5];
+	bez.sample (5, samples);
+	std::cout << "forward differenced " << samples[2] << " should equal " << bez (0.5f) << "\n";
+
+	// control points bunched at the start, constant speed samples are still evenly spaced
+	auto line = cml::cubic<float>::bezier (0.f, 0.f, 0.f, 9.f);
+	cml::arc_length_table<float> table (line, 256);
+	float even[4];
+	table.sample_constant_speed (line, 4, even);
+	std::cout << "arc length " << table.length () << " samples " << even[0] << " " << even[1] << " " << even[2]
+	          << " " << even[3] << " should be close to 9, 0 3 6 9\n";
+
+	cml::quatf keys[4] = { cml::quatf::identity, cml::quatf::axisAngles (0, 0, 1, 90),
+		cml::quatf::axisAngles (0, 0, 1, 180), cml::quatf::axisAngles (0, 0, 1, 270) };
+	std::cout << "squad at key 1 " << cml::squad (keys, 4, 1.f) << " should equal " << keys[1] << "\n";
+	std::cout << "squad between keys 1 and 2 " << cml::squad (keys, 4, 1.5f) << " should equal "
+	          << cml::quatf::axisAngles (0, 0, 1, 135) << "\n";
+	std::cout << "rotate x by 90 around z " << cml::quatf::rotate (cml::vec3f (1, 0, 0), keys[1])
+	          << " should equal [0, 1, 0]\n";
+}
+
+void test_animation ()
+{
+	std::cout << "\n";
+	cml::clip walk (2);
+	for (int k = 0; k <= 10; k++)
+	{
+		float time = k * 0.1f;
+		walk.translation[0].add_key (time, cml::vec3f (static_cast<float> (k), 0, 0));
+		walk.rotation[1].add_key (time, cml::quatf::axisAngles (0, 0, 1, k * 9.f));
+	}
+
+	std::uint32_t cursor = 0;
+	cml::vec3f t = cml::sample (walk.translation[0], 0.25f, cursor);
+	std::cout << "track sample " << t << " cursor " << cursor << " should equal [2.5, 0, 0] cursor 2\n";
+	cml::sample (walk.translation[0], 0.31f, cursor);
+	std::cout << "cursor after stepping " << cursor << " should equal 3\n";
+
+	cml::clip_cursor state;
+	cml::pose out;
+	cml::sample (walk, 0.55f, state, out);
+	std::cout << "pose translation " << out.translation[0] << " should equal [5.5, 0, 0]\n";
+	std::cout << "pose rotation " << out.rotation[1] << " should equal " << cml::quatf::axisAngles (0, 0, 1, 49.5f)
+	          << "\n";
+	std::cout << "pose scale " << out.scale[1] << " should equal [1, 1, 1]\n";
+}
+
+void test_trs ()
+{
+	std::cout << "\n";
+	cml::vec3f t (1, 2, 3), s (2, 3, 4);
+	cml::quatf r = cml::quatf::axisAngles (cml::normalize (cml::vec3f (1, 1, 0)), 120);
+	cml::mat4f m = cml::compose_trs (t, r, s);
+	// reference from the quaternion rotating each basis vector, not from compose_trs
+	cml::mat4f rotation;
+	rotation.set_col (0, cml::to_vec4 (cml::quatf::rotate (cml::vec3f (1, 0, 0), r)));
+	rotation.set_col (1, cml::to_vec4 (cml::quatf::rotate (cml::vec3f (0, 1, 0), r)));
+	rotation.set_col (2, cml::to_vec4 (cml::quatf::rotate (cml::vec3f (0, 0, 1), r)));
+	cml::mat4f reference = cml::mat4f ().set_translation (t) * rotation * cml::mat4f ().set_scale (s);
+	std::cout << "compose trs " << m << "\nshould equal " << reference << "\n";
+	// 120 degrees around (1, 1, 0) takes x to (0.25, 0.75, -sqrt (3/8)), then scale by 2 and move by t
+	std::cout << "trs point " << m * cml::vec4f (1, 0, 0, 1) << " should equal [1.5, 3.5, 1.77526, 1]\n";
+
+	cml::trs<float> parts = cml::decompose_trs (m);
+	std::cout << "decompose trs " << parts.translation << " " << parts.rotation << " " << parts.scale << "\n";
+	std::cout << "should equal  " << t << " " << r << " " << s << "\n";
+
+	cml::mat4f mirrored = cml::compose_trs (t, r, cml::vec3f (-2, 3, 4));
+	std::cout << "mirrored round trip " << cml::compose_trs (cml::decompose_trs (mirrored)) << "\nshould equal "
+	          << mirrored << "\n";
+}
+
+void test_normal_matrix ()
+{
+	std::cout << "\n";
+	cml::quatf r = cml::quatf::axisAngles (cml::vec3f (0, 0, 1), 30);
+	cml::mat4f m = cml::compose_trs (cml::vec3f (1, 2, 3), r, cml::vec3f (1, 2, 4));
+	cml::mat4f inv_t = m.inverse ().transpose ();
+	cml::mat3f reference (inv_t.at (0, 0), inv_t.at (0, 1), inv_t.at (0, 2), inv_t.at (1, 0), inv_t.at (1, 1),
+	    inv_t.at (1, 2), inv_t.at (2, 0), inv_t.at (2, 1), inv_t.at (2, 2));
+	std::cout << "normal matrix " << cml::normal_matrix (m) << "\nshould equal  " << reference << "\n";
+
+	cml::mat4f uniform = cml::compose_trs (cml::vec3f (1, 2, 3), r, cml::vec3f (3));
+	std::cout << "uniform shortcut " << cml::uniform_normal_matrix (uniform) << "\nshould equal     "
+	          << cml::normal_matrix (uniform) << "\n";
+
+	cml::mat4f batch[10];
+	cml::mat3f normals[10];
+	for (int i = 0; i < 10; i++)
+		batch[i] = cml::compose_trs (cml::vec3f (0), r, cml::vec3f (1, 2, static_cast<float> (i + 1)));
+	cml::normal_matrix (batch, normals, 10);
+	std::cout << "batched normal matrix 9 " << normals[9] << "\nshould equal            "
+	          << cml::normal_matrix (batch[9]) << "\n";
+}
+
+void test_obb ()
+{
+	std::cout << "\n";
+	cml::mat3f sym (4, 1, 2, 1, 3, 0, 2, 0, 5);
+	cml::vec3f values;
+	cml::mat3f vectors;
+	cml::eigen_symmetric (sym, values, vectors);
+	for (int i = 0; i < 3; i++)
+	{
+		cml::vec3f v (vectors.at (0, i), vectors.at (1, i), vectors.at (2, i));
+		cml::vec3f mv (dot (cml::vec3f (4, 1, 2), v), dot (cml::vec3f (1, 3, 0), v), dot (cml::vec3f (2, 0, 5), v));
+		std::cout << "A v" << i << " " << mv << " should equal lambda v " << v * values.get (i) << "\n";
+	}
+
+	// box of half extents 4, 2, 1 rotated about z, sampled on its corners and a grid inside
+	cml::quatf r = cml::quatf::axisAngles (cml::vec3f (0, 0, 1), 30);
+	cml::mat4f m = cml::compose_trs (cml::vec3f (10, 20, 30), r, cml::vec3f (1));
+	std::vector<cml::vec3f> points;
+	for (int x = -4; x <= 4; x++)
+		for (int y = -2; y <= 2; y++)
+			for (int z = -1; z <= 1; z++)
+			{
+				cml::vec4f p = m * cml::vec4f (static_cast<float> (x), static_cast<float> (y), static_cast<float> (z), 1);
+				points.push_back (cml::vec3f (p.x, p.y, p.z));
+			}
+
+	cml::moments<float> serial;
+	for (auto const& p : points)
+		serial.add (p);
+	cml::moments<float> threaded = cml::compute_moments (points.data (), points.size (), 4);
+	std::cout << "mean " << threaded.mean << " should equal " << serial.mean << "\n";
+	std::cout << "covariance " << threaded.covariance () << "\nshould equal " << serial.covariance () << "\n";
+
+	cml::obb<float> box = cml::fit_obb (points.data (), points.size ());
+	std::cout << "obb center " << box.center << " should equal (10, 20, 30)\n";
+	std::cout << "obb half extents " << box.half_extent << " should equal (4, 2, 1)\n";
+	std::cout << "obb volume " << box.volume () << " should equal 64\n";
+	bool inside = true;
+	for (auto const& p : points)
+		inside = inside && box.contains (p, 1e-4f);
+	std::cout << "obb contains all points " << inside << " should equal 1\n";
+}
+
+void test_orthonormalize ()
+{
+	std::cout << "\n";
+	cml::mat3f rot = cml::mat3f::createRotationMatrix (30, 45, 60);
+	cml::mat3f drifted = rot;
+	for (int i = 0; i < 9; i++)
+		drifted.data[i] += 0.01f * static_cast<float> ((i * 7) % 5 - 2);
+
+	cml::mat3f polar = cml::polar_rotation (drifted);
+	std::cout << "polar rotation R^T R " << polar.transpose () * polar << " should equal identity\n";
+	std::cout << "polar rotation of a rotation " << cml::polar_rotation (rot) << "\nshould equal " << rot << "\n";
+
+	cml::mat3f stretched = rot * cml::mat3f (2, 0, 0, 0, 3, 0, 0, 0, 4);
+	cml::mat3f r, s;
+	cml::polar_decomposition (stretched, r, s);
+	std::cout << "polar factors " << r << " " << s << "\nshould equal " << rot << " [2, 0, 0, 0, 3, 0, 0, 0, 4]\n";
+
+	cml::mat3f batch[10], batch_out[10];
+	for (int i = 0; i < 10; i++)
+		batch[i] = i == 9 ? stretched : drifted;
+	cml::polar_rotation (batch, batch_out, 10);
+	std::cout << "batched polar " << batch_out[0] << " " << batch_out[9] << "\nshould equal  " << polar << " "
+	          << r << "\n";
+
+	cml::mat3f gram = cml::orthonormalize (drifted);
+	std::cout << "gram schmidt R^T R " << gram.transpose () * gram << " should equal identity\n";
+
+	cml::quatf quats[6];
+	for (int i = 0; i < 6; i++)
+		quats[i] = cml::quatf::axisAngles (cml::vec3f (1, 2, 3), 20.f * static_cast<float> (i)) *
+		           (i % 2 == 0 ? 1.0003f : 1.7f);
+	cml::renormalize (quats, 6);
+	for (int i = 0; i < 6; i++)
+		std::cout << "renormalized length " << quats[i].mag () << " should equal 1\n";
+}
+
+void test_gjk ()
+{
+	std::cout << "\n";
+	cml::sphere a{ cml::vec3f (0, 0, 0), 1.f };
+	cml::sphere b{ cml::vec3f (3, 0, 0), 1.f };
+	cml::gjk_result apart = cml::gjk_distance (a, b);
+	std::cout << "sphere distance " << apart.distance << " should equal 1\n";
+	std::cout << "closest points " << apart.point_a << " " << apart.point_b << " should equal [1, 0, 0] [2, 0, 0]\n";
+
+	cml::obb<float> box;
+	box.center = cml::vec3f (0, 2.5f, 0);
+	box.half_extent = cml::vec3f (1, 1, 1);
+	cml::capsule cap{ cml::vec3f (-2, 0, 0), cml::vec3f (2, 0, 0), 0.5f };
+	std::cout << "box capsule distance " << cml::gjk_distance (box, cap).distance << " should equal 1\n";
+
+	// cube corners as a point span
+	std::vector<cml::vec3f> corners;
+	for (int i = 0; i < 8; i++)
+		corners.push_back (cml::vec3f (i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f));
+	for (int i = 0; i < 12; i++)
+		corners.push_back (cml::vec3f (0.5f, 0.25f, -0.5f) * static_cast<float> (i % 3 - 1));
+	cml::convex_points hull{ corners.data (), corners.size () };
+	std::cout << "hull support " << cml::support (hull, cml::vec3f (1, -2, 3)) << " should equal [1, -1, 1]\n";
+
+	cml::sphere touching{ cml::vec3f (1.5f, 0, 0), 1.f };
+	cml::penetration pen = cml::gjk_epa (hull, touching);
+	std::cout << "hull sphere overlap " << pen.overlap << " should equal 1\n";
+	std::cout << "penetration depth " << pen.depth << " should equal 0.5\n";
+	std::cout << "penetration normal " << pen.normal << " should equal [1, 0, 0]\n";
+
+	cml::penetration spheres = cml::gjk_epa (a, cml::sphere{ cml::vec3f (0, 1.5f, 0), 1.f });
+	std::cout << "sphere penetration " << spheres.depth << " " << spheres.normal << " should equal 0.5 [0, 1, 0]\n";
+
+	cml::gjk_cache cache;
+	bool first = cml::gjk_overlap (a, b, &cache);
+	cml::gjk_result again = cml::gjk_distance (a, cml::sphere{ cml::vec3f (3.01f, 0, 0), 1.f }, &cache);
+	std::cout << "cached overlap " << first << " " << cml::gjk_overlap (a, b, &cache) << " should equal 0 0\n";
+	std::cout << "warm started distance " << again.distance << " should equal 1.01\n";
+}
+
+void test_convex_hull ()
+{
+	std::cout << "\n";
+	// cube corners with points inside and on the faces
+	std::vector<cml::vec3f> points;
+	for (int x = -1; x <= 1; x++)
+		for (int y = -1; y <= 1; y++)
+			for (int z = -1; z <= 1; z++)
+				points.push_back (cml::vec3f (static_cast<float> (x), static_cast<float> (y), static_cast<float> (z)));
+	cml::convex_hull<float> cube = cml::quickhull (points);
+	std::cout << "cube hull " << cube.vertices.size () << " " << cube.face_count () << " should equal 8 12\n";
+
+	std::vector<cml::vec3f> cloud;
+	for (int i = 0; i < 100000; i++)
+		cloud.push_back (cml::vec3f ((i * 37) % 101 * 0.02f - 1.f, (i * 53) % 103 * 0.02f - 1.f, (i * 71) % 107 * 0.02f - 1.f));
+	cml::convex_hull<float> serial = cml::quickhull (cloud);
+	cml::convex_hull<float> threaded = cml::quickhull (cloud, 4);
+	float outside = 0;
+	for (auto const& plane : serial.planes)
+		for (std::size_t i = 0; i < cloud.size (); i += 7)
+			outside = std::max (outside, dot (cml::vec3f (plane.x, plane.y, plane.z), cloud[i]) + plane.w);
+	std::cout << "points outside " << (outside < 1e-5f) << " should equal 1\n";
+	std::cout << "euler characteristic " << serial.vertices.size () + serial.face_count () - serial.face_count () * 3 / 2
+	          << " should equal 2\n";
+	std::cout << "threaded hull " << (threaded.vertices == serial.vertices) << " should equal 1\n";
+
+	// repeated builds in one arena, which is rewound after each
+	cml::frame_arena scratch (cml::quickhull_scratch_size<float> (cloud.size ()));
+	cml::convex_hull<float> reused;
+	cml::quickhull (points.data (), points.size (), scratch, reused);
+	cml::quickhull (cloud.data (), cloud.size (), scratch, reused);
+	std::cout << "arena hull " << (reused.vertices == serial.vertices) << " " << scratch.used ()
+	          << " should equal 1 0\n";
+
+	std::vector<cml::vec3f> flat{ cml::vec3f (0, 0, 0), cml::vec3f (1, 0, 0), cml::vec3f (0, 1, 0), cml::vec3f (1, 1, 0) };
+	std::cout << "flat hull " << cml::quickhull (flat).empty () << " should equal 1\n";
+}
+
+void test_rigid_body ()
+{
+	std::cout << "\n";
+	cml::rigid_bodies bodies;
+	cml::quat<float> const identity (0, 0, 0, 1);
+	// falling and static bodies, the last one past the groups of four
+	for (int i = 0; i < 5; i++)
+		bodies.add (cml::vec3f (0.f), identity, i == 2 ? 0.f : 1.f, cml::vec3f (1.f));
+	for (int i = 0; i < 10; i++)
+		cml::integrate (bodies, 0.1f, cml::vec3f (0, -10, 0), cml::integrator::rk2);
+	std::cout << "rk2 fall " << bodies.position (0) << " should equal [0, -5, 0]\n";
+	std::cout << "scalar fall " << bodies.position (4) << " should equal [0, -5, 0]\n";
+	std::cout << "static " << bodies.position (2) << " should equal [0, 0, 0]\n";
+
+	cml::rigid_bodies spin;
+	for (int i = 0; i < 5; i++)
+		spin.add (cml::vec3f (0.f), identity, 1.f, cml::vec3f (1.f), cml::vec3f (0.f), cml::vec3f (0, 0, 3.14159265f));
+	for (int i = 0; i < 100; i++)
+		cml::integrate (spin, 0.01f, cml::vec3f (0.f));
+	for (std::size_t i : { std::size_t (0), std::size_t (4) })
+	{
+		cml::vec3f turned = cml::quat<float>::rotate (cml::vec3f (1, 0, 0), spin.orientation (i));
+		std::cout << "half turn " << ((turned - cml::vec3f (-1, 0, 0)).length () < 1e-3f) << " should equal 1\n";
+		std::cout << "unit orientation " << (std::fabs (spin.orientation (i).magSqrd () - 1.f) < 1e-6f)
+		          << " should equal 1\n";
+	}
+
+	cml::rigid_bodies euler;
+	euler.add (cml::vec3f (0.f), identity, 2.f, cml::vec3f (1.f, 2.f, 4.f));
+	for (int i = 0; i < 10; i++)
+	{
+		euler.add_force (0, cml::vec3f (0, 0, 4));
+		cml::integrate (euler, 0.1f, cml::vec3f (0.f));
+	}
+	std::cout << "euler push " << euler.position (0).z << " should equal 1.1\n";
+
+	// a quarter turn around z swaps the x and y moments
+	float const s = std::sqrt (0.5f);
+	euler.add (cml::vec3f (0.f), cml::quat<float> (0, 0, s, s), 1.f, cml::vec3f (1.f, 2.f, 4.f));
+	cml::mat3<float> const& inertia = euler.inv_inertia[1];
+	std::cout << "world inverse inertia " << inertia.at (0, 0) << " " << inertia.at (1, 1) << " " << inertia.at (2, 2)
+	          << " should equal 0.5 1 0.25\n";
+	euler.add_torque (1, cml::vec3f (0, 0, 2));
+	cml::integrate (euler, 1.f, cml::vec3f (0.f));
+	std::cout << "torque " << euler.angular_velocity (1) << " should equal [0, 0, 0.5]\n";
+}
+
+void test_particle ()
+{
+	std::cout << "\n";
+	cml::particle_system particles;
+	cml::particle_params params;
+	params.gravity = cml::vec3f (0, -10, 0);
+	params.start_color = cml::vec4f (1, 0, 0, 1);
+	params.end_color = cml::vec4f (0, 0, 1, 0);
+	params.start_size = 2.f;
+	params.end_size = 0.f;
+	// every third particle dies after the first step, the rest live for a while
+	for (int i = 0; i < 21; i++)
+		particles.emit (cml::vec3f (static_cast<float> (i), 0, 0), cml::vec3f (0.f), i % 3 == 0 ? 0.05f : 1.f);
+	cml::update (particles, params, 0.1f);
+	std::cout << "survivors " << particles.size () << " should equal 14\n";
+	std::cout << "order " << particles.position (0).x << " " << particles.position (13).x << " should equal 1 20\n";
+	std::cout << "fall " << particles.velocity (13) << " should equal [0, -1, 0]\n";
+
+	params.drag = 1.f;
+	cml::update (particles, params, 0.1f);
+	std::cout << "drag " << particles.velocity (5).y << " should equal -1.81818\n";
+
+	cml::aligned_vector<cml::particle_vertex> vertices (particles.size ());
+	cml::write_vertices (particles, params, vertices.data ());
+	cml::particle_vertex const& v = vertices[13];
+	std::cout << "vertex " << v.x << " " << v.size << " " << v.r << " " << v.b << " " << v.a
+	          << " should equal 20 1.6 0.8 0.2 0.8\n";
+
+	// two full batches through the flow field, checked against the one particle update
+	cml::particle_system swirl;
+	params.curl_strength = 3.f;
+	params.curl_frequency = 0.37f;
+	for (int i = 0; i < 16; i++)
+	{
+		float const f = static_cast<float> (i);
+		swirl.emit (cml::vec3f (f * 0.61f - 4.f, f * 0.29f, 2.f - f * 0.43f), cml::vec3f (1.f, f * 0.1f, -0.5f), 10.f);
+	}
+	cml::particle_system reference = swirl;
+	float const damp = 1.f / (1.f + params.drag * 0.1f);
+	for (std::size_t i = 0; i < reference.size (); i++)
+		cml::detail::update_particle (reference, params, 0.1f, damp, i, i);
+	cml::update (swirl, params, 0.1f);
+	float curl_error = 0.f;
+	for (std::size_t i = 0; i < swirl.size (); i++)
+		curl_error = std::max ({ curl_error, (swirl.position (i) - reference.position (i)).length (),
+		    (swirl.velocity (i) - reference.velocity (i)).length () });
+	std::cout << "curl batch " << swirl.size () << " " << (curl_error < 1e-5f) << " should equal 16 1\n";
+}
+
+void test_ik ()
+{
+	std::cout << "\n";
+	cml::quat<float> const arc = cml::from_to_rotation (cml::vec3f (2, 0, 0), cml::vec3f (0, 3, 0));
+	cml::vec3f turned = cml::quat<float>::rotate (cml::vec3f (1, 0, 0), arc);
+	std::cout << "from to " << turned << " should equal [0, 1, 0]\n";
+
+	// an arm along y, elbow bending towards +z
+	cml::vec3f arm[3] = { cml::vec3f (0, 0, 0), cml::vec3f (0, 1, 0), cml::vec3f (0, 2, 0) };
+	cml::quat<float> arm_rotations[3];
+	bool reach = cml::two_bone_ik (arm, arm_rotations, cml::vec3f (1, 1, 0), cml::vec3f (0, 0, 5));
+	std::cout << "two bone " << reach << " " << arm[2] << " should equal 1 [1, 1, 0]\n";
+	std::cout << "elbow " << arm[1] << " should equal [0.5, 0.5, 0.707107]\n";
+	cml::vec3f forearm = cml::quat<float>::rotate (cml::vec3f (0, 1, 0), arm_rotations[1]);
+	std::cout << "forearm rotation " << ((forearm - (arm[2] - arm[1])).length () < 1e-5f) << " should equal 1\n";
+
+	cml::vec3f const target (2, 2, 1);
+	for (cml::ik_solver solver : { cml::ik_solver::ccd, cml::ik_solver::fabrik })
+	{
+		cml::vec3f chain[5];
+		cml::quat<float> rotations[5];
+		for (int i = 0; i < 5; i++)
+			chain[i] = cml::vec3f (0, static_cast<float> (i), 0);
+		cml::ik_chain const whole{ 0, 5 };
+		std::size_t reached = cml::solve_ik (solver, chain, rotations, nullptr, &whole, &target, 1);
+		std::cout << "solved " << reached << " " << ((chain[4] - target).length () < 1e-3f) << " should equal 1 1\n";
+		std::cout << "bone length " << (chain[3] - chain[2]).length () << " should equal 1\n";
+	}
+
+	// a straight chain with stiff joints can not bend back to its root
+	float const limits[4] = { -1.f, 0.9f, 0.9f, -1.f };
+	cml::vec3f stiff[4];
+	cml::quat<float> stiff_rotations[4];
+	for (int i = 0; i < 4; i++)
+		stiff[i] = cml::vec3f (0, static_cast<float> (i), 0);
+	bool stiff_reached = cml::fabrik_ik (stiff, stiff_rotations, limits, 4, cml::vec3f (0.5f, 0, 0));
+	float bend = cml::dot (cml::normalize (stiff[1] - stiff[0]), cml::normalize (stiff[2] - stiff[1]));
+	std::cout << "limited " << stiff_reached << " " << (bend > 0.8999f) << " should equal 0 1\n";
+}
+
+void test_exp_log ()
+{
+	std::cout << "\n";
+	std::cout << "exp2 " << cml::exp2 (cml::vec3f (1, 2, -1)) << " should equal [2, 4, 0.5]\n";
+	cml::vec3f const fast = cml::exp2 (cml::vec3f (1, 2, -1), cml::precision::fast);
+	std::cout << "fast exp2 " << ((fast - cml::vec3f (2, 4, 0.5f)).length () < 1e-3f) << " should equal 1\n";
+	std::cout << "exp " << cml::exp (1.f, cml::precision::accurate) << " should equal 2.71828\n";
+	std::cout << "log2 " << cml::log2 (cml::vec4f (8, 0.25f, 1, 1024), cml::precision::accurate)
+	          << " should equal [3, -2, 0, 10]\n";
+	cml::vec2f const e (1, 2.7182818f);
+	std::cout << "log " << cml::log (e, cml::precision::accurate) << " should equal [0, 1]\n";
+	std::cout << "pow " << cml::pow (cml::vec3f (4, 9, 2), cml::vec3f (0.5f, 1.5f, 0), cml::precision::accurate)
+	          << " should equal [2, 27, 1]\n";
+	std::cout << "whole pow " << cml::pow (cml::vec3f (-2, 3, 0.5f), 3.f, cml::precision::fast)
+	          << " should equal [-8, 27, 0.125]\n";
+	float const inf = std::numeric_limits<float>::infinity ();
+	cml::vec3f const odd_exponents (std::nanf (""), inf, -inf);
+	std::cout << "pow of one " << cml::pow (cml::vec3f (1.f), odd_exponents, cml::precision::fast) << " "
+	          << cml::pow (1.f, odd_exponents.x, cml::precision::accurate) << " should equal [1, 1, 1] 1\n";
+	std::cout << "log2 0 " << cml::log2 (0.f, cml::precision::accurate) << " should equal -inf\n";
+	std::cout << "exp2 200 " << cml::exp2 (200.f, cml::precision::accurate) << " should equal inf\n";
+
+	// arrays with a tail past the groups of four
+	float x[7], gamma[7];
+	for (int i = 0; i < 7; i++)
+		x[i] = static_cast<float> (i) * 0.25f;
+	cml::pow (x, gamma, 7, 2.2f);
+	float worst = 0.f;
+	for (int i = 0; i < 7; i++)
+		worst = std::max (worst, std::fabs (gamma[i] - std::pow (x[i], 2.2f)));
+	std::cout << "gamma " << (worst < 1e-5f) << " should equal 1\n";
+	cml::log2 (x, gamma, 7, cml::precision::fast);
+	std::cout << "fast log2 " << (std::fabs (gamma[6] - 0.5849625f) < 1e-4f) << " should equal 1\n";
+}
+
+void test_color ()
+{
+	std::cout << "\n";
+	std::cout << "srgb round trip " << cml::linear_to_srgb (cml::srgb_to_linear (0.5f))
+	          << " should equal 0.5\n";
+	std::cout << "srgb8 " << int (cml::linear_to_srgb8 (0.5f)) << " should equal 188\n";
+	std::uint32_t const red_blue = cml::pack_rgba8 (cml::vec4f (1, 0, 0.5f, 1));
+	std::cout << "pack rgba8 " << std::hex << red_blue << std::dec << " should equal ff8000ff\n";
+	std::cout << "hsv " << cml::rgb_to_hsv (cml::vec3f (0, 1, 0))
+	          << " should equal [0.333333, 1, 1]\n";
+	std::cout << "ycocg " << cml::ycocg_to_rgb (cml::rgb_to_ycocg (cml::vec3f (0.2f, 0.4f, 0.6f)))
+	          << " should equal [0.2, 0.4, 0.6]\n";
+	std::cout << "white luminance " << (cml::srgb_to_xyz_matrix * cml::vec3f (1, 1, 1)).y
+	          << " should equal 1\n";
+
+	// spans with a tail past the groups of four
+	cml::vec4f pixels[7], linear[7], back[7];
+	for (int i = 0; i < 7; i++)
+	{
+		float const t = static_cast<float> (i) / 6.f;
+		pixels[i] = cml::vec4f (t, 0.5f, 1.f - t, 0.25f);
+	}
+	cml::srgb_to_linear (pixels, linear, 7);
+	cml::linear_to_srgb (linear, back, 7, cml::precision::fast);
+	float worst = 0.f;
+	for (int i = 0; i < 7; i++)
+		worst = std::max (worst, (back[i] - pixels[i]).length ());
+	std::cout << "srgb span " << (worst < 1e-3f) << " " << back[6].w << " should equal 1 0.25\n";
+	cml::rgb_to_hsv (pixels, linear, 7);
+	cml::hsv_to_rgb (linear, back, 7);
+	std::cout << "hsv span " << back[6] << " should equal " << pixels[6] << "\n";
+	std::uint32_t packed[7];
+	cml::pack_rgba8 (pixels, packed, 7);
+	bool const same = packed[6] == cml::pack_rgba8 (pixels[6]);
+	std::cout << "packed span " << same << " should equal 1\n";
+}
+
 int main ()
 {
 	test_vector ();
@@ -212,6 +1111,30 @@ int main ()
 	test_transform ();
 	test_constants ();
 	test_common ();
+	test_allocator ();
+	test_cached_mat4 ();
+	test_generic ();
+	test_swizzle ();
+	test_fixed ();
+	test_rebase ();
+	test_ray ();
+	test_bvh ();
+	test_hash_grid ();
+	test_morton ();
+	test_kd_tree ();
+	test_curve ();
+	test_animation ();
+	test_trs ();
+	test_normal_matrix ();
+	test_obb ();
+	test_orthonormalize ();
+	test_gjk ();
+	test_convex_hull ();
+	test_rigid_body ();
+	test_particle ();
+	test_ik ();
+	test_exp_log ();
+	test_color ();
 
 
 	// std::cout << "Press any key to continue..." << "\n";
@@ -1,4 +1,24 @@
 #include "cml/cml.h"
 #include "cml/serial.h"
+#include "cml/allocator.h"
+#include "cml/cached_mat4.h"
+#include "cml/fixed.h"
+#include "cml/rebase.h"
+#include "cml/ray.h"
+#include "cml/bvh.h"
+#include "cml/hash_grid.h"
+#include "cml/morton.h"
+#include "cml/kd_tree.h"
+#include "cml/curve.h"
+#include "cml/animation.h"
+#include "cml/obb.h"
+#include "cml/orthonormalize.h"
+#include "cml/gjk.h"
+#include "cml/convex_hull.h"
+#include "cml/rigid_body.h"
+#include "cml/particle.h"
+#include "cml/ik.h"
+#include "cml/exp_log.h"
+#include "cml/color.h"
 
 void test_make_sure_no_odr_violations () { int a = 2 + 3; }
\ No newline at end of file